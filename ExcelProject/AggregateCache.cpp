@@ -0,0 +1,72 @@
+#include <algorithm>
+
+#include "AggregateCache.h"
+
+AggregateCache::AggregateCache(size_t blocks){
+    leaves_ = 1;
+    while(leaves_ < blocks){
+        leaves_ *= 2;
+    }
+    nodes_.resize(2 * leaves_);
+}
+
+void AggregateCache::combine(size_t node){
+    Node parent;
+    add(nodes_[2 * node], parent.summary, parent.errors);
+    add(nodes_[2 * node + 1], parent.summary, parent.errors);
+    nodes_[node] = parent;
+}
+
+void AggregateCache::add(const Node& node, AggregateKernels::Summary& summary, size_t& errors){
+    summary.sum += node.summary.sum;
+    summary.min = std::min(summary.min, node.summary.min);
+    summary.max = std::max(summary.max, node.summary.max);
+    summary.count += node.summary.count;
+    errors += node.errors;
+}
+
+void AggregateCache::reserve(size_t blocks){
+    if(blocks <= leaves_){
+        return;
+    }
+    size_t leaves = leaves_;
+    while(leaves < blocks){
+        leaves *= 2;
+    }
+    std::vector<Node> nodes(2 * leaves);
+    std::copy(nodes_.begin() + leaves_, nodes_.end(), nodes.begin() + leaves);
+    nodes_.swap(nodes);
+    leaves_ = leaves;
+    for(size_t node = leaves_ - 1; node >= 1; node--){
+        combine(node);
+    }
+}
+
+void AggregateCache::setBlock(size_t block, const AggregateKernels::Summary& summary, bool error){
+    size_t node = leaves_ + block;
+    nodes_[node].summary = summary;
+    nodes_[node].errors = error;
+    for(node /= 2; node >= 1; node /= 2){
+        combine(node);
+    }
+}
+
+void AggregateCache::summarize(size_t fromBlock, size_t toBlock, AggregateKernels::Summary& summary, bool& error) const{
+    // the blocks are not in one subtree in general, so the nodes covering them are collected from both ends
+    size_t errors = 0;
+    for(size_t left = leaves_ + fromBlock, right = leaves_ + toBlock + 1; left < right; left /= 2, right /= 2){
+        if(left & 1){
+            add(nodes_[left], summary, errors);
+            left++;
+        }
+        if(right & 1){
+            right--;
+            add(nodes_[right], summary, errors);
+        }
+    }
+    error = error || errors > 0;
+}
+
+size_t AggregateCache::bytes() const{
+    return nodes_.capacity() * sizeof(Node);
+}
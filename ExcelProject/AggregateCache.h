@@ -0,0 +1,80 @@
+#ifndef AGGREGATE_CACHE_H
+#define AGGREGATE_CACHE_H
+
+#include <iostream>
+#include <vector>
+
+#include "AggregateKernels.h"
+
+/** AggregateCache remembers the summaries of one column of a \ref Table in a segment tree, so that
+ *  the summary of any range of rows inside the column is put together from O(log n) nodes instead of
+ *  reading every cell of it. One tree serves every range of the column, however much the ranges overlap.
+ *  \n The leaves of the tree are blocks of \ref BLOCK_ROWS consecutive rows. The table summarizes a block
+ *  again after one of its cells changes (\ref setBlock), and reads the rows of a range which do not
+ *  fill a whole block itself.
+ *  \n Every node holds the sum, the count of numbers, the minimum and the maximum of the blocks below it,
+ *  calculated from its children every time one of them changes. So nothing is ever taken out of a sum
+ *  and errors, infinities and NaN leave the tree when the cells holding them change.
+ */
+class AggregateCache{
+public:
+
+    /** Count of rows summarized by one leaf of the tree
+     */
+    static constexpr size_t BLOCK_ROWS = 64;
+
+private:
+
+    /** Summary of the blocks below one node of the tree
+     */
+    struct Node{
+        AggregateKernels::Summary summary;
+        size_t errors = 0;      /**< count of blocks with a formula with error */
+    };
+
+    /** Node i has children 2i and 2i+1, the leaf of block b is node \ref leaves_ + b. Node 0 is unused. */
+    std::vector<Node> nodes_;
+
+    /** Count of leaves, a power of 2. Blocks without rows are empty. */
+    size_t leaves_;
+
+    /** Adds the summary of a node to a summary and its errors to a count
+     */
+    static void add(const Node& node, AggregateKernels::Summary& summary, size_t& errors);
+
+    /** Calculates a node from its 2 children
+     */
+    void combine(size_t node);
+
+public:
+
+    /** Creates a tree of empty blocks
+     *
+     *  \param blocks count of blocks the tree needs to have at least
+     */
+    AggregateCache(size_t blocks);
+
+    /** Makes room for more blocks, if needed. The new blocks are empty.
+     */
+    void reserve(size_t blocks);
+
+    /** Replaces the summary of one block and updates every node above it - O(log n)
+     *
+     *  \param error whether any cell of the block is a formula with error
+     */
+    void setBlock(size_t block, const AggregateKernels::Summary& summary, bool error);
+
+    /** Adds the blocks between 2 blocks (inclusive, fromBlock <= toBlock) to a summary - O(log n)
+     *
+     *  \param error set to true if any of the blocks has a formula with error
+     */
+    void summarize(size_t fromBlock, size_t toBlock, AggregateKernels::Summary& summary, bool& error) const;
+
+    /** \return bytes the tree takes
+     */
+    size_t bytes() const;
+
+};
+
+
+#endif // AGGREGATE_CACHE_H
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <limits>
+
+#include "AggregateKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define AGGREGATE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace{
+
+typedef void (*SummarizeFunction)(const double*, const uint64_t*, size_t, AggregateKernels::Summary&);
+typedef double (*SumProductFunction)(const double*, const uint64_t*, const double*, const uint64_t*, size_t);
+
+inline bool isValidAt(const uint64_t* validity, size_t i){
+    return (validity[i >> 6] >> (i & 63)) & 1;
+}
+
+void summarizeScalar(const double* values, const uint64_t* validity, size_t count, AggregateKernels::Summary& summary){
+    double sum = 0;
+    double min = summary.min;
+    double max = summary.max;
+    size_t valid = 0;
+    for(size_t i = 0; i < count; i++){
+        if(isValidAt(validity, i)){
+            sum += values[i];
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
+            valid++;
+        }
+    }
+    summary.sum += sum;
+    summary.min = min;
+    summary.max = max;
+    summary.count += valid;
+}
+
+double sumProductScalar(const double* left, const uint64_t* leftValidity,
+                        const double* right, const uint64_t* rightValidity, size_t count){
+    double sum = 0;
+    for(size_t i = 0; i < count; i++){
+        if(isValidAt(leftValidity, i) && isValidAt(rightValidity, i)){
+            sum += left[i] * right[i];
+        }
+    }
+    return sum;
+}
+
+#ifdef AGGREGATE_KERNELS_X86
+
+/** Lane masks for every combination of validity bits. Entry k has all bits of lane j set when bit j of k is set.
+ */
+template<size_t Lanes>
+struct LaneMasks{
+    alignas(32) int64_t lanes[1 << Lanes][Lanes];
+
+    constexpr LaneMasks() : lanes(){
+        for(size_t k = 0; k < (1 << Lanes); k++){
+            for(size_t j = 0; j < Lanes; j++){
+                lanes[k][j] = ((k >> j) & 1) ? -1 : 0;
+            }
+        }
+    }
+};
+
+constexpr LaneMasks<4> avx2Masks;
+constexpr LaneMasks<2> sse2Masks;
+
+__attribute__((target("avx2")))
+inline __m256d avx2Mask(unsigned bits){
+    return _mm256_castsi256_pd(_mm256_load_si256((const __m256i*)avx2Masks.lanes[bits]));
+}
+
+__attribute__((target("avx2")))
+inline double avx2HorizontalSum(__m256d v){
+    __m128d low = _mm256_castpd256_pd128(v);
+    __m128d high = _mm256_extractf128_pd(v, 1);
+    low = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+__attribute__((target("avx2")))
+void summarizeAVX2(const double* values, const uint64_t* validity, size_t count, AggregateKernels::Summary& summary){
+    const __m256d positiveInfinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d negativeInfinity = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d min = _mm256_set1_pd(summary.min);
+    __m256d max = _mm256_set1_pd(summary.max);
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        // i is a multiple of 8, so all 8 bits are inside one word
+        unsigned bits = (validity[i >> 6] >> (i & 63)) & 0xFF;
+        __m256d mask0 = avx2Mask(bits & 0xF);
+        __m256d mask1 = avx2Mask(bits >> 4);
+        __m256d v0 = _mm256_loadu_pd(values + i);
+        __m256d v1 = _mm256_loadu_pd(values + i + 4);
+        sum0 = _mm256_add_pd(sum0, _mm256_and_pd(v0, mask0));
+        sum1 = _mm256_add_pd(sum1, _mm256_and_pd(v1, mask1));
+        // the new value goes first, so that a NaN never replaces the current minimum and maximum
+        min = _mm256_min_pd(_mm256_blendv_pd(positiveInfinity, v0, mask0), min);
+        min = _mm256_min_pd(_mm256_blendv_pd(positiveInfinity, v1, mask1), min);
+        max = _mm256_max_pd(_mm256_blendv_pd(negativeInfinity, v0, mask0), max);
+        max = _mm256_max_pd(_mm256_blendv_pd(negativeInfinity, v1, mask1), max);
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, min);
+    summary.min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, max);
+    summary.max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    summary.sum += avx2HorizontalSum(_mm256_add_pd(sum0, sum1));
+    summary.count += AggregateKernels::countValid(validity, i);
+
+    for(; i < count; i++){
+        if(isValidAt(validity, i)){
+            summary.sum += values[i];
+            summary.min = std::min(summary.min, values[i]);
+            summary.max = std::max(summary.max, values[i]);
+            summary.count++;
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+double sumProductAVX2(const double* left, const uint64_t* leftValidity,
+                      const double* right, const uint64_t* rightValidity, size_t count){
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        unsigned bits = (leftValidity[i >> 6] & rightValidity[i >> 6]) >> (i & 63) & 0xFF;
+        __m256d product0 = _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+        __m256d product1 = _mm256_mul_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4));
+        sum0 = _mm256_add_pd(sum0, _mm256_and_pd(product0, avx2Mask(bits & 0xF)));
+        sum1 = _mm256_add_pd(sum1, _mm256_and_pd(product1, avx2Mask(bits >> 4)));
+    }
+
+    double sum = avx2HorizontalSum(_mm256_add_pd(sum0, sum1));
+    for(; i < count; i++){
+        if(isValidAt(leftValidity, i) && isValidAt(rightValidity, i)){
+            sum += left[i] * right[i];
+        }
+    }
+    return sum;
+}
+
+__attribute__((target("sse2")))
+inline __m128d sse2Mask(unsigned bits){
+    return _mm_castsi128_pd(_mm_load_si128((const __m128i*)sse2Masks.lanes[bits]));
+}
+
+__attribute__((target("sse2")))
+inline __m128d sse2Select(__m128d value, __m128d otherwise, __m128d mask){
+    return _mm_or_pd(_mm_and_pd(mask, value), _mm_andnot_pd(mask, otherwise));
+}
+
+__attribute__((target("sse2")))
+void summarizeSSE2(const double* values, const uint64_t* validity, size_t count, AggregateKernels::Summary& summary){
+    const __m128d positiveInfinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d negativeInfinity = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d min = _mm_set1_pd(summary.min);
+    __m128d max = _mm_set1_pd(summary.max);
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        unsigned bits = (validity[i >> 6] >> (i & 63)) & 0xF;
+        __m128d mask0 = sse2Mask(bits & 0x3);
+        __m128d mask1 = sse2Mask(bits >> 2);
+        __m128d v0 = _mm_loadu_pd(values + i);
+        __m128d v1 = _mm_loadu_pd(values + i + 2);
+        sum0 = _mm_add_pd(sum0, _mm_and_pd(v0, mask0));
+        sum1 = _mm_add_pd(sum1, _mm_and_pd(v1, mask1));
+        min = _mm_min_pd(sse2Select(v0, positiveInfinity, mask0), min);
+        min = _mm_min_pd(sse2Select(v1, positiveInfinity, mask1), min);
+        max = _mm_max_pd(sse2Select(v0, negativeInfinity, mask0), max);
+        max = _mm_max_pd(sse2Select(v1, negativeInfinity, mask1), max);
+    }
+
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, min);
+    summary.min = std::min(lanes[0], lanes[1]);
+    _mm_store_pd(lanes, max);
+    summary.max = std::max(lanes[0], lanes[1]);
+    _mm_store_pd(lanes, _mm_add_pd(sum0, sum1));
+    summary.sum += lanes[0] + lanes[1];
+    summary.count += AggregateKernels::countValid(validity, i);
+
+    for(; i < count; i++){
+        if(isValidAt(validity, i)){
+            summary.sum += values[i];
+            summary.min = std::min(summary.min, values[i]);
+            summary.max = std::max(summary.max, values[i]);
+            summary.count++;
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+double sumProductSSE2(const double* left, const uint64_t* leftValidity,
+                      const double* right, const uint64_t* rightValidity, size_t count){
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        unsigned bits = (leftValidity[i >> 6] & rightValidity[i >> 6]) >> (i & 63) & 0xF;
+        __m128d product0 = _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i));
+        __m128d product1 = _mm_mul_pd(_mm_loadu_pd(left + i + 2), _mm_loadu_pd(right + i + 2));
+        sum0 = _mm_add_pd(sum0, _mm_and_pd(product0, sse2Mask(bits & 0x3)));
+        sum1 = _mm_add_pd(sum1, _mm_and_pd(product1, sse2Mask(bits >> 2)));
+    }
+
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(sum0, sum1));
+    double sum = lanes[0] + lanes[1];
+    for(; i < count; i++){
+        if(isValidAt(leftValidity, i) && isValidAt(rightValidity, i)){
+            sum += left[i] * right[i];
+        }
+    }
+    return sum;
+}
+
+#endif // AGGREGATE_KERNELS_X86
+
+/** Kernels currently in use. Picked once, the first time any of them is needed.
+ */
+struct Dispatch{
+    AggregateKernels::InstructionSet set;
+    SummarizeFunction summarize;
+    SumProductFunction sumProduct;
+
+    void select(AggregateKernels::InstructionSet wanted){
+        set = wanted;
+        switch(wanted){
+#ifdef AGGREGATE_KERNELS_X86
+        case AggregateKernels::InstructionSet::AVX2:
+            summarize = summarizeAVX2;
+            sumProduct = sumProductAVX2;
+            break;
+        case AggregateKernels::InstructionSet::SSE2:
+            summarize = summarizeSSE2;
+            sumProduct = sumProductSSE2;
+            break;
+#endif
+        default:
+            set = AggregateKernels::InstructionSet::Scalar;
+            summarize = summarizeScalar;
+            sumProduct = sumProductScalar;
+        }
+    }
+
+    Dispatch(){
+        if(AggregateKernels::isSupported(AggregateKernels::InstructionSet::AVX2)){
+            select(AggregateKernels::InstructionSet::AVX2);
+        }else if(AggregateKernels::isSupported(AggregateKernels::InstructionSet::SSE2)){
+            select(AggregateKernels::InstructionSet::SSE2);
+        }else{
+            select(AggregateKernels::InstructionSet::Scalar);
+        }
+    }
+};
+
+Dispatch& dispatch(){
+    static Dispatch current;
+    return current;
+}
+
+}
+
+AggregateKernels::Summary::Summary()
+    :min(std::numeric_limits<double>::infinity()),
+     max(-std::numeric_limits<double>::infinity())
+{
+
+}
+
+void AggregateKernels::summarize(const double* values, const uint64_t* validity, size_t count, Summary& summary){
+    dispatch().summarize(values, validity, count, summary);
+}
+
+double AggregateKernels::sumProduct(const double* left, const uint64_t* leftValidity,
+                                    const double* right, const uint64_t* rightValidity, size_t count){
+    return dispatch().sumProduct(left, leftValidity, right, rightValidity, count);
+}
+
+size_t AggregateKernels::countValid(const uint64_t* validity, size_t count){
+    size_t valid = 0;
+    size_t fullWords = count / 64;
+    for(size_t i = 0; i < fullWords; i++){
+        valid += __builtin_popcountll(validity[i]);
+    }
+    if(count % 64 != 0){
+        valid += __builtin_popcountll(validity[fullWords] & ((1ULL << (count % 64)) - 1));
+    }
+    return valid;
+}
+
+AggregateKernels::InstructionSet AggregateKernels::instructionSet(){
+    return dispatch().set;
+}
+
+bool AggregateKernels::useInstructionSet(InstructionSet set){
+    if(!isSupported(set)){
+        return false;
+    }
+    dispatch().select(set);
+    return true;
+}
+
+bool AggregateKernels::isSupported(InstructionSet set){
+    switch(set){
+    case InstructionSet::Scalar:
+        return true;
+#ifdef AGGREGATE_KERNELS_X86
+    case InstructionSet::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case InstructionSet::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
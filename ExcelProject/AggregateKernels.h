@@ -0,0 +1,78 @@
+#ifndef AGGREGATE_KERNELS_H
+#define AGGREGATE_KERNELS_H
+
+#include <iostream>
+#include <cstdint>
+
+/** AggregateKernels is a collection of functions which summarize arrays of floating numbers.
+ *  They are the inner loops of the aggregate functions of \ref CellFormula (SUM, MIN, MAX, COUNT,
+ *  AVERAGE and SUMPRODUCT), which \ref Table feeds with contiguous runs of cell values.
+ *  \n Every array comes with a validity bitmap: bit i of word i/64 tells whether element i holds a number.
+ *  Elements whose bit is not set (empty cells, strings, errors) are masked out and their value is ignored.
+ *  \n Every function has a vectorized AVX2 and SSE2 version and a scalar fallback. The best one
+ *  supported by the processor is picked the first time a kernel is used - \ref instructionSet
+ */
+class AggregateKernels{
+public:
+
+    /** Vector instructions a kernel can be executed with
+     */
+    enum class InstructionSet{
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /** Running summary of valid elements. Summaries of several arrays can be built by
+     *  passing the same object to \ref summarize multiple times.
+     */
+    struct Summary{
+        double sum = 0;
+        double min = 0;     /**< +infinity while no valid element has been seen */
+        double max = 0;     /**< -infinity while no valid element has been seen */
+        size_t count = 0;   /**< count of valid elements */
+
+        Summary();
+    };
+
+    /** Adds every valid element of the array to the summary.
+     *
+     *  \param values array of numbers
+     *  \param validity bitmap with at least (count + 63) / 64 words
+     *  \param count count of elements in the array
+     *  \param summary summary to add to
+     */
+    static void summarize(const double* values, const uint64_t* validity, size_t count, Summary& summary);
+
+    /** Sum of the products of the elements with equal positions in 2 arrays.
+     *  Only positions valid in both arrays are multiplied.
+     *
+     *  \param count count of elements in each of the arrays
+     *  \return the sum of the products
+     */
+    static double sumProduct(const double* left, const uint64_t* leftValidity,
+                             const double* right, const uint64_t* rightValidity, size_t count);
+
+    /** \return count of set bits among the first count bits of the bitmap
+     */
+    static size_t countValid(const uint64_t* validity, size_t count);
+
+    /** \return the instruction set the kernels are currently executed with
+     */
+    static InstructionSet instructionSet();
+
+    /** Forces the kernels to use the given instruction set. Mostly useful to compare the results
+     *  of different versions.
+     *
+     *  \return false if the processor does not support it, in which case nothing is changed
+     */
+    static bool useInstructionSet(InstructionSet set);
+
+    /** \return whether the processor supports the given instruction set
+     */
+    static bool isSupported(InstructionSet set);
+
+};
+
+
+#endif // AGGREGATE_KERNELS_H
@@ -0,0 +1,44 @@
+#include <cstdlib>
+#include <new>
+
+#include "Statistics.h"
+
+// Replaces the global allocation functions, so that Statistics counts every allocation of the program.
+// They have a file of their own: where GCC also sees code using the standard ones, it warns about the free calls.
+
+void* operator new(size_t size){
+    Statistics::countAllocation();
+    if(size == 0){
+        size = 1;
+    }
+    // as the standard one does: the new handler may free some memory, so it is called until malloc succeeds
+    void* pointer;
+    while((pointer = std::malloc(size)) == nullptr){
+        std::new_handler handler = std::get_new_handler();
+        if(handler == nullptr){
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept{
+    std::free(pointer);
+}
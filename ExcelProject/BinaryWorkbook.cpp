@@ -0,0 +1,503 @@
+#include <fstream>
+#include <cctype>
+#include <cstring>
+#include <climits>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define BINARY_WORKBOOK_MMAP
+#endif
+
+#include "BinaryWorkbook.h"
+#include "Column.h"
+#include "CellInt.h"
+#include "CellDouble.h"
+#include "CellString.h"
+#include "CellFormula.h"
+#include "FormulaProgram.h"
+
+namespace{
+
+const char MAGIC[8] = {'X', 'T', 'B', 'L', '\r', '\n', 0x1A, 0};
+const uint32_t VERSION = 4;
+
+struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t columns;
+    uint64_t stringsOffset;     /**< uint64_t offsets[stringsCount + 1], followed by the chars */
+    uint64_t stringsCount;
+    uint64_t columnsOffset;     /**< ColumnHeader[columns] */
+    uint64_t formulasOffset;    /**< FormulaRecord[formulasCount] */
+    uint64_t formulasCount;
+    uint64_t fileSize;
+};
+
+struct ColumnHeader{
+    uint32_t type;              /**< Column::Type */
+    uint32_t reserved;
+    uint64_t valuesOffset;      /**< int64_t, double or string index per row, if the column has a type */
+    uint64_t validityOffset;    /**< uint64_t[(rows + 63) / 64], if the column has a type */
+    uint64_t intRowsOffset;     /**< uint64_t[(rows + 63) / 64] - Column::intBits, if the column holds doubles */
+    uint64_t cellsOffset;       /**< CellRecord[cellsCount] */
+    uint64_t cellsCount;
+};
+
+enum class CellKind : uint32_t{
+    Int,
+    Double,
+    String,
+    Formula
+};
+
+struct CellRecord{
+    uint64_t row;
+    CellKind kind;
+    uint32_t reserved;
+    uint64_t value;             /**< int64_t, bits of double, string index or formula index */
+};
+
+/** Formulas filled from the same one share the text and the instructions of their template */
+struct FormulaRecord{
+    uint64_t text;              /**< string index of the text of the template */
+    uint64_t codeOffset;        /**< FormulaProgram::Instruction[codeCount] */
+    uint64_t codeCount;
+    double result;
+    uint32_t error;             /**< FormulaProgram::Error */
+    uint32_t reserved;
+    int64_t rowOffset;          /**< CellFormula::rowOffset */
+    int64_t columnOffset;       /**< CellFormula::columnOffset */
+};
+
+/** Appends bytes at the end of a buffer, followed by zeroes up to a multiple of 8
+ *  \return offset of the bytes inside the buffer
+ */
+uint64_t appendAligned(std::string& buffer, const void* data, size_t bytes){
+    uint64_t offset = buffer.size();
+    buffer.append((const char*)data, bytes);
+    buffer.append((8 - buffer.size() % 8) % 8, '\0');
+    return offset;
+}
+
+/** Every distinct string gets one index */
+class StringDictionary{
+private:
+    std::unordered_map<std::string, uint64_t> indexes_;
+    std::vector<uint64_t> offsets_;
+    std::string chars_;
+
+public:
+    StringDictionary() : offsets_(1, 0){
+    }
+
+    uint64_t add(std::string_view value){
+        auto inserted = indexes_.emplace(std::string(value), offsets_.size() - 1);
+        if(inserted.second){
+            chars_.append(value);
+            offsets_.push_back(chars_.size());
+        }
+        return inserted.first->second;
+    }
+
+    uint64_t count() const{
+        return offsets_.size() - 1;
+    }
+
+    const std::vector<uint64_t>& offsets() const{
+        return offsets_;
+    }
+
+    const std::string& chars() const{
+        return chars_;
+    }
+};
+
+/** Whole file in memory - mapped where the system allows it, read otherwise */
+class MappedFile{
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::vector<uint64_t> buffer_;      /**< uint64_t so that the data is aligned to 8 */
+
+public:
+    explicit MappedFile(const std::string& filename){
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+
+#ifdef BINARY_WORKBOOK_MMAP
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd >= 0){
+            struct stat info;
+            if(fstat(fd, &info) == 0 && info.st_size > 0){
+                void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(mapping != MAP_FAILED){
+                    data_ = (const char*)mapping;
+                    size_ = info.st_size;
+                    mapped_ = true;
+                }
+            }
+            close(fd);
+            if(mapped_){
+                return;
+            }
+        }
+#endif
+
+        std::ifstream readFile(filename, std::ios::binary | std::ios::ate);
+        if(!readFile.is_open()){
+            throw std::invalid_argument("File not found. ");
+        }
+        size_ = readFile.tellg();
+        buffer_.resize((size_ + 7) / 8);
+        readFile.seekg(0);
+        if(!readFile.read((char*)buffer_.data(), size_)){
+            throw std::invalid_argument("Failed reading from the file. ");
+        }
+        data_ = (const char*)buffer_.data();
+    }
+
+    ~MappedFile(){
+#ifdef BINARY_WORKBOOK_MMAP
+        if(mapped_){
+            munmap((void*)data_, size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** \return pointer to count elements starting from offset
+     *  \exception invalid_argument the elements are not entirely inside the file or are not aligned
+     */
+    template<typename T>
+    const T* section(uint64_t offset, uint64_t count) const{
+        if(offset % 8 != 0 || offset > size_ || count > (size_ - offset) / sizeof(T)){
+            throw std::invalid_argument("The file is damaged. ");
+        }
+        return (const T*)(data_ + offset);
+    }
+
+    size_t size() const{
+        return size_;
+    }
+};
+
+/** Strings of a loaded file */
+class StringTable{
+private:
+    const uint64_t* offsets_;
+    const char* chars_;
+    uint64_t count_;
+
+public:
+    StringTable(const MappedFile& file, const FileHeader& header){
+        if(header.stringsCount >= file.size()){
+            throw std::invalid_argument("The file is damaged. ");
+        }
+        count_ = header.stringsCount;
+        offsets_ = file.section<uint64_t>(header.stringsOffset, count_ + 1);
+        chars_ = file.section<char>(header.stringsOffset + (count_ + 1) * 8, offsets_[count_]);
+    }
+
+    std::string get(uint64_t index) const{
+        if(index >= count_ || offsets_[index] > offsets_[index + 1] || offsets_[index + 1] > offsets_[count_]){
+            throw std::invalid_argument("The file is damaged. ");
+        }
+        return std::string(chars_ + offsets_[index], offsets_[index + 1] - offsets_[index]);
+    }
+};
+
+}
+
+bool BinaryWorkbook::hasExtension(const std::string& path){
+    size_t length = strlen(EXTENSION);
+    if(path.size() <= length + 1){
+        return false;
+    }
+    for(size_t i = 0; i < length; i++){
+        if(tolower(path[path.size() - length + i]) != EXTENSION[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+void BinaryWorkbook::save(const Table& table, const std::string& filename){
+    // results are read directly from the cells, so none of them may wait to be calculated
+    table.calculateDirtyFormulas();
+
+    size_t rows = table.rowsCount();
+    size_t words = (rows + 63) / 64;
+
+    StringDictionary strings;
+    std::vector<ColumnHeader> columnHeaders(table.columnsCount());
+    std::string columnData;             // offsets relative to the start of the column data
+    std::vector<FormulaRecord> formulas;
+    std::string code;                   // offsets relative to the start of the instructions
+    std::unordered_map<const CellFormula::Template*, FormulaRecord> templates;
+    std::string buffer;
+
+    for(size_t col = 0; col < table.columnsCount(); col++){
+        const Column& column = table.columnAt(col);
+        ColumnHeader& header = columnHeaders[col];
+        memset(&header, 0, sizeof(header));
+        header.type = (uint32_t)column.type();
+
+        switch(column.type()){
+        case Column::Type::Int:
+            header.valuesOffset = appendAligned(columnData, column.intValues().data(), rows * sizeof(int64_t));
+            break;
+        case Column::Type::Double:
+            header.valuesOffset = appendAligned(columnData, column.doubleValues().data(), rows * sizeof(double));
+            header.intRowsOffset = appendAligned(columnData, column.intBits().data(), words * sizeof(uint64_t));
+            break;
+        case Column::Type::String:{
+            std::vector<uint64_t> indexes(rows, 0);
+            const std::vector<uint64_t>& validity = column.validityBits();
+            for(size_t row = 0; row < rows; row++){
+                if((validity[row >> 6] >> (row & 63)) & 1){
+                    indexes[row] = strings.add(column.stringValues()[row]);
+                }
+            }
+            header.valuesOffset = appendAligned(columnData, indexes.data(), rows * sizeof(uint64_t));
+            break;
+        }
+        default:
+            break;
+        }
+        if(column.type() != Column::Type::Empty){
+            header.validityOffset = appendAligned(columnData, column.validityBits().data(), words * sizeof(uint64_t));
+        }
+
+        std::vector<CellRecord> records;
+        const std::vector<uint64_t>& cells = column.cellBits();
+        for(size_t word = 0; word < cells.size(); word++){
+            for(uint64_t bits = cells[word]; bits != 0; bits &= bits - 1){
+                size_t row = word * 64 + __builtin_ctzll(bits);
+                const Cell* cell = column.getStoredCell(row);
+                CellRecord record;
+                memset(&record, 0, sizeof(record));
+                record.row = row;
+                if(const CellInt* ci = dynamic_cast<const CellInt*>(cell)){
+                    record.kind = CellKind::Int;
+                    int64_t value = ci->getValue();
+                    memcpy(&record.value, &value, sizeof(value));
+                }else if(const CellDouble* cd = dynamic_cast<const CellDouble*>(cell)){
+                    record.kind = CellKind::Double;
+                    double value = cd->getValue();
+                    memcpy(&record.value, &value, sizeof(value));
+                }else if(const CellFormula* cf = dynamic_cast<const CellFormula*>(cell)){
+                    record.kind = CellKind::Formula;
+                    record.value = formulas.size();
+                    auto known = templates.find(cf->getTemplate().get());
+                    if(known == templates.end()){
+                        const std::vector<FormulaProgram::Instruction>& instructions = cf->program().code();
+                        FormulaRecord shared;
+                        memset(&shared, 0, sizeof(shared));
+                        shared.text = strings.add(cf->getTemplate()->formula);
+                        shared.codeOffset = appendAligned(code, instructions.data(),
+                                                          instructions.size() * sizeof(FormulaProgram::Instruction));
+                        shared.codeCount = instructions.size();
+                        known = templates.emplace(cf->getTemplate().get(), shared).first;
+                    }
+                    FormulaRecord formula = known->second;
+                    formula.result = cf->getValue();
+                    formula.error = (uint32_t)cf->errorCode();
+                    formula.rowOffset = cf->rowOffset();
+                    formula.columnOffset = cf->columnOffset();
+                    formulas.push_back(formula);
+                }else{
+                    record.kind = CellKind::String;
+                    record.value = strings.add(cell->getConstructView(buffer));
+                }
+                records.push_back(record);
+            }
+        }
+        header.cellsCount = records.size();
+        header.cellsOffset = appendAligned(columnData, records.data(), records.size() * sizeof(CellRecord));
+    }
+
+    // every section is already a multiple of 8 bytes long, except for the string chars
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.rows = rows;
+    header.columns = table.columnsCount();
+    header.stringsOffset = sizeof(FileHeader);
+    header.stringsCount = strings.count();
+    uint64_t charsBytes = (strings.chars().size() + 7) / 8 * 8;
+    header.columnsOffset = header.stringsOffset + strings.offsets().size() * sizeof(uint64_t) + charsBytes;
+    uint64_t columnDataOffset = header.columnsOffset + columnHeaders.size() * sizeof(ColumnHeader);
+    header.formulasOffset = columnDataOffset + columnData.size();
+    header.formulasCount = formulas.size();
+    uint64_t codeOffset = header.formulasOffset + formulas.size() * sizeof(FormulaRecord);
+    header.fileSize = codeOffset + code.size();
+
+    for(size_t col = 0; col < columnHeaders.size(); col++){
+        columnHeaders[col].valuesOffset += columnDataOffset;
+        columnHeaders[col].validityOffset += columnDataOffset;
+        columnHeaders[col].intRowsOffset += columnDataOffset;
+        columnHeaders[col].cellsOffset += columnDataOffset;
+    }
+    for(size_t i = 0; i < formulas.size(); i++){
+        formulas[i].codeOffset += codeOffset;
+    }
+
+    std::ofstream writeFile(filename, std::ios::binary | std::ios::trunc);
+    if(writeFile.fail()){
+        throw std::invalid_argument((std::string)"Unexpected error while opening file. 1) Possible reasons: permission deny, " +
+                                    "2) file exists, but another software denies access to it.");
+    }
+    writeFile.write((const char*)&header, sizeof(header));
+    writeFile.write((const char*)strings.offsets().data(), strings.offsets().size() * sizeof(uint64_t));
+    writeFile.write(strings.chars().data(), strings.chars().size());
+    writeFile.write("\0\0\0\0\0\0\0", charsBytes - strings.chars().size());
+    writeFile.write((const char*)columnHeaders.data(), columnHeaders.size() * sizeof(ColumnHeader));
+    writeFile.write(columnData.data(), columnData.size());
+    writeFile.write((const char*)formulas.data(), formulas.size() * sizeof(FormulaRecord));
+    writeFile.write(code.data(), code.size());
+    writeFile.close();
+    if(writeFile.fail()){
+        throw std::invalid_argument("Unexpected error while writing the file. ");
+    }
+}
+
+void BinaryWorkbook::load(const std::string& filename, Table& table){
+
+    MappedFile file(filename);
+    const FileHeader& header = *file.section<FileHeader>(0, 1);
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0){
+        throw std::invalid_argument("Not a table file. ");
+    }
+    if(header.version != VERSION){
+        throw std::invalid_argument("Unsupported version of the file format. ");
+    }
+    if(header.fileSize != file.size() || header.rows == 0 || header.columns == 0
+        || header.rows > CellRef::LAST_ROW + 1 || header.columns > file.size()){
+        throw std::invalid_argument("The file is damaged. ");
+    }
+
+    size_t rows = header.rows;
+    size_t words = (rows + 63) / 64;
+    StringTable strings(file, header);
+    const ColumnHeader* columnHeaders = file.section<ColumnHeader>(header.columnsOffset, header.columns);
+    const FormulaRecord* formulas = file.section<FormulaRecord>(header.formulasOffset, header.formulasCount);
+    // one template for the formulas which were filled from the same one, by text and instructions
+    std::map<std::pair<uint64_t, uint64_t>, std::shared_ptr<const CellFormula::Template>> templates;
+
+    std::vector<Column> columns(header.columns);
+    std::vector<uint64_t> validity(words);
+    CellString stringChecker;
+
+    for(size_t col = 0; col < columns.size(); col++){
+        const ColumnHeader& columnHeader = columnHeaders[col];
+        Column& column = columns[col];
+        column.resize(rows);
+
+        if(columnHeader.type != (uint32_t)Column::Type::Empty){
+            // bits after the last row must not be set
+            memcpy(validity.data(), file.section<uint64_t>(columnHeader.validityOffset, words), words * sizeof(uint64_t));
+            if(rows % 64 != 0){
+                validity[words - 1] &= (1ULL << (rows % 64)) - 1;
+            }
+        }
+
+        switch(columnHeader.type){
+        case (uint32_t)Column::Type::Empty:
+            break;
+        case (uint32_t)Column::Type::Int:
+            column.loadInts(file.section<int64_t>(columnHeader.valuesOffset, rows), validity.data());
+            break;
+        case (uint32_t)Column::Type::Double:
+            column.loadDoubles(file.section<double>(columnHeader.valuesOffset, rows), validity.data(),
+                               file.section<uint64_t>(columnHeader.intRowsOffset, words));
+            break;
+        case (uint32_t)Column::Type::String:{
+            const uint64_t* indexes = file.section<uint64_t>(columnHeader.valuesOffset, rows);
+            std::vector<std::string> values(rows);
+            for(size_t row = 0; row < rows; row++){
+                if((validity[row >> 6] >> (row & 63)) & 1){
+                    values[row] = strings.get(indexes[row]);
+                    if(!stringChecker.isValid(values[row])){
+                        throw std::invalid_argument("The file is damaged. ");
+                    }
+                }
+            }
+            column.loadStrings(values, validity.data());
+            break;
+        }
+        default:
+            throw std::invalid_argument("The file is damaged. ");
+        }
+
+        const CellRecord* records = file.section<CellRecord>(columnHeader.cellsOffset, columnHeader.cellsCount);
+        for(size_t i = 0; i < columnHeader.cellsCount; i++){
+            const CellRecord& record = records[i];
+            if(record.row >= rows){
+                throw std::invalid_argument("The file is damaged. ");
+            }
+            Cell* cell = nullptr;
+            switch(record.kind){
+            case CellKind::Int:{
+                int64_t value;
+                memcpy(&value, &record.value, sizeof(value));
+                if(value < INT_MIN || value > INT_MAX){
+                    throw std::invalid_argument("The file is damaged. ");
+                }
+                cell = new CellInt((int)value);
+                break;
+            }
+            case CellKind::Double:{
+                double value;
+                memcpy(&value, &record.value, sizeof(value));
+                cell = new CellDouble(value);
+                break;
+            }
+            case CellKind::String:
+                cell = new CellString(strings.get(record.value));
+                break;
+            case CellKind::Formula:{
+                if(record.value >= header.formulasCount){
+                    throw std::invalid_argument("The file is damaged. ");
+                }
+                const FormulaRecord& formula = formulas[record.value];
+                std::shared_ptr<const CellFormula::Template>& shared = templates[{formula.text, formula.codeOffset}];
+                if(shared == nullptr){
+                    const FormulaProgram::Instruction* code =
+                        file.section<FormulaProgram::Instruction>(formula.codeOffset, formula.codeCount);
+                    std::string text = strings.get(formula.text);
+                    if(text.empty() || text[0] != '='){
+                        throw std::invalid_argument("The file is damaged. ");
+                    }
+                    FormulaProgram program(std::vector<FormulaProgram::Instruction>(code, code + formula.codeCount));
+                    shared = std::make_shared<const CellFormula::Template>(CellFormula::Template{text, program});
+                }
+                if(formula.error > (uint32_t)FormulaProgram::Error::Cycle){
+                    throw std::invalid_argument("The file is damaged. ");
+                }
+                cell = new CellFormula(&table, shared, formula.rowOffset, formula.columnOffset,
+                                       formula.result, (FormulaProgram::Error)formula.error);
+                break;
+            }
+            default:
+                throw std::invalid_argument("The file is damaged. ");
+            }
+            column.setCell(record.row, cell);
+        }
+    }
+
+    table.assignColumns(columns, rows);
+}
@@ -0,0 +1,51 @@
+#ifndef BINARY_WORKBOOK_H
+#define BINARY_WORKBOOK_H
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+
+#include "Table.h"
+
+/** BinaryWorkbook reads and writes tables in the native binary format (files ending on .xtb).
+ *  Unlike CSV, nothing has to be parsed, validated or calculated when such a file is opened:
+ *  \li typed columns are stored as arrays of integers, floating numbers or string indexes with their
+ *  validity bitmaps - the same arrays \ref Column keeps in memory
+ *  \li every distinct string (texts and formulas) is stored once in a string dictionary
+ *  \li formulas are stored compiled (\ref FormulaProgram) together with their last calculated results.
+ *  Formulas filled from the same one share their text and instructions - \ref CellFormula::Template
+ *  \li other cells (values which do not match the type of their column) are stored as short records
+ *  \n Every section starts on an offset which is a multiple of 8, so the file is memory-mapped and its
+ *  arrays are copied directly from the mapping. Numbers are stored in the byte order of the machine
+ *  which wrote the file.
+ *  \n Layout: file header, string offsets, string chars, column headers, column arrays and cell records,
+ *  formula records, formula instructions.
+ */
+class BinaryWorkbook{
+public:
+
+    /** Extension of the files in this format (checked case insensitively)
+     */
+    static constexpr const char* EXTENSION = ".xtb";
+
+    /** \return whether the path ends on \ref EXTENSION (case insensitive) and has a non-empty filename
+     */
+    static bool hasExtension(const std::string& path);
+
+    /** Writes the whole table into a file. The file is replaced if it exists.
+     *
+     *  \exception invalid_argument the file cannot be written
+     */
+    static void save(const Table& table, const std::string& filename);
+
+    /** Reads a file written by \ref save and replaces every cell of the table with its content.
+     *  The table is not changed if the file cannot be read.
+     *
+     *  \exception invalid_argument the file cannot be opened, is not in this format or is damaged
+     */
+    static void load(const std::string& filename, Table& table);
+
+};
+
+
+#endif // BINARY_WORKBOOK_H
@@ -2,6 +2,11 @@
 #define CELL_H
 
 #include <iostream>
+#include <string>
+#include <string_view>
+
+#include "MemoryUsage.h"
+
 /** Cell is an completely abstract class. Its purpose is to link all children-classes which extend this class.
  *  Every child of Cell holds a specific type of information unique for the given class.
  *  \par Additionally, every child of Cell has its own string format to represent this specific information.
@@ -38,6 +43,22 @@ public:
      */
     virtual std::string getConstructString() = 0;
 
+    /** Non-allocating version of \ref getDisplayableString. Text the cell already stores is
+     *  returned as a view into the cell itself, while numbers are formatted into the provided buffer.
+     *  Reusing the same buffer for many cells keeps its capacity, so no allocation happens per cell.
+     *
+     *  \param buffer caller-owned scratch string, which the result may point into
+     *  \return view of the displayable string, valid until the buffer or the cell is changed
+     */
+    virtual std::string_view getDisplayableView(std::string& buffer) const = 0;
+
+    /** Non-allocating version of \ref getConstructString. Works the same way as \ref getDisplayableView
+     *
+     *  \param buffer caller-owned scratch string, which the result may point into
+     *  \return view of the construct string, valid until the buffer or the cell is changed
+     */
+    virtual std::string_view getConstructView(std::string& buffer) const = 0;
+
     /** Every instance of a class-child of this class should hold information of some type.
      *  This information can be given as a string by calling this function.
      *  The resulted string is formatted by default in an appropriate way to be displayed.
@@ -56,6 +77,12 @@ public:
      */
     virtual bool isValid(const std::string& str) = 0;
 
+    /** Adds the memory this object takes (including what it owns) to the part of its class
+     *
+     *  \param usage memory of a table being counted - \ref Table::memoryUsage
+     */
+    virtual void addMemoryUsage(MemoryUsage& usage) const = 0;
+
     /** Empty virtual destructor. Used to avoid future undefined behavior when dealing with extending.
      */
     virtual ~Cell();
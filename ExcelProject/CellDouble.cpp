@@ -1,3 +1,4 @@
+#include <cstdio>
 #include "CellDouble.h"
 
 CellDouble::CellDouble(){
@@ -9,6 +10,10 @@ CellDouble::CellDouble(const std::string& value){
     setValue(value);
 }
 
+CellDouble::CellDouble(double value){
+    double_ = value;
+}
+
 CellDouble::CellDouble(const CellDouble& copy){
     double_ = copy.double_;
 }
@@ -40,12 +45,25 @@ void CellDouble::trimZeroes(std::string& str){
     if(cut != decimalPoint){
         cut++;
     }
-    str = str.substr(0, cut);
+    str.resize(cut);
+}
+
+void CellDouble::formatValue(double value, std::string& buffer){
+    // same output as std::to_string, without its temporary string
+    char digits[64];
+    int length = std::snprintf(digits, sizeof(digits), "%f", value);
+    if(length < (int)sizeof(digits)){
+        buffer.assign(digits, length);
+    }else{
+        buffer.resize(length);
+        std::snprintf(&buffer[0], length + 1, "%f", value);
+    }
+    trimZeroes(buffer);
 }
 
 std::string CellDouble::getDisplayableString(){
-    std::string str = std::to_string(double_);
-    trimZeroes(str);
+    std::string str;
+    formatValue(double_, str);
     return str;
 }
 
@@ -53,6 +71,15 @@ std::string CellDouble::getConstructString(){
     return getDisplayableString();
 }
 
+std::string_view CellDouble::getDisplayableView(std::string& buffer) const{
+    formatValue(double_, buffer);
+    return buffer;
+}
+
+std::string_view CellDouble::getConstructView(std::string& buffer) const{
+    return getDisplayableView(buffer);
+}
+
 bool CellDouble::isValid(const std::string& value){
     bool decimalPoint = false;
     size_t initialPos = 0;
@@ -83,10 +110,16 @@ bool CellDouble::isValid(const std::string& value){
     return true;
 }
 
-double CellDouble::getValue(){
+double CellDouble::getValue() const{
     return double_;
 }
 
 Cell* CellDouble::clone() const{
     return new CellDouble(*this);
 }
+
+void CellDouble::addMemoryUsage(MemoryUsage& usage) const{
+    usage.doubles.count++;
+    usage.doubles.bytes += sizeof(CellDouble);
+    usage.blocks++;
+}
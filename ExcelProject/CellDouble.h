@@ -24,7 +24,7 @@ private:
      *
      * \param string to be trimmed
      */
-    void trimZeroes(std::string& str);
+    static void trimZeroes(std::string& str);
 
 public:
 
@@ -40,6 +40,11 @@ public:
      */
     CellDouble(const std::string& value);
 
+    /** Constructor which builds an object with an initial value
+     *  \param initial floating number
+     */
+    CellDouble(double value);
+
     /** Copy constructor
      *  \param object of type CellDouble to copy from
      */
@@ -57,7 +62,7 @@ public:
      *
      *  \return Current instance's hold value of type double
      */
-    double getValue();
+    double getValue() const;
 
     /** As a child of Cell, this method can be called by a Cell pointer to get
      *  the direct pointer to instance of this class.
@@ -78,6 +83,23 @@ public:
      */
     std::string getConstructString();
 
+    /** Formats the current value into the buffer the same way \ref getDisplayableString does.
+     *  \return view of the buffer
+     */
+    std::string_view getDisplayableView(std::string& buffer) const;
+
+    /** \return same as \ref getDisplayableView
+     */
+    std::string_view getConstructView(std::string& buffer) const;
+
+    /** Writes a floating number into a string in the displayable format of this class.
+     *  The string's capacity is reused, so a buffer passed repeatedly is allocated only once.
+     *
+     *  \param value number to format
+     *  \param buffer string which receives the result
+     */
+    static void formatValue(double value, std::string& buffer);
+
     /** Checks whether a string represents a valid floating number.
      *  \exception out_of_range if the provided string is too large to fit in a double -
      *  \link check https://www.cplusplus.com/reference/string/stoi/
@@ -89,6 +111,10 @@ public:
      */
     Cell* clone() const;
 
+    /** Adds this object - \ref Cell::addMemoryUsage
+     */
+    void addMemoryUsage(MemoryUsage& usage) const;
+
 };
 
 
@@ -1,5 +1,5 @@
-#include <math.h>
-#include "CellFormula.h"
+#include <vector>
+#include <algorithm>
 #include "CellFormula.h"
 #include "CellDouble.h"
 
@@ -9,9 +9,9 @@ CellFormula::CellFormula(const Table* tableRef)
     if(tableRef == nullptr){
         throw std::invalid_argument("Table pointer cannot be null.");
     }
-    error_ = true;
+    error_ = FormulaProgram::Error::Value;
     result_ = 0;
-    formula_ = "=";
+    template_ = std::make_shared<const Template>(Template{"=", FormulaProgram()});
 }
 
 CellFormula::CellFormula(const Table* tableRef, const std::string& value)
@@ -22,286 +22,187 @@ CellFormula::CellFormula(const Table* tableRef, const std::string& value)
     }
 
     result_ = 0;
-    formula_ = value;
     setValue(value);
 }
 
+CellFormula::CellFormula(const Table* tableRef, const std::string& value, const FormulaProgram& program, double result,
+                         FormulaProgram::Error error)
+    :tableRef_(tableRef)
+{
+    if(tableRef == nullptr){
+        throw std::invalid_argument("Table pointer cannot be null.");
+    }
+    if(!isValid(value)){
+        throw std::invalid_argument("Not a formula");
+    }
+    template_ = std::make_shared<const Template>(Template{value, program});
+    result_ = result;
+    error_ = error;
+}
+
+CellFormula::CellFormula(const Table* tableRef, const std::shared_ptr<const Template>& shared, int64_t rowOffset,
+                         int64_t columnOffset, double result, FormulaProgram::Error error)
+    :tableRef_(tableRef), template_(shared), rowOffset_(rowOffset), columnOffset_(columnOffset)
+{
+    if(tableRef == nullptr){
+        throw std::invalid_argument("Table pointer cannot be null.");
+    }
+    if(shared == nullptr){
+        throw std::invalid_argument("Template cannot be null.");
+    }
+    result_ = result;
+    error_ = error;
+}
+
 CellFormula::CellFormula(const CellFormula& copy)
     :tableRef_(copy.tableRef_){
     error_ = copy.error_;
     result_ = copy.result_;
-    formula_ = copy.formula_;
-}
-
-void CellFormula::trimEntirely(std::string& str){
-    std::string res = "";
-    for(size_t i = 0; i < str.size(); i++){
-        if(str[i] == ' '){
-            continue;
-        }
-        res += (char)str[i];
-    }
-    str = res;
+    template_ = copy.template_;
+    rowOffset_ = copy.rowOffset_;
+    columnOffset_ = copy.columnOffset_;
 }
 
-int CellFormula::seekFirstOperation(const std::string& str, char ch[], size_t charCount){
-    int bracketsBalance = 0;
-    for(size_t i = 0; i < str.size(); i++){
-        if(str[i] == '('){
-            bracketsBalance++;
-            continue;
-        }
-        if(str[i] == ')'){
-            bracketsBalance--;
-            continue;
-        }
-        if(bracketsBalance != 0){
-            continue;
-        }
-        for(size_t charI = 0; charI < charCount; charI++){
-            if(str[i] == ch[charI]){
-                return i;
-            }
-        }
+void CellFormula::setValue(const std::string& value){
 
+    if(isValid(value)){
+        template_ = std::make_shared<const Template>(Template{value, FormulaProgram::compile(value)});
+        rowOffset_ = 0;
+        columnOffset_ = 0;
+        recalculate();
+    }else{
+        throw std::invalid_argument("Not a formula");
     }
-    return -1;
 }
 
-int CellFormula::seekLastOperation(const std::string& str, char ch[], size_t charCount){
-    int bracketsBalance = 0;
-    for(int i = str.size() - 1; i >= 0; i--){
-        if(str[i] == '('){
-            bracketsBalance++;
-            continue;
-        }
-        if(str[i] == ')'){
-            bracketsBalance--;
-            continue;
-        }
-        if(bracketsBalance != 0){
-            continue;
-        }
-        for(size_t charI = 0; charI < charCount; charI++){
-            if(str[i] == ch[charI]){
-                return i;
-            }
-        }
+void CellFormula::setTable(const Table* tableRef){
+    if(tableRef == nullptr){
+        throw std::invalid_argument("Table pointer cannot be null.");
     }
-    return -1;
+    tableRef_ = tableRef;
 }
 
-double CellFormula::extractCellValue(size_t row, size_t column){
-    const Cell* cell = tableRef_->getCellPointer(row, column);
-    if(cell == nullptr){
-        return 0;
-    }
-    Cell* copy = cell->clone();
-    CellFormula* cf = dynamic_cast<CellFormula*>(copy);
-    if(cf != nullptr && cf->error()){
-        delete copy;
-        throw std::invalid_argument("Reference to formula with error error");
-    }
-
-    std::string v = copy->getDisplayableString();
-    delete copy;
-    try{
-        CellDouble ctd(v);
-        double res = ctd.getValue();
-        return res;
-    }catch(std::invalid_argument& e){
-        // not a number
-    }
-
-    return 0.0;
-
+void CellFormula::recalculate(){
+    error_ = template_->program.evaluate(*tableRef_, result_, rowOffset_, columnOffset_);
 }
 
-double CellFormula::calculateFormulaRecursively(const std::string& currrentFormula){
-
-    if(currrentFormula.size() == 0){
-        throw std::invalid_argument("Invalid string. Possibly, a binary operation with fewer than 2 operands was given.");
-    }
-
-    if(currrentFormula[0] == '(' && currrentFormula[currrentFormula.size() - 1] == ')'){
-        if(currrentFormula.size() == 2){
-            throw std::invalid_argument("There's an empty string inside 1 set of brackets");
-        }
-        std::string sub_str = currrentFormula.substr(1, currrentFormula.size() - 2);
-        return this->calculateFormulaRecursively(sub_str);
-    }
+void CellFormula::markCircular(){
+    result_ = 0;
+    error_ = FormulaProgram::Error::Cycle;
+}
 
-    char arr[2];
-    int pos = 0;
+void CellFormula::restoreResult(double result, FormulaProgram::Error error){
+    result_ = result;
+    error_ = error;
+}
 
-    arr[0] = '+';
-    arr[1] = '-';
-    pos = seekLastOperation(currrentFormula, arr, 2);
-    if(pos >= 0){
-        double l_res = 0;
-        if(pos != 0){
-            std::string left = currrentFormula.substr (0, pos);
-            l_res = calculateFormulaRecursively(left);
-        }
-        std::string right = currrentFormula.substr (pos + 1, currrentFormula.size() - pos - 1);
-        double r_res = calculateFormulaRecursively(right);
-        if(currrentFormula[pos] == '+'){
-            return (l_res + r_res);
-        }
-        if(currrentFormula[pos] == '-'){
-            return (l_res - r_res);
+void CellFormula::collectReferences(std::vector<Table::Range>& references) const{
+    // a reference moved outside of the largest possible table makes the formula fail, so it depends on nothing there
+    auto add = [&](uint32_t fromRow, uint32_t fromColumn, uint32_t toRow, uint32_t toColumn){
+        Table::Range range;
+        if(FormulaProgram::shiftPosition(fromRow, fromColumn, rowOffset_, columnOffset_, range.fromRow, range.fromColumn) &&
+           FormulaProgram::shiftPosition(toRow, toColumn, rowOffset_, columnOffset_, range.toRow, range.toColumn)){
+            references.push_back(range);
         }
+    };
 
-    }
-
-    arr[0] = '*';
-    arr[1] = '/';
-    pos = seekFirstOperation(currrentFormula, arr, 2);
-    if(pos >= 0){
-        std::string left = currrentFormula.substr (0, pos);
-        std::string right = currrentFormula.substr (pos + 1, currrentFormula.size() - pos - 1);
-        double l_res = calculateFormulaRecursively(left);
-        double r_res = calculateFormulaRecursively(right);
-        if(currrentFormula[pos] == '*'){
-            return (l_res * r_res);
-        }
-        if(currrentFormula[pos] == '/'){
-            if(abs(r_res) < zero_){
-                throw std::invalid_argument("Dividing by zero");
-            }else{
-                return l_res / r_res;
-            }
+    const std::vector<FormulaProgram::Instruction>& code = template_->program.code();
+    for(size_t i = 0; i < code.size(); i++){
+        const FormulaProgram::Instruction& ins = code[i];
+        switch(ins.code){
+        case FormulaProgram::OpCode::Cell:
+        case FormulaProgram::OpCode::Range:
+            add(ins.fromRow, ins.fromColumn, ins.toRow, ins.toColumn);
+            break;
+        case FormulaProgram::OpCode::SumProduct:
+            add(ins.fromRow, ins.fromColumn, ins.toRow, ins.toColumn);
+            add(ins.otherRow, ins.otherColumn, ins.otherRow + (ins.toRow - ins.fromRow),
+                ins.otherColumn + (ins.toColumn - ins.fromColumn));
+            break;
+        default:
+            break;
         }
     }
+}
 
-    arr[0] = '^';
-    pos = seekLastOperation(currrentFormula, arr, 1);
-    if(pos >= 0){
-        std::string left = currrentFormula.substr (0, pos);
-        std::string right = currrentFormula.substr (pos + 1, currrentFormula.size() - pos - 1);
-        double l_res = calculateFormulaRecursively(left);
-        double r_res = calculateFormulaRecursively(right);
-        return pow(l_res, r_res);
-    }
-
-    double operand = 0.0;
-
-    try{
-        CellDouble d(currrentFormula);
-        operand = d.getValue();
-        return operand;
-    }catch(std::invalid_argument& e){
-        // not a number
-    }
-
-    // check if currentString is a reference to a cell (any cell)
-
-    size_t row;
-    size_t col;
-    bool isCell = false;
-    try{
-        row = Table::getRow(currrentFormula);
-        col = Table::getColumn(currrentFormula);
-        isCell = true;
-    }catch(std::invalid_argument& e){
-        // not a reference to a cell
-    }
-
-    if(isCell){
-        double res = extractCellValue(row, col);
-        return res;
-    }
+CellFormula* CellFormula::getPointer(){
+    return this;
+}
 
-    // then it should be a random string
-    throw std::invalid_argument("Entered formula is incorrect - contains unrecognizable characters");
+bool CellFormula::isValid(const std::string& value){
+    return (value.size() >= 1 && value[0] == '=');
+}
 
+std::string CellFormula::getDisplayableString(){
+    std::string str;
+    return std::string(getDisplayableView(str));
 }
 
-double CellFormula::calculateFormula(const std::string& formula){
-    std::string pureFormula = formula.substr(1, formula.size() - 1);
-    trimEntirely(pureFormula);
-    int bracketsBalance = 0;
-    for(size_t i = 1; i < formula.size(); i++){
-        if(formula[i] == '('){
-            bracketsBalance++;
-        }
-        if(formula[i] == ')'){
-            bracketsBalance--;
-            if(bracketsBalance < 0){
-                throw std::invalid_argument("Incorrect formula");
-            }
-        }
+std::string_view CellFormula::getDisplayableView(std::string& buffer) const{
+    if(error_ != FormulaProgram::Error::None){
+        return FormulaProgram::errorText(error_);
     }
-
-    return calculateFormulaRecursively(pureFormula);
+    CellDouble::formatValue(result_, buffer);
+    return buffer;
 }
 
-void CellFormula::setValue(const std::string& value){
-
-    if(isValid(value)){
-        try{
-            result_ = calculateFormula(value);
-            error_ = false;
-        }catch(std::invalid_argument& e){
-            result_ = 0;
-            error_ = true;
-        }
-    }else{
-        throw std::invalid_argument("Not a formula");
-    }
+std::string CellFormula::getConstructString(){
+    std::string buffer;
+    return std::string(getConstructView(buffer));
 }
 
-void CellFormula::recalculate(){
-    setValue(formula_);
+std::string_view CellFormula::getConstructView(std::string& buffer) const{
+    if(rowOffset_ == 0 && columnOffset_ == 0){
+        return template_->formula;
+    }
+    FormulaProgram::shiftReferences(template_->formula, rowOffset_, columnOffset_, buffer);
+    return buffer;
 }
 
-CellFormula* CellFormula::getPointer(){
-    return this;
+double CellFormula::getValue() const{
+    return result_;
 }
 
-bool CellFormula::isValid(const std::string& value){
-    return (value.size() >= 1 && value[0] == '=');
+bool CellFormula::error() const{
+    return error_ != FormulaProgram::Error::None;
 }
 
-void CellFormula::trimZeroes(std::string& str){
-    size_t decimalPoint = 0;
-    for(; decimalPoint < str.size(); decimalPoint++){
-        if(str[decimalPoint]=='.'){
-            break;
-        }
-    }
-    int cut = str.size() - 1;
-    for(; cut > decimalPoint; cut--){
-        if(str[cut] != '0')
-            break;
-    }
-    if(cut != decimalPoint){
-        cut++;
-    }
-    str = str.substr(0, cut);
+FormulaProgram::Error CellFormula::errorCode() const{
+    return error_;
 }
 
-std::string CellFormula::getDisplayableString(){
-    if(error_){
-        return "#ERROR";
-    }
-    std::string str = std::to_string(result_);
-    trimZeroes(str);
-    return str;
+const FormulaProgram& CellFormula::program() const{
+    return template_->program;
 }
 
-std::string CellFormula::getConstructString(){
-    return formula_;
+const std::shared_ptr<const CellFormula::Template>& CellFormula::getTemplate() const{
+    return template_;
 }
 
-double CellFormula::getValue(){
-    return result_;
+int64_t CellFormula::rowOffset() const{
+    return rowOffset_;
 }
 
-bool CellFormula::error(){
-    return error_;
+int64_t CellFormula::columnOffset() const{
+    return columnOffset_;
 }
 
 CellFormula* CellFormula::clone() const{
     return new CellFormula(*this);
 }
+
+void CellFormula::addMemoryUsage(MemoryUsage& usage) const{
+    usage.formulas.count++;
+    usage.formulas.bytes += sizeof(CellFormula);
+    usage.blocks++;
+
+    if(!usage.counted.insert(template_.get()).second){
+        return;
+    }
+    // the template is allocated together with the counters of its shared pointer (make_shared)
+    uint64_t text = MemoryUsage::heapBytes(template_->formula);
+    const std::vector<FormulaProgram::Instruction>& code = template_->program.code();
+    usage.formulaText += text;
+    usage.formulaPrograms += sizeof(Template) + 2 * sizeof(void*) + code.capacity() * sizeof(FormulaProgram::Instruction);
+    usage.blocks += 1 + (text != 0) + (code.capacity() != 0);
+}
@@ -2,14 +2,27 @@
 #define CELL_FORMULA_H
 
 #include <iostream>
+#include <vector>
+#include <memory>
 #include "Cell.h"
 #include "Table.h"
+#include "FormulaProgram.h"
 
 
 /** CellFormula is a class which extends the abstract class \ref Cell
  *  Every instance of this class takes care of one formula.
  *  A formula represents an algebraic expressing, whole return value is a floating number.
  *  \n A formula consists of operands (real numbers), unary operators (+,-) and binary ones (+,-,*,/,^)
+ *  \n Operands can also be references to cells (e.g. A0) and calls of aggregate functions over
+ *  ranges of cells (e.g. SUM(A0:A100)) - \ref FormulaProgram
+ *  \n The formula is compiled once when it is set. Calculating it again only runs the compiled program.
+ *  \n Formulas filled into a range from one cell share its text and compiled program (\ref Template) and only
+ *  remember how far they are from it. Their references are moved by that distance - \ref FormulaProgram::shiftReferences
+ *  The following calculate dependencies apply to references:
+ *  \li 1) empty cell (or one outside of the provided table) is considered 0
+ *  \li 2) string cells are considered as 0, even if they have number value
+ *  \li 3) formula cells with errors share the error in this formula as well
+ *  \li 4) int, double and formula without error gives right away the value they hold
  *  \n This class allows:
  *  \li set and change current formula - \ref setValue
  *  \li calculate the value this formula has - automatically calculated when setValue is called
@@ -19,109 +32,39 @@
  *  \li clone this object - \ref clone
  */
 class CellFormula : public Cell{
-private:
+public:
 
-    /** private constant representing an extremely low positive floating number. Used to indicate whether
-     *  a floating number is so close to zero, that it can be freely considered as a zero
+    /** Text and compiled program of a formula, shared by every formula filled from it
      */
-    static constexpr double zero_ = 0.0000001;
+    struct Template{
+        std::string formula;        /**< the formula as it was written */
+        FormulaProgram program;     /**< the formula compiled - \ref FormulaProgram::compile */
+    };
+
+private:
 
     /** A formula might have a reference to another cell in the current or another table. In order to
      *  find the information this class needs of, a reference to the table should be provided.
      */
     const Table* tableRef_;
 
-    /** Holds an unchanged copy of the last entered formula.
-     */
-    std::string formula_;
-
-    /** Holds the last calculated result in a formula, so that it does not need to calculate it again
-     */
-    double result_;
-
-    /** If the last calculated result was unsuccessful, this flag should be set to true.
-     */
-    bool error_ = false;
-
-    /** Removes every whitespace inside the string. Used to provide the function which
-     *  calculates the formula a valid string
-     *  \n Used by \ref calculateFormula
-     *  \param String to be trimmed.
-     */
-    void trimEntirely(std::string& str);
-
-    /** Finds the first occurrence of a wanted char.
-     *  \n Used by \ref calculateFormulaRecursively
-     *
-     *  \param String to search the wanted char.
-     *  \param A char array of wanted strings (will return the first time it finds at least one match) (follows array's priority)
-     *  \param Count of elements in the char array
+    /** Holds an unchanged copy of the last entered formula, compiled so that it can be calculated again
+     *  without being parsed - \ref FormulaProgram. Shared with the formulas filled from it.
      */
-    int seekFirstOperation(const std::string& str, char ch[], size_t charCount);
+    std::shared_ptr<const Template> template_;
 
-    /** Finds the first occurrence of a wanted char.
-     *  \n Used by \ref calculateFormulaRecursively
-     *
-     *  \param String to search the wanted char.
-     *  \param A char array of wanted strings (will return the first time it finds at least one match) (follows array's priority)
-     *  \param Count of elements in the char array
-     */
-    int seekLastOperation(const std::string& str, char ch[], size_t charCount);
-
-    /** Given a position in 2D coordinates (row and column), returns the value on that position according to
-     *  the provided table. The following calculate dependencies apply:
-     *  \li 1) empty cell (or one outside of the provided table) is considered 0
-     *  \li 2) string cells are considered as 0, even if they have number value
-     *  \li 3) formula cells with errors share the error in this formula as well
-     *  \li 4) int, double and formula without error gives right away the value they hold
-     *
-     *  \param Wanted row to get value from
-     *  \param Wanted column to get value from
-     *  \return wanted result as casted to a floating number
-     */
-    double extractCellValue(size_t row, size_t column);
-
-    /** Given a string with an algebraic expression, this function analyzes it,
-     *  determines operation priorities and smartly divide the problem into 2
-     *  smaller problems which are again sent to this function to calculate them until
-     *  an operand is reached. The following algorithm is applied
-     *  \li 1) Start searching operations, where it first searches low priority, then high priority ones
-     *  \li 1.1) When found, the entire string is split into 2 halves, without the operation itself
-     *  \li 2) Then calls the algorithm on the 2 separated parts, gets the value from them and
-     *  \li performs the appropriate operation on the parts
-     *  \note Uses mathematically proven and tested methods to get the correct answer
-     *  NOTE: This recursion depends on certain string rules to work properly, like:
-     *  \li 1) provided string is entirely whitespace trimmed - \ref trimEntirely
-     *  \li 2) if provided string contains references in table, they need to be calculated - \ref extractCellValue
-     *  \li 3) used operands and operations are appropriately used (otherwise throws exception)
-     *
-     *  \exception invalid_argument - thrown if the expression is invalid. Can be thrown if:
-     *  \li brackets without any expression in it is contained in the expression
-     *  \li An operation does not have the required number of operands
-     *
-     *  \param expression to calculate
-     *  \return wanted result casted to a floating number
+    /** How far this formula is from the cell its template was written for. Every reference is moved by it.
      */
-    double calculateFormulaRecursively(const std::string& value);
+    int64_t rowOffset_ = 0;
+    int64_t columnOffset_ = 0;
 
-    /** Given a string with an algebraic expression, this function makes sure the
-     *  expression is correct and properly formatted, so that it can call the following recursive
-     *  function \ref calculateFormulaRecursively can use its result as an wanted result.
-     *
-     *  \exception invalid_argument - thrown if the expression is invalid. This includes:
-     *  wrong use of brackets (unequal count of opening and closing ones as well as having
-     *  more closing than opening brackets at some time
-     *
-     *  \param expression to calculate
-     *  \return wanted result casted to a floating number
+    /** Holds the last calculated result in a formula, so that it does not need to calculate it again
      */
-    double calculateFormula(const std::string& value);
+    double result_;
 
-    /** Given a string which is supposed to represent a floating number, this function changes it,
-     *  so that it does not have and exceed zeroes at the end of the floating part. Does not
-     *  check whether the string is actually a floating number.
+    /** Why the last calculation was unsuccessful, Error::None if it was successful.
      */
-    void trimZeroes(std::string& str);
+    FormulaProgram::Error error_ = FormulaProgram::Error::None;
 
 public:
 
@@ -145,25 +88,78 @@ public:
      */
     CellFormula(const Table* tableRef, const std::string& value);
 
+    /** Constructor for a formula which has already been compiled and calculated, e.g. one read
+     *  from a file. Does not calculate anything.
+     *
+     *  \exception invalid_argument - if the Table pointer is null or value is not a formula.
+     *  \param tableRef pointer to the Table class
+     *  \param value the formula
+     *  \param program the formula compiled - \ref FormulaProgram::compile
+     *  \param result last calculated result
+     *  \param error why the last calculation failed, Error::None if it did not
+     */
+    CellFormula(const Table* tableRef, const std::string& value, const FormulaProgram& program, double result,
+                FormulaProgram::Error error);
+
+    /** Constructor for a formula sharing a template, e.g. one filled from another formula or read from a file.
+     *  Does not calculate anything.
+     *
+     *  \exception invalid_argument - if the Table pointer or the template is null.
+     *  \param tableRef pointer to the Table class
+     *  \param shared the template - \ref getTemplate
+     *  \param rowOffset, columnOffset how far this formula is from the cell the template was written for
+     *  \param result last calculated result
+     *  \param error why the last calculation failed, Error::None if it did not
+     */
+    CellFormula(const Table* tableRef, const std::shared_ptr<const Template>& shared, int64_t rowOffset,
+                int64_t columnOffset, double result, FormulaProgram::Error error);
+
     /** Copy constructor
      *  \param object of type CellFormula to copy from
      */
     CellFormula(const CellFormula& copy);
 
-    /** Every instance of this class holds a value of type double. This method returns it.
+    /** Replaces the formula, compiles it and calculates it.
      *
-     * \return Current instance's hold value of type double
+     *  \exception invalid_argument - if the value is not a formula (does not start with '=').
+     *  A formula which cannot be calculated only sets the error flag.
      */
     void setValue(const std::string& value);
 
+    /** Changes the table this formula takes the referenced cells from. Used when the formula
+     *  is copied together with its table. Does not recalculate the formula.
+     *
+     *  \exception invalid_argument - if the Table pointer is null.
+     *  \param pointer to the Table class
+     */
+    void setTable(const Table* tableRef);
+
     /** \return last calculated result of the formula
      */
-    double getValue();
+    double getValue() const;
 
     /** \return recalculates last remembered formula
      */
     void recalculate();
 
+    /** Sets the error #CYCLE without calculating the formula. Used by the table for formulas which
+     *  refer to themselves, directly or through other formulas.
+     */
+    void markCircular();
+
+    /** Sets the result without calculating the formula, e.g. a result remembered in a file
+     *  together with the cells it was calculated from - \ref ResultSidecar
+     */
+    void restoreResult(double result, FormulaProgram::Error error);
+
+    /** Finds every reference to a cell (e.g. A0) and every range (e.g. A0:B10) in the compiled
+     *  formula, without calculating it. Used by the table to know which formulas depend on which cells.
+     *  \n A formula which could not be compiled refers to nothing.
+     *
+     *  \param references receives every reference, as a range of 1 cell, and every range
+     */
+    void collectReferences(std::vector<Table::Range>& references) const;
+
     /** As a child of Cell, this method can be called by a Cell pointer to get
      *  the direct pointer to instance of this class.
      *
@@ -182,9 +178,40 @@ public:
      */
     std::string getConstructString();
 
+    /** Formats the last calculated result into the buffer, or returns a view of the error text
+     *  (e.g. #DIV/0) - \ref FormulaProgram::errorText
+     *  \return view of the displayable result
+     */
+    std::string_view getDisplayableView(std::string& buffer) const;
+
+    /** \return view of the last remembered raw formula. The formula of a cell filled from another one is
+     *  written into the buffer with its references moved, reusing the buffer's capacity - \ref FormulaProgram::shiftReferences
+     */
+    std::string_view getConstructView(std::string& buffer) const;
+
     /** Returns whether the entered formula was successfully calculated.
      */
-    bool error();
+    bool error() const;
+
+    /** \return why the last calculation was unsuccessful, Error::None if it was successful
+     */
+    FormulaProgram::Error errorCode() const;
+
+    /** \return the compiled formula. Its references are not moved by the offsets - \ref rowOffset
+     */
+    const FormulaProgram& program() const;
+
+    /** \return text and program shared with the formulas filled from this one
+     */
+    const std::shared_ptr<const Template>& getTemplate() const;
+
+    /** \return how many rows this formula is below the cell its template was written for
+     */
+    int64_t rowOffset() const;
+
+    /** \return how many columns this formula is right of the cell its template was written for
+     */
+    int64_t columnOffset() const;
 
     /** Checks whether a string represents a correct formula format. It still can have error, though.
      */
@@ -195,6 +222,10 @@ public:
      */
     CellFormula* clone() const;
 
+    /** Adds this object and its template, unless another formula sharing it was counted - \ref Template - \ref Cell::addMemoryUsage
+     */
+    void addMemoryUsage(MemoryUsage& usage) const;
+
 };
 
 
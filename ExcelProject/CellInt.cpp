@@ -1,3 +1,4 @@
+#include <charconv>
 #include "CellInt.h"
 
 CellInt::CellInt(){
@@ -9,6 +10,10 @@ CellInt::CellInt(const std::string& value){
     setValue(value);
 }
 
+CellInt::CellInt(int value){
+    int_ = value;
+}
+
 CellInt::CellInt(const CellInt& copy){
     int_ = copy.int_;
 }
@@ -47,10 +52,27 @@ std::string CellInt::getConstructString(){
     return getDisplayableString();
 }
 
-int CellInt::getValue(){
+std::string_view CellInt::getDisplayableView(std::string& buffer) const{
+    char digits[16];
+    std::to_chars_result res = std::to_chars(digits, digits + sizeof(digits), int_);
+    buffer.assign(digits, res.ptr - digits);
+    return buffer;
+}
+
+std::string_view CellInt::getConstructView(std::string& buffer) const{
+    return getDisplayableView(buffer);
+}
+
+int CellInt::getValue() const{
     return int_;
 }
 
 CellInt* CellInt::clone() const{
     return new CellInt(*this);
 }
+
+void CellInt::addMemoryUsage(MemoryUsage& usage) const{
+    usage.ints.count++;
+    usage.ints.bytes += sizeof(CellInt);
+    usage.blocks++;
+}
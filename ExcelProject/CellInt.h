@@ -30,6 +30,11 @@ public:
      */
     CellInt(const std::string& value);
 
+    /** Constructor which builds an object with an initial value
+     *  \param initial integer value
+     */
+    CellInt(int value);
+
     /** Copy constructor
      *  \param object of type CellInt to copy from
      */
@@ -47,7 +52,7 @@ public:
      *
      *  \return Current instance's hold value of type int
      */
-    int getValue();
+    int getValue() const;
 
     /** As a child of Cell, this method can be called by a Cell pointer to get
      *  the direct pointer to instance of this class.
@@ -66,6 +71,15 @@ public:
      */
     std::string getConstructString();
 
+    /** Formats the current value into the buffer the same way \ref getDisplayableString does.
+     *  \return view of the buffer
+     */
+    std::string_view getDisplayableView(std::string& buffer) const;
+
+    /** \return same as \ref getDisplayableView
+     */
+    std::string_view getConstructView(std::string& buffer) const;
+
     /** Checks whether a string represents a valid integer.
      *  \exception out_of_range if the provided string is too large to fit in an int -
      *  \link check https://www.cplusplus.com/reference/string/stoi/
@@ -77,6 +91,10 @@ public:
      */
     CellInt* clone() const;
 
+    /** Adds this object - \ref Cell::addMemoryUsage
+     */
+    void addMemoryUsage(MemoryUsage& usage) const;
+
 };
 
 
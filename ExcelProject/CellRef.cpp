@@ -0,0 +1,134 @@
+#include <stdexcept>
+#include "CellRef.h"
+
+namespace{
+
+/** For every char: 1..26 for letters (of both cases), 32..41 for digits, 0 for anything else */
+struct CharClasses{
+    unsigned char value[256];
+
+    constexpr CharClasses() : value(){
+        for(int ch = 'A'; ch <= 'Z'; ch++){
+            value[ch] = ch - 'A' + 1;
+            value[ch - 'A' + 'a'] = ch - 'A' + 1;
+        }
+        for(int ch = '0'; ch <= '9'; ch++){
+            value[ch] = 32 + ch - '0';
+        }
+    }
+};
+
+constexpr CharClasses charClasses;
+
+constexpr unsigned char DIGIT = 32;
+
+}
+
+CellRef::CellRef(){
+    packed_ = 0;
+}
+
+CellRef::CellRef(size_t row, size_t column){
+    packed_ = ((uint64_t)row << 32) | (uint32_t)column;
+}
+
+CellRef CellRef::fromKey(uint64_t key){
+    CellRef ref;
+    ref.packed_ = key;
+    return ref;
+}
+
+CellRef CellRef::fromString(std::string_view text){
+    CellRef ref;
+    if(!parse(text, ref)){
+        throw std::invalid_argument("Invalid position format: " + std::string(text));
+    }
+    return ref;
+}
+
+size_t CellRef::parsePrefix(std::string_view text, CellRef& ref){
+    const unsigned char* chars = (const unsigned char*)text.data();
+    size_t size = text.size();
+    size_t i = 0;
+
+    // letters - at most 3 of them, XFD is the last column. A 4th letter leaves no digits after them
+    uint64_t column = 0;
+    while(i < size && i < 3){
+        unsigned char value = charClasses.value[chars[i]];
+        if(value == 0 || value >= DIGIT){
+            break;
+        }
+        column = column * 26 + value;
+        i++;
+    }
+    if(i == 0 || column > MAX_COLUMNS){
+        return 0;
+    }
+
+    // digits - at most 10 of them, the row must fit into 32 bits. An 11th digit is rejected below
+    // as a part of a longer word
+    size_t digitsStart = i;
+    uint64_t row = 0;
+    while(i < size && i - digitsStart < 10){
+        unsigned char value = charClasses.value[chars[i]];
+        if(value < DIGIT){
+            break;
+        }
+        row = row * 10 + (value - DIGIT);
+        i++;
+    }
+    if(i == digitsStart || row > LAST_ROW){
+        return 0;
+    }
+
+    // a position cannot be a part of a longer word
+    if(i < size && charClasses.value[chars[i]] != 0){
+        return 0;
+    }
+
+    ref = CellRef(row, column - 1);
+    return i;
+}
+
+bool CellRef::parse(std::string_view text, CellRef& ref){
+    return !text.empty() && parsePrefix(text, ref) == text.size();
+}
+
+void CellRef::appendColumnName(size_t column, std::string& result){
+    char letters[16];
+    size_t count = 0;
+    // bijective base 26 - there's no letter for zero
+    for(size_t value = column + 1; value > 0; value = (value - 1) / 26){
+        letters[count++] = (char)('A' + (value - 1) % 26);
+    }
+    while(count > 0){
+        result += letters[--count];
+    }
+}
+
+size_t CellRef::row() const{
+    return packed_ >> 32;
+}
+
+size_t CellRef::column() const{
+    return packed_ & 0xFFFFFFFF;
+}
+
+uint64_t CellRef::key() const{
+    return packed_;
+}
+
+std::string CellRef::toString() const{
+    std::string result;
+    appendColumnName(column(), result);
+    result += std::to_string(row());
+    return result;
+}
+
+bool CellRef::operator==(const CellRef& other) const{
+    return packed_ == other.packed_;
+}
+
+bool CellRef::operator!=(const CellRef& other) const{
+    return packed_ != other.packed_;
+}
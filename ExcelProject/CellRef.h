@@ -0,0 +1,92 @@
+#ifndef CELL_REF_H
+#define CELL_REF_H
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/** CellRef is the position of a cell - its row and column packed into a single 64-bit word
+ *  (row in the upper 32 bits, column in the lower 32 bits), so it can be copied, compared and
+ *  used as a key as cheaply as an integer.
+ *  \n In text a position is written as column letters followed by the row number, e.g. A0, AB12 or XFD1048575.
+ *  Columns are named A..Z, AA..ZZ, AAA..XFD (16384 columns), letters are case insensitive, rows start from 0.
+ *  \n This class allows:
+ *  \li parse a position in a single pass over the text - \ref parse and \ref parsePrefix
+ *  \li get the row and the column - \ref row and \ref column
+ *  \li write the position or only the name of a column - \ref toString and \ref appendColumnName
+ */
+class CellRef{
+private:
+
+    /** Row in the upper 32 bits, column in the lower 32 bits */
+    uint64_t packed_;
+
+public:
+
+    /** Count of columns which can be written as letters (A..XFD) */
+    static constexpr size_t MAX_COLUMNS = 16384;
+
+    /** Last row which fits into a position, rows start from 0 */
+    static constexpr size_t LAST_ROW = 0xFFFFFFFFULL;
+
+    /** Position A0
+     */
+    CellRef();
+
+    /** Position of the cell on row and column. The row is expected to be at most \ref LAST_ROW
+     *  and the column below \ref MAX_COLUMNS
+     */
+    CellRef(size_t row, size_t column);
+
+    /** \return position from the value returned by \ref key
+     */
+    static CellRef fromKey(uint64_t key);
+
+    /** Parses a position written in text (e.g. B12) - \ref parsePrefix
+     *
+     *  \exception invalid_argument the whole text is not a valid position
+     */
+    static CellRef fromString(std::string_view text);
+
+    /** Parses a position at the beginning of the text in a single pass. Letters and digits are
+     *  recognized using a lookup table, so every char costs one load and a few additions.
+     *
+     *  \param text text starting with a position
+     *  \param ref receives the position if one is found
+     *  \return count of chars the position takes, 0 if the text does not start with a valid position.
+     *  A position must not be followed directly by another letter or digit.
+     */
+    static size_t parsePrefix(std::string_view text, CellRef& ref);
+
+    /** \return whether the whole text is a valid position - \ref parsePrefix
+     */
+    static bool parse(std::string_view text, CellRef& ref);
+
+    /** Appends the name of a column (e.g. A, Z, AA, XFD) at the end of a string
+     */
+    static void appendColumnName(size_t column, std::string& result);
+
+    /** \return row of the cell
+     */
+    size_t row() const;
+
+    /** \return column of the cell
+     */
+    size_t column() const;
+
+    /** \return row and column packed into one number
+     */
+    uint64_t key() const;
+
+    /** \return position written in text (e.g. AB12)
+     */
+    std::string toString() const;
+
+    bool operator==(const CellRef& other) const;
+    bool operator!=(const CellRef& other) const;
+
+};
+
+
+#endif // CELL_REF_H
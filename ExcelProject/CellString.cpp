@@ -39,6 +39,14 @@ std::string CellString::getConstructString(){
     return string_;
 }
 
+std::string_view CellString::getDisplayableView(std::string& buffer) const{
+    return std::string_view(string_).substr(1, string_.size() - 2);
+}
+
+std::string_view CellString::getConstructView(std::string& buffer) const{
+    return string_;
+}
+
 /*std::string CellString::getPureString(){
     return value_.substr(1, value_.size() - 2);
 }*/
@@ -46,3 +54,11 @@ std::string CellString::getConstructString(){
 CellString* CellString::clone() const{
     return new CellString(*this);
 }
+
+void CellString::addMemoryUsage(MemoryUsage& usage) const{
+    usage.strings.count++;
+    usage.strings.bytes += sizeof(CellString);
+    uint64_t payload = MemoryUsage::heapBytes(string_);
+    usage.stringPayloads += payload;
+    usage.blocks += 1 + (payload != 0);
+}
@@ -62,6 +62,15 @@ public:
      */
     std::string getConstructString();
 
+    /** \return view of the string this object holds, without the surrounding quotes.
+     *  Does not use the buffer.
+     */
+    std::string_view getDisplayableView(std::string& buffer) const;
+
+    /** \return view of the whole stored string, including the quotes. Does not use the buffer.
+     */
+    std::string_view getConstructView(std::string& buffer) const;
+
     /** Checks whether a string represents a valid string according to the validation standarts
      *  of this class. A string is considered valid if:
      *  It is surrounded by double quotes (")
@@ -73,6 +82,10 @@ public:
      */
     CellString* clone() const;
 
+    /** Adds this object and the text of the string - \ref Cell::addMemoryUsage
+     */
+    void addMemoryUsage(MemoryUsage& usage) const;
+
 };
 
 
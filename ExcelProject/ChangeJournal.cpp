@@ -0,0 +1,430 @@
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define JOURNAL_FSYNC
+#endif
+
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <vector>
+
+#include "ChangeJournal.h"
+
+namespace{
+
+const char MAGIC[8] = {'X', 'T', 'J', 'N', '\r', '\n', 0x1A, 0};
+const uint32_t VERSION = 1;
+
+struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fingerprint;       /**< of the base */
+    uint64_t baseChanges;       /**< number of the first change in the journal */
+};
+
+/** Precedes the payload of every record. A record which was not written entirely has a wrong checksum
+ */
+struct RecordHeader{
+    uint32_t size;              /**< bytes of the payload */
+    uint32_t checksum;          /**< lower half of the FNV-1a hash of the payload */
+};
+
+/** First byte of the payload
+ */
+enum Kind : uint8_t{
+    SET = 1,                    /**< row, column, the value until the end */
+    FILL = 2,                   /**< the 6 positions of Table::fill */
+    COMMIT = 3,                 /**< nothing else */
+    CHECKPOINT = 4              /**< fingerprint of the new base, number of its first change not in it */
+};
+
+struct Record{
+    Kind kind;
+    uint64_t number;            /**< of the change, for other records of the next change */
+    uint32_t positions[6];
+    uint64_t fingerprint;
+    uint64_t changes;
+    std::string value;
+    size_t start;               /**< offset of the record in the journal */
+    size_t end;                 /**< offset after the record */
+};
+
+uint64_t fnv(const char* data, size_t size, uint64_t value = 0xcbf29ce484222325ULL){
+    for(size_t i = 0; i < size; i++){
+        value = (value ^ (unsigned char)data[i]) * 0x100000001b3ULL;
+    }
+    return value;
+}
+
+template<typename T>
+void put(std::string& payload, T value){
+    payload.append((const char*)&value, sizeof(value));
+}
+
+template<typename T>
+bool take(const std::string& payload, size_t& offset, T& value){
+    if(offset + sizeof(value) > payload.size()){
+        return false;
+    }
+    memcpy(&value, payload.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+std::string encodeRecord(const std::string& payload){
+    RecordHeader header;
+    header.size = payload.size();
+    header.checksum = (uint32_t)fnv(payload.data(), payload.size());
+    std::string record((const char*)&header, sizeof(header));
+    return record + payload;
+}
+
+/** Reads the records of a journal until its end or until a record which was not written entirely
+ *
+ *  \return false if the content is not a journal
+ */
+bool readJournal(const std::string& content, FileHeader& header, std::vector<Record>& records){
+    if(content.size() < sizeof(header)){
+        return false;
+    }
+    memcpy(&header, content.data(), sizeof(header));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION){
+        return false;
+    }
+
+    uint64_t number = header.baseChanges;
+    size_t offset = sizeof(header);
+    while(offset + sizeof(RecordHeader) <= content.size()){
+        RecordHeader recordHeader;
+        memcpy(&recordHeader, content.data() + offset, sizeof(recordHeader));
+        size_t payloadStart = offset + sizeof(recordHeader);
+        if(recordHeader.size == 0 || recordHeader.size > content.size() - payloadStart ||
+           (uint32_t)fnv(content.data() + payloadStart, recordHeader.size) != recordHeader.checksum){
+            break;
+        }
+        std::string payload = content.substr(payloadStart, recordHeader.size);
+
+        Record record;
+        record.kind = (Kind)payload[0];
+        record.number = number;
+        record.start = offset;
+        record.end = payloadStart + recordHeader.size;
+        size_t read = 1;
+        bool valid = true;
+        if(record.kind == SET){
+            valid = take(payload, read, record.positions[0]) && take(payload, read, record.positions[1]);
+            record.value = payload.substr(std::min(read, payload.size()));
+            number++;
+        }else if(record.kind == FILL){
+            for(size_t i = 0; i < 6 && valid; i++){
+                valid = take(payload, read, record.positions[i]);
+            }
+            number++;
+        }else if(record.kind == CHECKPOINT){
+            valid = take(payload, read, record.fingerprint) && take(payload, read, record.changes);
+        }else if(record.kind != COMMIT){
+            valid = false;
+        }
+        if(!valid){
+            break;
+        }
+        records.push_back(record);
+        offset = record.end;
+    }
+    return true;
+}
+
+}
+
+ChangeJournal::ChangeJournal(const std::string& filename) : filename_(filename){
+}
+
+ChangeJournal::~ChangeJournal(){
+    if(file_ != nullptr){
+        sync();
+        std::fclose(file_);
+    }
+}
+
+std::string ChangeJournal::pathFor(const std::string& filename){
+    return filename + EXTENSION;
+}
+
+uint64_t ChangeJournal::fingerprint(const std::string& filename){
+    std::ifstream readFile(filename, std::ios::binary);
+    if(!readFile.is_open()){
+        return 0;
+    }
+    uint64_t value = fnv(nullptr, 0);
+    std::vector<char> buffer(1 << 16);
+    while(readFile.read(buffer.data(), buffer.size()) || readFile.gcount() > 0){
+        value = fnv(buffer.data(), readFile.gcount(), value);
+    }
+    return value;
+}
+
+void ChangeJournal::remove(const std::string& filename){
+    std::remove(pathFor(filename).c_str());
+}
+
+void ChangeJournal::writeHeader(std::FILE* file, uint64_t fingerprint, uint64_t baseChanges){
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.fingerprint = fingerprint;
+    header.baseChanges = baseChanges;
+    if(std::fwrite(&header, sizeof(header), 1, file) != 1){
+        throw std::invalid_argument("Unexpected error while writing the journal. ");
+    }
+}
+
+std::shared_ptr<ChangeJournal> ChangeJournal::open(const std::string& filename, Table& table, bool create,
+                                                   Recovery& recovery){
+    std::shared_ptr<ChangeJournal> journal(new ChangeJournal(filename));
+    uint64_t base = fingerprint(filename);
+    std::ifstream readFile(pathFor(filename), std::ios::binary);
+    if(readFile.is_open()){
+        recovery.found = true;
+        std::string content((std::istreambuf_iterator<char>(readFile)), std::istreambuf_iterator<char>());
+        readFile.close();
+
+        FileHeader header = {};
+        std::vector<Record> records;
+        bool valid = readJournal(content, header, records);
+        // a new base which replaced the old one before the journal was restarted is found by its checkpoint
+        uint64_t start = header.baseChanges;
+        recovery.matched = valid && header.fingerprint == base;
+        for(size_t i = records.size(); i > 0 && valid && !recovery.matched; i--){
+            if(records[i - 1].kind == CHECKPOINT && records[i - 1].fingerprint == base){
+                start = records[i - 1].changes;
+                recovery.matched = true;
+            }
+        }
+
+        if(recovery.matched){
+            journal->baseChanges_ = header.baseChanges;
+            journal->changes_ = header.baseChanges;
+            journal->savedChanges_ = header.baseChanges;
+            journal->size_ = sizeof(header);
+            journal->savedSize_ = sizeof(header);
+            for(const Record& record : records){
+                if(record.kind == SET || record.kind == FILL){
+                    journal->changes_ = record.number + 1;
+                }else if(record.kind == COMMIT){
+                    journal->savedChanges_ = record.number;
+                    journal->savedSize_ = record.end;
+                }
+                journal->size_ = record.end;
+                if(record.number < start || (record.kind != SET && record.kind != FILL)){
+                    continue;
+                }
+                try{
+                    const uint32_t* p = record.positions;
+                    if(record.kind == SET){
+                        table.setCellValue(p[0], p[1], record.value);
+                    }else{
+                        table.fill(p[0], p[1], p[2], p[3], p[4], p[5]);
+                    }
+                    recovery.changes++;
+                }catch(std::invalid_argument&){
+                    recovery.failed++;
+                }
+            }
+            recovery.unsaved = journal->changes_ - std::max(journal->savedChanges_, start);
+
+            // a record which was not written entirely would hide the ones appended after it
+            std::error_code error;
+            if(journal->size_ < content.size()){
+                std::filesystem::resize_file(pathFor(filename), journal->size_, error);
+            }
+            journal->file_ = std::fopen(pathFor(filename).c_str(), "ab");
+            if(error || journal->file_ == nullptr){
+                throw std::invalid_argument("Journal " + pathFor(filename) + " cannot be written. ");
+            }
+            if(start != header.baseChanges){
+                journal->restart(base, start);
+            }
+            return journal;
+        }
+        remove(filename);
+    }
+
+    if(!create){
+        return nullptr;
+    }
+    journal->file_ = std::fopen(pathFor(filename).c_str(), "wb");
+    if(journal->file_ == nullptr){
+        throw std::invalid_argument("Journal " + pathFor(filename) + " cannot be created. ");
+    }
+    writeHeader(journal->file_, base, 0);
+    journal->baseChanges_ = 0;
+    journal->changes_ = 0;
+    journal->savedChanges_ = 0;
+    journal->size_ = sizeof(FileHeader);
+    journal->savedSize_ = sizeof(FileHeader);
+    journal->sync();
+    return journal;
+}
+
+void ChangeJournal::append(const std::string& payload, bool sync){
+    std::string record = encodeRecord(payload);
+    // written to the system right away, so that only a failure of the whole system can lose it
+    if(file_ == nullptr || std::fwrite(record.data(), 1, record.size(), file_) != record.size() ||
+       std::fflush(file_) != 0){
+        throw std::invalid_argument("Unexpected error while writing the journal. ");
+    }
+    size_ += record.size();
+    unsynced_++;
+    if(sync || unsynced_ >= SYNC_BATCH){
+        this->sync();
+    }
+}
+
+void ChangeJournal::sync(){
+    if(file_ == nullptr){
+        return;
+    }
+    std::fflush(file_);
+#ifdef JOURNAL_FSYNC
+    fsync(fileno(file_));
+#endif
+    unsynced_ = 0;
+}
+
+void ChangeJournal::recordSet(size_t row, size_t column, const std::string& value){
+    std::string payload;
+    put<uint8_t>(payload, SET);
+    put<uint32_t>(payload, row);
+    put<uint32_t>(payload, column);
+    payload += value;
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(payload, false);
+    changes_++;
+}
+
+void ChangeJournal::recordFill(size_t sourceRow, size_t sourceColumn, size_t fromRow, size_t fromColumn,
+                               size_t toRow, size_t toColumn){
+    std::string payload;
+    put<uint8_t>(payload, FILL);
+    for(size_t position : {sourceRow, sourceColumn, fromRow, fromColumn, toRow, toColumn}){
+        put<uint32_t>(payload, position);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(payload, false);
+    changes_++;
+}
+
+void ChangeJournal::commit(){
+    std::string payload;
+    put<uint8_t>(payload, COMMIT);
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(payload, true);
+    savedChanges_ = changes_;
+    savedSize_ = size_;
+}
+
+void ChangeJournal::dropUnsaved(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(size_ == savedSize_){
+        return;
+    }
+    if(file_ != nullptr){
+        std::fclose(file_);
+    }
+    std::error_code error;
+    std::filesystem::resize_file(pathFor(filename_), savedSize_, error);
+    file_ = std::fopen(pathFor(filename_).c_str(), "ab");
+    if(error || file_ == nullptr){
+        throw std::invalid_argument("Unexpected error while changing the journal. ");
+    }
+    changes_ = savedChanges_;
+    size_ = savedSize_;
+}
+
+uint64_t ChangeJournal::baseChanges(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    return baseChanges_;
+}
+
+uint64_t ChangeJournal::savedChanges(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    return savedChanges_;
+}
+
+void ChangeJournal::checkpoint(uint64_t fingerprint, uint64_t changes){
+    std::string payload;
+    put<uint8_t>(payload, CHECKPOINT);
+    put<uint64_t>(payload, fingerprint);
+    put<uint64_t>(payload, changes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(payload, true);
+}
+
+void ChangeJournal::restart(uint64_t fingerprint, uint64_t changes){
+    std::lock_guard<std::mutex> lock(mutex_);
+    sync();
+    std::ifstream readFile(pathFor(filename_), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(readFile)), std::istreambuf_iterator<char>());
+    readFile.close();
+    FileHeader header = {};
+    std::vector<Record> records;
+    if(!readJournal(content, header, records)){
+        throw std::invalid_argument("Journal " + pathFor(filename_) + " is damaged. ");
+    }
+
+    const std::string temporary = pathFor(filename_) + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if(file == nullptr){
+        throw std::invalid_argument("Journal " + pathFor(filename_) + " cannot be written. ");
+    }
+    uint64_t size = sizeof(FileHeader);
+    uint64_t savedSize = size;
+    std::string kept;
+    for(const Record& record : records){
+        // saving the changes before the new base means nothing anymore
+        bool change = record.kind == SET || record.kind == FILL;
+        if(record.number < changes || (record.kind == COMMIT && record.number == changes) || record.kind == CHECKPOINT){
+            continue;
+        }
+        kept.append(content, record.start, record.end - record.start);
+        if(!change){
+            savedSize = size + kept.size();
+        }
+    }
+    bool written = true;
+    try{
+        writeHeader(file, fingerprint, changes);
+    }catch(std::invalid_argument&){
+        written = false;
+    }
+    written = written && std::fwrite(kept.data(), 1, kept.size(), file) == kept.size() && std::fflush(file) == 0;
+#ifdef JOURNAL_FSYNC
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    written = std::fclose(file) == 0 && written;
+    if(!written){
+        std::remove(temporary.c_str());
+        throw std::invalid_argument("Journal " + pathFor(filename_) + " cannot be written. ");
+    }
+
+    if(file_ != nullptr){
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if(std::rename(temporary.c_str(), pathFor(filename_).c_str()) != 0){
+        // systems which do not rename over an existing file
+        std::remove(pathFor(filename_).c_str());
+        std::rename(temporary.c_str(), pathFor(filename_).c_str());
+    }
+    file_ = std::fopen(pathFor(filename_).c_str(), "ab");
+    if(file_ == nullptr){
+        throw std::invalid_argument("Journal " + pathFor(filename_) + " cannot be written. ");
+    }
+    baseChanges_ = changes;
+    size_ = size + kept.size();
+    savedSize_ = savedChanges_ > changes ? savedSize : sizeof(FileHeader);
+    unsynced_ = 0;
+}
@@ -0,0 +1,159 @@
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Table.h"
+
+/** ChangeJournal remembers the changes of the cells of an opened file in a separate file next to it (the name
+ *  of the file followed by \ref EXTENSION), so that saving them takes time proportional to the count of changes,
+ *  not to the size of the table.
+ *  \n Every change is appended as a small binary record right away and the journal is flushed to the disk
+ *  after every \ref SYNC_BATCH records. Saving appends a record marking every change so far as saved - \ref commit.
+ *  The file itself (the base) is rewritten with the changes only now and then - \ref checkpoint and \ref restart.
+ *  \n Opening a file with a journal replays the changes into the table loaded from the base - \ref open. Changes
+ *  which were not saved (the program ended without closing the file) are replayed too, but remain unsaved.
+ *  \n The journal knows its base by the fingerprint of its content, so a journal of a base changed by another
+ *  program is not replayed. Every change has a number counted from the first change since the journal
+ *  was created; the base includes every change before \ref baseChanges.
+ *  \n Every method can be called by any thread.
+ */
+class ChangeJournal{
+public:
+
+    /** Appended to the name of the file
+     */
+    static constexpr const char* EXTENSION = ".journal";
+
+    /** Count of changes flushed to the disk at once, unless saved earlier
+     */
+    static constexpr size_t SYNC_BATCH = 64;
+
+    /** What \ref open found next to the file
+     */
+    struct Recovery{
+        bool found = false;         /**< the file had a journal */
+        bool matched = false;       /**< the journal was written for this content of the file */
+        size_t changes = 0;         /**< count of replayed changes */
+        size_t unsaved = 0;         /**< count of replayed changes which were not saved */
+        size_t failed = 0;          /**< count of changes which could not be replayed */
+    };
+
+private:
+
+    std::string filename_;
+    std::FILE* file_ = nullptr;
+    std::mutex mutex_;
+
+    uint64_t baseChanges_;          /**< number of the first change which is not in the base */
+    uint64_t changes_;              /**< number of the next change */
+    uint64_t savedChanges_;         /**< number of the first change which is not saved */
+    uint64_t size_;                 /**< bytes of the journal */
+    uint64_t savedSize_;            /**< bytes of the journal up to the last saved change */
+    size_t unsynced_ = 0;           /**< changes not yet flushed to the disk */
+
+    ChangeJournal(const std::string& filename);
+
+    /** Writes the header of a journal of a base into an empty file
+     *
+     *  \exception invalid_argument the file cannot be written
+     */
+    static void writeHeader(std::FILE* file, uint64_t fingerprint, uint64_t baseChanges);
+
+    /** Appends one record and flushes it to the disk if requested or if the batch is full
+     *
+     *  \exception invalid_argument the record cannot be written
+     */
+    void append(const std::string& payload, bool sync);
+
+    /** Flushes every appended record to the disk
+     */
+    void sync();
+
+public:
+
+    ~ChangeJournal();
+
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    /** \return name of the journal of a file
+     */
+    static std::string pathFor(const std::string& filename);
+
+    /** \return 64-bit FNV-1a hash of the content of a file, 0 if it cannot be read
+     */
+    static uint64_t fingerprint(const std::string& filename);
+
+    /** Deletes the journal of a file, if there's such
+     */
+    static void remove(const std::string& filename);
+
+    /** Starts to journal the changes of a file which was just loaded into the table. The changes from an existing
+     *  journal of the file are replayed into the table first. A journal written for another content of the file
+     *  is removed instead - \ref Recovery::matched
+     *
+     *  \param create whether to create a new journal if the file has none
+     *  \param recovery receives what was found
+     *  \return the journal, nullptr if the file has none and none should be created
+     *  \exception invalid_argument the journal cannot be written
+     */
+    static std::shared_ptr<ChangeJournal> open(const std::string& filename, Table& table, bool create,
+                                               Recovery& recovery);
+
+    /** Appends a change made by \ref Table::setCellValue
+     *
+     *  \exception invalid_argument the change cannot be written
+     */
+    void recordSet(size_t row, size_t column, const std::string& value);
+
+    /** Appends a change made by \ref Table::fill
+     *
+     *  \exception invalid_argument the change cannot be written
+     */
+    void recordFill(size_t sourceRow, size_t sourceColumn, size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn);
+
+    /** Marks every change so far as saved and flushes the journal to the disk
+     *
+     *  \exception invalid_argument the journal cannot be written
+     */
+    void commit();
+
+    /** Forgets the changes which were not saved
+     *
+     *  \exception invalid_argument the journal cannot be changed
+     */
+    void dropUnsaved();
+
+    /** \return number of the first change which is not in the base
+     */
+    uint64_t baseChanges();
+
+    /** \return number of the first change which is not saved
+     */
+    uint64_t savedChanges();
+
+    /** Records that a new base with every change before a number was written, before the new base replaces
+     *  the old one. Until \ref restart, both of them can be opened with the journal.
+     *
+     *  \param fingerprint fingerprint of the new base - \ref fingerprint
+     *  \exception invalid_argument the journal cannot be written
+     */
+    void checkpoint(uint64_t fingerprint, uint64_t changes);
+
+    /** Forgets the changes included in the new base of the last \ref checkpoint, after it replaced the old base.
+     *  The journal is written anew, with the later changes only.
+     *
+     *  \exception invalid_argument the journal cannot be written
+     */
+    void restart(uint64_t fingerprint, uint64_t changes);
+
+};
+
+
+#endif // CHANGE_JOURNAL_H
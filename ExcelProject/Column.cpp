@@ -0,0 +1,586 @@
+#include <charconv>
+#include <limits>
+
+#include "Column.h"
+#include "CellInt.h"
+#include "CellDouble.h"
+#include "CellString.h"
+#include "CellFormula.h"
+
+bool Column::testBit(const std::vector<uint64_t>& bits, size_t row){
+    return (bits[row >> 6] >> (row & 63)) & 1;
+}
+
+void Column::setBit(std::vector<uint64_t>& bits, size_t row, bool value){
+    if(value){
+        bits[row >> 6] |= 1ULL << (row & 63);
+    }else{
+        bits[row >> 6] &= ~(1ULL << (row & 63));
+    }
+}
+
+void Column::copyBits(const std::vector<uint64_t>& source, size_t first, size_t count, uint64_t* destination){
+    size_t shift = first & 63;
+    size_t word = first >> 6;
+    for(size_t i = 0; i < (count + 63) / 64; i++){
+        uint64_t bits = source[word + i] >> shift;
+        if(shift != 0 && word + i + 1 < source.size()){
+            bits |= source[word + i + 1] << (64 - shift);
+        }
+        destination[i] = bits;
+    }
+    if(count % 64 != 0){
+        destination[count / 64] &= (1ULL << (count % 64)) - 1;
+    }
+}
+
+Column::Column(){
+    rowsCount_ = 0;
+    type_ = Type::Empty;
+}
+
+Column::Column(const Column& copy){
+    rowsCount_ = 0;
+    type_ = Type::Empty;
+    *this = copy;
+}
+
+Column::Column(Column&& other) noexcept
+    : rowsCount_(other.rowsCount_), type_(other.type_), ints_(std::move(other.ints_)),
+      doubles_(std::move(other.doubles_)), strings_(std::move(other.strings_)), validity_(std::move(other.validity_)),
+      hasCell_(std::move(other.hasCell_)), intRows_(std::move(other.intRows_)), cells_(std::move(other.cells_)), views_(std::move(other.views_)){
+    other.rowsCount_ = 0;
+    other.type_ = Type::Empty;
+}
+
+Column& Column::operator=(const Column& other){
+    if(this == &other){
+        return *this;
+    }
+    releaseCells();
+    rowsCount_ = other.rowsCount_;
+    type_ = other.type_;
+    ints_ = other.ints_;
+    doubles_ = other.doubles_;
+    strings_ = other.strings_;
+    validity_ = other.validity_;
+    hasCell_ = other.hasCell_;
+    intRows_ = other.intRows_;
+    cells_.assign(other.cells_.size(), nullptr);
+    for(size_t row = 0; row < cells_.size(); row++){
+        if(other.cells_[row] != nullptr){
+            cells_[row] = other.cells_[row]->clone();
+        }
+    }
+    views_.clear();
+    return *this;
+}
+
+Column::~Column(){
+    releaseCells();
+}
+
+void Column::releaseCells(){
+    for(size_t row = 0; row < cells_.size(); row++){
+        delete cells_[row];
+    }
+    for(size_t row = 0; row < views_.size(); row++){
+        delete views_[row];
+    }
+    cells_.clear();
+    views_.clear();
+}
+
+void Column::resize(size_t rows){
+    for(size_t row = rows; row < rowsCount_; row++){
+        erase(row);
+    }
+    rowsCount_ = rows;
+    size_t words = (rows + 63) / 64;
+    validity_.resize(words, 0);
+    hasCell_.resize(words, 0);
+    intRows_.resize(words, 0);
+    switch(type_){
+    case Type::Int:
+        ints_.resize(rows, 0);
+        break;
+    case Type::Double:
+        doubles_.resize(rows, 0);
+        break;
+    case Type::String:
+        strings_.resize(rows);
+        break;
+    default:
+        break;
+    }
+    if(!cells_.empty()){
+        cells_.resize(rows, nullptr);
+    }
+    if(views_.size() > rows){
+        views_.resize(rows);
+    }
+}
+
+size_t Column::rowsCount() const{
+    return rowsCount_;
+}
+
+Column::Type Column::type() const{
+    return type_;
+}
+
+void Column::dropView(size_t row){
+    if(row < views_.size() && views_[row] != nullptr){
+        delete views_[row];
+        views_[row] = nullptr;
+    }
+}
+
+bool Column::acceptType(Type type){
+    if(type_ == type){
+        return true;
+    }
+    if(type_ == Type::Empty){
+        type_ = type;
+        switch(type){
+        case Type::Int:
+            ints_.assign(rowsCount_, 0);
+            break;
+        case Type::Double:
+            doubles_.assign(rowsCount_, 0);
+            break;
+        default:
+            strings_.assign(rowsCount_, std::string());
+            break;
+        }
+        return true;
+    }
+    if(type_ == Type::Int && type == Type::Double){
+        doubles_.assign(ints_.begin(), ints_.end());
+        ints_.clear();
+        ints_.shrink_to_fit();
+        type_ = Type::Double;
+        intRows_ = validity_;
+        return true;
+    }
+    if(type_ == Type::Double && type == Type::Int){
+        return true;
+    }
+    return false;
+}
+
+void Column::eraseTyped(size_t row){
+    setBit(validity_, row, false);
+    setBit(intRows_, row, false);
+    if(type_ == Type::String){
+        std::string().swap(strings_[row]);
+    }
+    dropView(row);
+}
+
+bool Column::setInt(size_t row, int64_t value){
+    if(!acceptType(Type::Int)){
+        return false;
+    }
+    erase(row);
+    if(type_ == Type::Int){
+        ints_[row] = value;
+    }else{
+        doubles_[row] = value;
+        setBit(intRows_, row, true);
+    }
+    setBit(validity_, row, true);
+    return true;
+}
+
+bool Column::setDouble(size_t row, double value){
+    if(!acceptType(Type::Double)){
+        return false;
+    }
+    erase(row);
+    doubles_[row] = value;
+    setBit(validity_, row, true);
+    return true;
+}
+
+bool Column::setString(size_t row, const std::string& value){
+    if(!acceptType(Type::String)){
+        return false;
+    }
+    erase(row);
+    strings_[row] = value;
+    setBit(validity_, row, true);
+    return true;
+}
+
+void Column::setCell(size_t row, Cell* cell){
+    erase(row);
+    if(cells_.empty()){
+        cells_.assign(rowsCount_, nullptr);
+    }
+    cells_[row] = cell;
+    setBit(hasCell_, row, cell != nullptr);
+}
+
+void Column::erase(size_t row){
+    if(testBit(validity_, row)){
+        eraseTyped(row);
+    }
+    if(testBit(hasCell_, row)){
+        delete cells_[row];
+        cells_[row] = nullptr;
+        setBit(hasCell_, row, false);
+    }
+}
+
+bool Column::hasValue(size_t row) const{
+    return testBit(validity_, row) || testBit(hasCell_, row);
+}
+
+Cell* Column::getStoredCell(size_t row) const{
+    if(testBit(hasCell_, row)){
+        return cells_[row];
+    }
+    return nullptr;
+}
+
+Cell* Column::createIntCell(int64_t value){
+    if(value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()){
+        return new CellDouble((double)value);
+    }
+    return new CellInt((int)value);
+}
+
+Cell* Column::createCell(size_t row) const{
+    switch(type_){
+    case Type::Int:
+        return createIntCell(ints_[row]);
+    case Type::Double:
+        if(testBit(intRows_, row)){
+            return createIntCell((int64_t)doubles_[row]);
+        }
+        return new CellDouble(doubles_[row]);
+    default:
+        return new CellString(strings_[row]);
+    }
+}
+
+const Cell* Column::getCellPointer(size_t row, std::unique_ptr<Cell>& buffer) const{
+    if(testBit(hasCell_, row)){
+        return cells_[row];
+    }
+    if(!testBit(validity_, row)){
+        return nullptr;
+    }
+    buffer.reset(createCell(row));
+    return buffer.get();
+}
+
+const Cell* Column::getCellPointer(size_t row){
+    if(testBit(hasCell_, row)){
+        return cells_[row];
+    }
+    if(!testBit(validity_, row)){
+        return nullptr;
+    }
+    if(views_.size() < rowsCount_){
+        views_.resize(rowsCount_, nullptr);
+    }
+    if(views_[row] == nullptr){
+        views_[row] = createCell(row);
+    }
+    return views_[row];
+}
+
+std::string_view Column::getDisplayableView(size_t row, std::string& buffer) const{
+    if(testBit(hasCell_, row)){
+        return cells_[row]->getDisplayableView(buffer);
+    }
+    if(!testBit(validity_, row)){
+        return std::string_view();
+    }
+    switch(type_){
+    case Type::Int:{
+        char digits[24];
+        std::to_chars_result res = std::to_chars(digits, digits + sizeof(digits), ints_[row]);
+        buffer.assign(digits, res.ptr - digits);
+        return buffer;
+    }
+    case Type::Double:
+        if(testBit(intRows_, row)){
+            char digits[24];
+            std::to_chars_result res = std::to_chars(digits, digits + sizeof(digits), (int64_t)doubles_[row]);
+            buffer.assign(digits, res.ptr - digits);
+            return buffer;
+        }
+        CellDouble::formatValue(doubles_[row], buffer);
+        return buffer;
+    default:
+        return std::string_view(strings_[row]).substr(1, strings_[row].size() - 2);
+    }
+}
+
+std::string_view Column::getConstructView(size_t row, std::string& buffer) const{
+    if(testBit(hasCell_, row)){
+        return cells_[row]->getConstructView(buffer);
+    }
+    if(testBit(validity_, row) && type_ == Type::String){
+        return strings_[row];
+    }
+    // numbers are constructed from the same string they are displayed with
+    return getDisplayableView(row, buffer);
+}
+
+Column::ValueKind Column::getNumericValue(const Cell* cell, double& value){
+    value = 0;
+    if(cell == nullptr){
+        return ValueKind::Empty;
+    }
+
+    // plain numbers are by far the most common, so they are checked first
+    const CellDouble* cd = dynamic_cast<const CellDouble*>(cell);
+    if(cd != nullptr){
+        value = cd->getValue();
+        return ValueKind::Number;
+    }
+
+    const CellInt* ci = dynamic_cast<const CellInt*>(cell);
+    if(ci != nullptr){
+        value = ci->getValue();
+        return ValueKind::Number;
+    }
+
+    const CellFormula* cf = dynamic_cast<const CellFormula*>(cell);
+    if(cf != nullptr){
+        if(cf->error()){
+            return ValueKind::Error;
+        }
+        value = cf->getValue();
+        return ValueKind::Number;
+    }
+
+    return ValueKind::Text;
+}
+
+Column::ValueKind Column::getNumericValue(size_t row, double& value) const{
+    if(testBit(hasCell_, row)){
+        return getNumericValue(cells_[row], value);
+    }
+    value = 0;
+    if(!testBit(validity_, row)){
+        return ValueKind::Empty;
+    }
+    switch(type_){
+    case Type::Int:
+        value = ints_[row];
+        return ValueKind::Number;
+    case Type::Double:
+        value = doubles_[row];
+        return ValueKind::Number;
+    default:
+        return ValueKind::Text;
+    }
+}
+
+bool Column::gather(size_t fromRow, size_t count, double* values, uint64_t* validity) const{
+    // typed values first - a whole run at once
+    if(type_ == Type::Int || type_ == Type::Double){
+        copyBits(validity_, fromRow, count, validity);
+        if(type_ == Type::Int){
+            for(size_t i = 0; i < count; i++){
+                values[i] = ints_[fromRow + i];
+            }
+        }else{
+            for(size_t i = 0; i < count; i++){
+                values[i] = doubles_[fromRow + i];
+            }
+        }
+    }else{
+        for(size_t word = 0; word < (count + 63) / 64; word++){
+            validity[word] = 0;
+        }
+    }
+
+    if(cells_.empty()){
+        return false;
+    }
+
+    // then the rows kept as Cell objects
+    bool error = false;
+    uint64_t objects[4];
+    for(size_t done = 0; done < count; done += 256){
+        size_t part = std::min((size_t)256, count - done);
+        copyBits(hasCell_, fromRow + done, part, objects);
+        for(size_t word = 0; word < (part + 63) / 64; word++){
+            for(uint64_t bits = objects[word]; bits != 0; bits &= bits - 1){
+                size_t i = done + word * 64 + __builtin_ctzll(bits);
+                ValueKind kind = getNumericValue(cells_[fromRow + i], values[i]);
+                if(kind == ValueKind::Number){
+                    validity[i >> 6] |= 1ULL << (i & 63);
+                }else if(kind == ValueKind::Error){
+                    error = true;
+                }
+            }
+        }
+    }
+    return error;
+}
+
+bool Column::getDoubleRun(size_t fromRow, size_t count, const double*& values, const uint64_t*& validity) const{
+    if(type_ != Type::Double || fromRow % 64 != 0 || fromRow + count > rowsCount_){
+        return false;
+    }
+    if(!cells_.empty()){
+        for(size_t word = fromRow / 64; word < (fromRow + count + 63) / 64; word++){
+            if(hasCell_[word] != 0){
+                return false;
+            }
+        }
+    }
+    values = doubles_.data() + fromRow;
+    validity = validity_.data() + fromRow / 64;
+    return true;
+}
+
+void Column::storeTyped(){
+    for(size_t row = 0; row < cells_.size(); row++){
+        Cell* cell = cells_[row];
+        if(cell == nullptr){
+            continue;
+        }
+        bool stored = false;
+        if(const CellInt* ci = dynamic_cast<const CellInt*>(cell)){
+            stored = acceptType(Type::Int);
+            if(stored){
+                if(type_ == Type::Int){
+                    ints_[row] = ci->getValue();
+                }else{
+                    doubles_[row] = ci->getValue();
+                    setBit(intRows_, row, true);
+                }
+            }
+        }else if(const CellDouble* cd = dynamic_cast<const CellDouble*>(cell)){
+            stored = acceptType(Type::Double);
+            if(stored){
+                doubles_[row] = cd->getValue();
+            }
+        }else if(CellString* cs = dynamic_cast<CellString*>(cell)){
+            stored = acceptType(Type::String);
+            if(stored){
+                strings_[row] = cs->getConstructString();
+            }
+        }
+        if(stored){
+            delete cell;
+            cells_[row] = nullptr;
+            setBit(hasCell_, row, false);
+            setBit(validity_, row, true);
+        }
+    }
+}
+
+void Column::storeCells(){
+    for(size_t row = 0; row < rowsCount_; row++){
+        if(testBit(validity_, row)){
+            Cell* cell = createCell(row);
+            eraseTyped(row);
+            setCell(row, cell);
+        }
+    }
+    type_ = Type::Empty;
+    std::vector<int64_t>().swap(ints_);
+    std::vector<double>().swap(doubles_);
+    std::vector<std::string>().swap(strings_);
+}
+
+const std::vector<int64_t>& Column::intValues() const{
+    return ints_;
+}
+
+const std::vector<double>& Column::doubleValues() const{
+    return doubles_;
+}
+
+const std::vector<std::string>& Column::stringValues() const{
+    return strings_;
+}
+
+const std::vector<uint64_t>& Column::validityBits() const{
+    return validity_;
+}
+
+const std::vector<uint64_t>& Column::cellBits() const{
+    return hasCell_;
+}
+
+const std::vector<uint64_t>& Column::intBits() const{
+    return intRows_;
+}
+
+void Column::addMemoryUsage(MemoryUsage& usage) const{
+    usage.grid += (cells_.capacity() + validity_.capacity() + hasCell_.capacity() + intRows_.capacity()) * 8;
+    usage.blocks += !cells_.empty() + !validity_.empty() + !hasCell_.empty() + !intRows_.empty();
+
+    uint64_t typed = 0;
+    for(size_t word = 0; word < validity_.size(); word++){
+        typed += __builtin_popcountll(validity_[word]);
+    }
+    if(type_ == Type::Int){
+        usage.ints.count += typed;
+        usage.ints.bytes += ints_.capacity() * sizeof(int64_t);
+    }else if(type_ == Type::Double){
+        usage.doubles.count += typed;
+        usage.doubles.bytes += doubles_.capacity() * sizeof(double);
+    }else if(type_ == Type::String){
+        usage.strings.count += typed;
+        usage.strings.bytes += strings_.capacity() * sizeof(std::string);
+        for(size_t row = 0; row < strings_.size(); row++){
+            uint64_t payload = MemoryUsage::heapBytes(strings_[row]);
+            usage.stringPayloads += payload;
+            usage.blocks += payload != 0;
+        }
+    }
+    usage.blocks += !ints_.empty() + !doubles_.empty() + !strings_.empty();
+
+    for(size_t word = 0; word < hasCell_.size(); word++){
+        for(uint64_t bits = hasCell_[word]; bits != 0; bits &= bits - 1){
+            cells_[word * 64 + __builtin_ctzll(bits)]->addMemoryUsage(usage);
+        }
+    }
+
+    usage.caches += views_.capacity() * sizeof(Cell*);
+    usage.blocks += !views_.empty();
+    for(size_t row = 0; row < views_.size(); row++){
+        if(views_[row] != nullptr){
+            MemoryUsage view;
+            views_[row]->addMemoryUsage(view);
+            usage.caches += view.total();
+            usage.blocks += view.blocks;
+        }
+    }
+}
+
+void Column::loadInts(const int64_t* values, const uint64_t* validity){
+    type_ = Type::Int;
+    ints_.assign(values, values + rowsCount_);
+    validity_.assign(validity, validity + (rowsCount_ + 63) / 64);
+}
+
+void Column::loadDoubles(const double* values, const uint64_t* validity, const uint64_t* intRows){
+    type_ = Type::Double;
+    doubles_.assign(values, values + rowsCount_);
+    validity_.assign(validity, validity + (rowsCount_ + 63) / 64);
+    intRows_.assign(validity_.size(), 0);
+    if(intRows != nullptr){
+        for(size_t word = 0; word < validity_.size(); word++){
+            intRows_[word] = intRows[word] & validity_[word];
+        }
+    }
+}
+
+void Column::loadStrings(std::vector<std::string>& values, const uint64_t* validity){
+    type_ = Type::String;
+    strings_.swap(values);
+    strings_.resize(rowsCount_);
+    validity_.assign(validity, validity + (rowsCount_ + 63) / 64);
+}
@@ -0,0 +1,271 @@
+#ifndef COLUMN_H
+#define COLUMN_H
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+#include "Cell.h"
+
+/** Column holds the cells of one column of a \ref Table.
+ *  Cells can be kept in 2 ways:
+ *  \li as objects extending \ref Cell (one dynamically allocated object per cell) - \ref setCell
+ *  \li as typed values in contiguous arrays - \ref setInt, \ref setDouble and \ref setString
+ *  \n Typed values of a column all share one type - the type of the first typed value stored in it.
+ *  Integer columns are promoted to floating numbers when they receive one; their integers are still
+ *  integers (\ref CellInt) for everything but the calculations - \ref intBits. Values which do not fit
+ *  the type of the column, as well as every formula, are kept as Cell objects instead.
+ *  \n A validity bitmap tells which rows hold a typed value, so that numeric columns can be summarized
+ *  by the vectorized \ref AggregateKernels without touching any Cell object.
+ *  \n Typed values have no Cell object, but one is created on demand if a pointer to it is needed -
+ *  \ref getCellPointer
+ */
+class Column{
+public:
+
+    /** Type of the typed values of a column
+     */
+    enum class Type{
+        Empty,      /**< no typed value has been stored yet */
+        Int,
+        Double,
+        String
+    };
+
+    /** What a cell contributes to a calculation - \ref getNumericValue
+     */
+    enum class ValueKind{
+        Empty,      /**< no cell, or a cell outside the table */
+        Number,     /**< int, double or successfully calculated formula */
+        Text,       /**< string cell, counts as 0 */
+        Error       /**< formula which could not be calculated */
+    };
+
+private:
+
+    /** Count of rows in this column */
+    size_t rowsCount_;
+
+    /** Type of the typed values */
+    Type type_;
+
+    /** Typed values, only the array of the current type is used. Each has one element per row */
+    std::vector<int64_t> ints_;
+    std::vector<double> doubles_;
+    std::vector<std::string> strings_;
+
+    /** Bit i of word i/64 is set if row i holds a typed value */
+    std::vector<uint64_t> validity_;
+
+    /** Bit i of word i/64 is set if row i holds a Cell object */
+    std::vector<uint64_t> hasCell_;
+
+    /** Bit i of word i/64 is set if row i of a column of floating numbers holds an integer */
+    std::vector<uint64_t> intRows_;
+
+    /** Cells kept as objects. Allocated only after the first such cell is stored */
+    std::vector<Cell*> cells_;
+
+    /** Cell objects created on demand for typed values - \ref getCellPointer */
+    std::vector<Cell*> views_;
+
+    static bool testBit(const std::vector<uint64_t>& bits, size_t row);
+    static void setBit(std::vector<uint64_t>& bits, size_t row, bool value);
+
+    /** Copies count bits starting from bit first of the source bitmap into a bitmap starting from bit 0
+     */
+    static void copyBits(const std::vector<uint64_t>& source, size_t first, size_t count, uint64_t* destination);
+
+    /** Deletes the Cell object created for a typed value, if there's such - \ref getCellPointer
+     */
+    void dropView(size_t row);
+
+    /** Checks whether a typed value of the given type can be stored. Decides the type of an empty column.
+     */
+    bool acceptType(Type type);
+
+    /** Removes a typed value on the given row
+     */
+    void eraseTyped(size_t row);
+
+    /** Creates a Cell object holding the typed value on the given row
+     */
+    Cell* createCell(size_t row) const;
+
+    /** \return CellInt holding the integer, or CellDouble if it does not fit into an int -
+     *  the same cell \ref Table::setCellValue creates from such a number written as text
+     */
+    static Cell* createIntCell(int64_t value);
+
+    /** Releases every Cell object owned by this column
+     */
+    void releaseCells();
+
+public:
+
+    /** Empty column with no rows
+     */
+    Column();
+
+    /** Copy constructor. Creates a copy of every Cell object of the other column.
+     */
+    Column(const Column& copy);
+
+    /** Move constructor, which takes over the cells of the other column and leaves it empty.
+     */
+    Column(Column&& other) noexcept;
+
+    /** Operator= which creates a copy of every Cell object of the other column.
+     */
+    Column& operator=(const Column& other);
+
+    /** Destructor which deletes every Cell object of this column.
+     */
+    ~Column();
+
+    /** Changes the count of rows. Cells on removed rows are deleted.
+     */
+    void resize(size_t rows);
+
+    /** \return count of rows of this column
+     */
+    size_t rowsCount() const;
+
+    /** \return type of the typed values of this column
+     */
+    Type type() const;
+
+    /** Stores an integer as a typed value. Removes what was on this row before.
+     *  In a column of floating numbers, the row remembers that it holds an integer.
+     *  \return false if the column holds strings, in which case nothing is changed
+     */
+    bool setInt(size_t row, int64_t value);
+
+    /** Stores a floating number as a typed value. Removes what was on this row before.
+     *  Promotes an integer column to floating numbers.
+     *  \return false if the column holds strings, in which case nothing is changed
+     */
+    bool setDouble(size_t row, double value);
+
+    /** Stores a string as a typed value. Removes what was on this row before.
+     *  \param value string in the format of \ref CellString (surrounded by quotes)
+     *  \return false if the column holds numbers, in which case nothing is changed
+     */
+    bool setString(size_t row, const std::string& value);
+
+    /** Stores a Cell object and takes care of deleting it. Removes what was on this row before.
+     */
+    void setCell(size_t row, Cell* cell);
+
+    /** Removes whatever is stored on the given row
+     */
+    void erase(size_t row);
+
+    /** \return whether anything is stored on the given row
+     */
+    bool hasValue(size_t row) const;
+
+    /** \return the Cell object stored on the given row or null pointer if the row is empty or holds
+     *  a typed value. Never creates new objects.
+     */
+    Cell* getStoredCell(size_t row) const;
+
+    /** \return pointer to the cell on the given row or null pointer if it's empty. A Cell object is created
+     *  for typed values when it is first needed and lives until the row is changed.
+     */
+    const Cell* getCellPointer(size_t row);
+
+    /** Version of \ref getCellPointer which changes nothing, so several threads may call it at once.
+     *  The Cell object of a typed value is created into the buffer.
+     */
+    const Cell* getCellPointer(size_t row, std::unique_ptr<Cell>& buffer) const;
+
+    /** Same as \ref Cell::getDisplayableView for the cell on the given row. Empty view if there's no cell.
+     */
+    std::string_view getDisplayableView(size_t row, std::string& buffer) const;
+
+    /** Same as \ref Cell::getConstructView for the cell on the given row. Empty view if there's no cell.
+     */
+    std::string_view getConstructView(size_t row, std::string& buffer) const;
+
+    /** Reads the value of the cell on the given row as a floating number.
+     *  \param value receives the value, 0 unless the cell is of kind \ref ValueKind::Number
+     *  \return kind of the cell
+     */
+    ValueKind getNumericValue(size_t row, double& value) const;
+
+    /** Reads the numeric values of consecutive rows.
+     *
+     *  \param fromRow first row to read
+     *  \param count count of rows to read
+     *  \param values receives the value of every row
+     *  \param validity receives a bitmap telling which rows hold numbers
+     *  \return whether any of the rows holds a formula with error
+     */
+    bool gather(size_t fromRow, size_t count, double* values, uint64_t* validity) const;
+
+    /** Gives direct access to the typed floating numbers of consecutive rows, when none of them is kept as
+     *  a Cell object. Nothing is copied.
+     *
+     *  \param fromRow first row, must be a multiple of 64
+     *  \param count count of rows
+     *  \param values receives pointer to the value of the first row
+     *  \param validity receives pointer to the validity bitmap of the first row
+     *  \return false if the rows cannot be accessed directly - \ref gather should be used instead
+     */
+    bool getDoubleRun(size_t fromRow, size_t count, const double*& values, const uint64_t*& validity) const;
+
+    /** Moves every integer, floating number and string kept as a Cell object into the typed arrays
+     *  (where the type of the column allows it)
+     */
+    void storeTyped();
+
+    /** Turns every typed value into a Cell object
+     */
+    void storeCells();
+
+    /** Typed values of the column, one element per row. Only the array of \ref type is used,
+     *  elements of rows which do not hold a typed value (see \ref validityBits) are meaningless.
+     */
+    const std::vector<int64_t>& intValues() const;
+    const std::vector<double>& doubleValues() const;
+    const std::vector<std::string>& stringValues() const;
+
+    /** \return bitmap with a bit set for every row which holds a typed value
+     */
+    const std::vector<uint64_t>& validityBits() const;
+
+    /** \return bitmap with a bit set for every row which holds a Cell object
+     */
+    const std::vector<uint64_t>& cellBits() const;
+
+    /** \return bitmap with a bit set for every row of a column of floating numbers which holds an integer
+     */
+    const std::vector<uint64_t>& intBits() const;
+
+    /** Stores typed values of every row at once. The column must not hold any typed values yet.
+     *  Used to load whole columns from files.
+     *
+     *  \param values one value per row
+     *  \param validity bitmap telling which rows hold a value, (rows + 63) / 64 words
+     *  \param intRows bitmap telling which of them are integers - \ref intBits, none if null
+     */
+    void loadInts(const int64_t* values, const uint64_t* validity);
+    void loadDoubles(const double* values, const uint64_t* validity, const uint64_t* intRows = nullptr);
+    void loadStrings(std::vector<std::string>& values, const uint64_t* validity);
+
+    /** Reads the value of a Cell object as a floating number - \ref getNumericValue
+     */
+    static ValueKind getNumericValue(const Cell* cell, double& value);
+
+    /** Adds the memory of the cells of this column (objects and typed values), its arrays of pointers and
+     *  bitmaps, and the Cell objects created on demand (as caches) - \ref Table::memoryUsage
+     *  \n The column object itself is counted by its table.
+     */
+    void addMemoryUsage(MemoryUsage& usage) const;
+
+};
+
+
+#endif // COLUMN_H
@@ -1,25 +1,118 @@
 #include <iostream>
+#include <algorithm>
 #include <fstream>
+#include <chrono>
+#include <cstdio>
 #include "ControlCenter.h"
+#include "BinaryWorkbook.h"
+#include "ResultSidecar.h"
+#include "Trace.h"
+
+namespace{
+
+double secondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint64_t fileSize(const std::string& filename){
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.is_open() ? (uint64_t)file.tellg() : 0;
+}
+
+/** Replaces a file with another one. Renaming replaces it at once where the system allows renaming over
+ *  an existing file, elsewhere the old file is removed first.
+ *
+ *  \exception invalid_argument the file cannot be replaced, the other one is removed then
+ */
+void replaceFile(const std::string& replacement, const std::string& filename){
+    if(std::rename(replacement.c_str(), filename.c_str()) == 0){
+        return;
+    }
+    std::remove(filename.c_str());
+    if(std::rename(replacement.c_str(), filename.c_str()) != 0){
+        std::remove(replacement.c_str());
+        throw std::invalid_argument("Unexpected error while replacing file " + filename + ". ");
+    }
+}
+
+}
 
 ControlCenter::ControlCenter(){
     filePath_ = "";
 }
 
+void ControlCenter::setOverwrite(Overwrite overwrite){
+    overwrite_ = overwrite;
+}
+
+ControlCenter::Overwrite ControlCenter::overwrite() const{
+    return overwrite_;
+}
+
+void ControlCenter::setBackgroundSaving(bool background){
+    backgroundSaving_ = background;
+}
+
+bool ControlCenter::isBackgroundSaving() const{
+    return backgroundSaving_;
+}
+
+void ControlCenter::waitForSaves(){
+    {
+        std::unique_lock<std::mutex> lock(savesMutex_);
+        savesFinished_.wait(lock, [this](){ return runningSaves_ == 0; });
+    }
+    collectSaves();
+}
+
+void ControlCenter::setJournaling(bool journaling){
+    journaling_ = journaling;
+}
+
+bool ControlCenter::isJournaling() const{
+    return journaling_;
+}
+
+void ControlCenter::setCompactionChanges(uint64_t changes){
+    compactionChanges_ = std::max((uint64_t)1, changes);
+}
+
+void ControlCenter::collectSaves(){
+    std::lock_guard<std::mutex> lock(savesMutex_);
+    for(const FinishedSave& save : finishedSaves_){
+        // changes made after the save was started are still not saved
+        if(save.succeeded && save.filename == filePath_ && save.changes == changes_){
+            upToDate = true;
+        }
+    }
+    finishedSaves_.clear();
+}
+
 bool ControlCenter::confirmAction(char yes, char no){
     char input;
     std::cin >> input;
     std::cin.ignore();
 
-    while(input != yes && input != no){
+    while(std::cin && input != yes && input != no){
         std::cin >> input;
         std::cin.ignore();
     }
 
-    return (yes == input);
+    return std::cin && (yes == input);
 
 }
 
+bool ControlCenter::confirmOverwrite(const std::string& filename){
+    if(overwrite_ == Overwrite::Ask){
+        std::cout << "File exists. Are you sure you want to continue and rewrite it? Y/N: ";
+        return confirmAction('Y', 'N');
+    }
+    if(overwrite_ == Overwrite::Never && filename != filePath_){
+        throw std::invalid_argument("File " + filename + " exists and overwriting is not allowed. ");
+    }
+    return true;
+}
+
 bool ControlCenter::fileExist(const std::string& filename){
 
     bool doesExist = false;
@@ -35,6 +128,7 @@ bool ControlCenter::fileExist(const std::string& filename){
 }
 
 bool ControlCenter::checkFormat(const std::string& str){
+    if(BinaryWorkbook::hasExtension(str)) return true;
     if(str.size() <= 5) return false;
     std::string last4 = str.substr(str.size() - 4, 4);
     stringToUpper(last4);
@@ -52,19 +146,38 @@ void ControlCenter::stringToUpper(std::string& str){
 void ControlCenter::loadFromFile(const std::string& filename){
 
     if(!checkFormat(filename)){
-        throw std::invalid_argument("Currently, only .csv file format is being supported. ");
+        throw std::invalid_argument("Currently, only .csv and .xtb file formats are being supported. ");
     }
 
     if(!fileExist(filename)){
         throw std::invalid_argument("File not found. ");
     }
 
+    if(BinaryWorkbook::hasExtension(filename)){
+        // nothing needs to be parsed or calculated, the cells are read as they were saved
+        Statistics::Timer timer(stats_, "load: read");
+        BinaryWorkbook::load(filename, currentTable);
+        Statistics::bytesRead.fetch_add(fileSize(filename), std::memory_order_relaxed);
+        currentTable.setColumnar(currentTable.isColumnar());
+        filePath_ = filename;
+        upToDate = true;
+        std::cout << "File loading finished. [" << currentTable.rowsCount() << "x" << currentTable.columnsCount()
+                  << "] cells read";
+        return;
+    }
+
+    auto phaseStart = std::chrono::steady_clock::now();
     std::ifstream readFile(filename);
     std::string dataLine;
     std::vector <std::string> dataLines;
+    ResultSidecar::Fingerprint fingerprint;
+    uint64_t bytes = 0;
 
     while (getline (readFile, dataLine)) {
+        // the last line may end without a new line
+        bytes += dataLine.size() + !readFile.eof();
         if(dataLine == "") continue;
+        fingerprint.addLine(dataLine);
         dataLines.push_back(dataLine);
     }
 
@@ -79,7 +192,10 @@ void ControlCenter::loadFromFile(const std::string& filename){
     }
 
     readFile.close();
+    Statistics::bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    stats_.record("load: read", secondsSince(phaseStart));
 
+    phaseStart = std::chrono::steady_clock::now();
     size_t rowsCount = std::max((size_t)1, dataLines.size());
     size_t columnsCount = 1;
 
@@ -96,11 +212,19 @@ void ControlCenter::loadFromFile(const std::string& filename){
     }
 
     Table tmp(rowsCount, columnsCount);
+    tmp.setColumnar(currentTable.isColumnar());
+    tmp.setLazyCalculation(currentTable.isLazyCalculation());
 
     size_t successfulCells = 0;
     size_t totalCells = 0;
+    double parseSeconds = secondsSince(phaseStart);
+    double typeSeconds = 0;
+    // values of one line with their columns: the line is split first, then its cells are created
+    std::vector<std::pair<size_t, std::string>> values;
 
     for(size_t line = 0; line < dataLines.size(); line++){
+        auto lineStart = std::chrono::steady_clock::now();
+        values.clear();
         size_t stringStart = 0;
         size_t commaCount = 0;
         for(size_t i = 0; i < dataLines[line].size(); i++){
@@ -110,23 +234,39 @@ void ControlCenter::loadFromFile(const std::string& filename){
                     i++;
                 }
                 if(stringStart - i > 0){
-                    std::string str = dataLines[line].substr (stringStart, i - stringStart);
-                    try{
-                        tmp.setCellValue(line, commaCount, str);
-                        successfulCells++;
-                    }catch(std::invalid_argument& e){
-                        std::cerr << "Error reading value on: " << ((char)('A' + commaCount)) << (line+1)
-                                  << " -> " << str << "    \t(reason: " << e.what() << ")\n";
-
-                    }
-                    totalCells++;
+                    values.emplace_back(commaCount, dataLines[line].substr (stringStart, i - stringStart));
                 }
 
                 stringStart = i + 1;
                 commaCount++;
             }
         }
+        auto typeStart = std::chrono::steady_clock::now();
+        parseSeconds += std::chrono::duration<double>(typeStart - lineStart).count();
+
+        for(const auto& [column, str] : values){
+            try{
+                // formulas are calculated once all cells are read
+                tmp.loadCellValue(line, column, str);
+                successfulCells++;
+            }catch(std::invalid_argument& e){
+                std::cerr << "Error reading value on: " << CellRef(line, column).toString()
+                          << " -> " << str << "    \t(reason: " << e.what() << ")\n";
+
+            }
+            totalCells++;
+        }
+        typeSeconds += secondsSince(typeStart);
+    }
+    stats_.record("load: parse", parseSeconds);
+    stats_.record("load: type", typeSeconds);
+
+    phaseStart = std::chrono::steady_clock::now();
+    // results saved together with this exact content need not be calculated again
+    if(!ResultSidecar::load(filename, fingerprint.value(), tmp)){
+        tmp.recalculateAllFormulas();
     }
+    stats_.record("load: recalc", secondsSince(phaseStart));
 
     currentTable = tmp;
 
@@ -139,75 +279,289 @@ void ControlCenter::loadFromFile(const std::string& filename){
 
 void ControlCenter::saveToFile(const std::string& filename){
     if(!checkFormat(filename)){
-        throw std::invalid_argument("Only .csv file format is being currently supported. ");
+        throw std::invalid_argument("Only .csv and .xtb file formats are being currently supported. ");
     }
 
-    if(fileExist(filename)){
-        std::cout << "File exists. Are you sure you want to continue and rewrite it? Y/N: ";
-        bool res = confirmAction('Y', 'N');
-        if(!res){
+    if(journal_ != nullptr && filename == filePath_){
+        {
+            Statistics::Timer timer(stats_, "save: journal");
+            journal_->commit();
+        }
+        upToDate = true;
+        // the file itself gets the saved changes only now and then
+        uint64_t saved = journal_->savedChanges();
+        if(saved - std::max(compactedChanges_, journal_->baseChanges()) < compactionChanges_){
             return;
         }
+        compactedChanges_ = saved;
+        std::shared_ptr<ChangeJournal> journal = journal_;
+        if(!backgroundSaving_){
+            compactJournal(currentTable, *journal, filename, saved);
+            return;
+        }
+        runInBackground(filename, [this, journal, filename, saved](const Table& table){
+            compactJournal(table, *journal, filename, saved);
+        });
+        return;
+    }
+
+    if(fileExist(filename) && !confirmOverwrite(filename)){
+        return;
+    }
+
+    if(!backgroundSaving_){
+        writeTable(currentTable, filename);
+        if(filePath_ == filename){
+            upToDate = true;
+        }
+        return;
     }
 
-    std::ofstream writeFile(filename, std::ios::trunc);
+    runInBackground(filename, [this, filename](const Table& table){
+        writeTable(table, filename);
+    });
+}
+
+void ControlCenter::runInBackground(const std::string& filename, const std::function<void(const Table&)>& write){
+    // writing calculates dirty formulas, which must not happen in columns shared with the current table
+    currentTable.calculateDirtyFormulas();
+    // copying takes constant time, the table can change while the copy is written
+    std::shared_ptr<Table> snapshot = std::make_shared<Table>(currentTable);
+    uint64_t changes = changes_;
+    {
+        std::lock_guard<std::mutex> lock(savesMutex_);
+        runningSaves_++;
+    }
+    if(saver_ == nullptr){
+        saver_ = std::make_unique<ThreadPool>(1);
+    }
+    saver_->submit([this, snapshot, filename, changes, write](){
+        bool succeeded = true;
+        try{
+            write(*snapshot);
+            std::cout << ("\n  Saved " + filename + "\n") << std::flush;
+        }catch(std::exception& e){
+            succeeded = false;
+            std::cerr << ("\nFAIL: Saving " + filename + " failed: " + e.what() + "\n");
+        }
+        std::lock_guard<std::mutex> lock(savesMutex_);
+        finishedSaves_.push_back({filename, changes, succeeded});
+        runningSaves_--;
+        savesFinished_.notify_all();
+    });
+}
+
+void ControlCenter::writeTable(const Table& table, const std::string& filename,
+                               const std::function<void(const std::string&)>& written){
+    const std::string temporary = filename + ".tmp";
+
+    if(BinaryWorkbook::hasExtension(filename)){
+        {
+            Statistics::Timer timer(stats_, "save: write");
+            try{
+                BinaryWorkbook::save(table, temporary);
+                if(written){
+                    written(temporary);
+                }
+            }catch(std::invalid_argument&){
+                std::remove(temporary.c_str());
+                throw;
+            }
+            replaceFile(temporary, filename);
+        }
+        Statistics::bytesWritten.fetch_add(fileSize(filename), std::memory_order_relaxed);
+        return;
+    }
+
+    std::ofstream writeFile(temporary, std::ios::trunc);
     std::string commandLine;
     if(writeFile.fail()){
         throw std::invalid_argument((std::string)"Unexpected error while opening file. 1) Possible reasons: permission deny, " +
                                     "2) file exists, but another software denies access to it.");
     }
 
-    for(size_t row = 0; row < currentTable.rowsCount(); row++){
-        for(size_t col = 0; col < currentTable.columnsCount(); col++){
-            if(writeFile.fail()){
-                throw std::invalid_argument((std::string)"Unexpected error while opening file. 1) Possible reasons: permission deny, " +
-                                            "2) file exists, but another software denies access to it.");
-            }
-            std::string s = currentTable.getConstructedCellValue(row, col);
-            if(s != ""){
-                writeFile << s;
+    // one scratch buffer for the whole table, so writing a cell does not allocate
+    std::string buffer;
+    std::string line;
+    ResultSidecar::Fingerprint fingerprint;
+    // the results can be matched to the cells only if reading the file gives back the same table:
+    // empty lines are skipped and commas inside of values split them
+    bool exact = true;
+    double formatSeconds = 0;
+    double writeSeconds = 0;
+    uint64_t bytes = 0;
+
+    for(size_t row = 0; row < table.rowsCount(); row++){
+        auto formatStart = std::chrono::steady_clock::now();
+        line.clear();
+        for(size_t col = 0; col < table.columnsCount(); col++){
+            std::string_view s = table.getConstructedCellView(row, col, buffer);
+            if(s.find(',') != std::string_view::npos){
+                exact = false;
             }
-            if(col + 1 < currentTable.columnsCount()){
-                writeFile << ',';
+            line += s;
+            if(col + 1 < table.columnsCount()){
+                line += ',';
             }
         }
-        if(row + 1 < currentTable.rowsCount())
-        writeFile << std::endl;
+        if(line.empty()){
+            exact = false;
+        }
+        fingerprint.addLine(line);
+        auto writeStart = std::chrono::steady_clock::now();
+        formatSeconds += std::chrono::duration<double>(writeStart - formatStart).count();
+        writeFile << line;
+        bytes += line.size();
+        if(row + 1 < table.rowsCount()){
+            writeFile << '\n';
+            bytes++;
+        }
+        if(writeFile.fail()){
+            writeFile.close();
+            std::remove(temporary.c_str());
+            throw std::invalid_argument((std::string)"Unexpected error while opening file. 1) Possible reasons: permission deny, " +
+                                        "2) file exists, but another software denies access to it.");
+        }
+        writeSeconds += secondsSince(writeStart);
     }
+    auto closeStart = std::chrono::steady_clock::now();
     writeFile.close();
+    if(written){
+        try{
+            written(temporary);
+        }catch(std::invalid_argument&){
+            std::remove(temporary.c_str());
+            throw;
+        }
+    }
+    replaceFile(temporary, filename);
+    writeSeconds += secondsSince(closeStart);
+    Statistics::bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+    stats_.record("save: format", formatSeconds);
+    stats_.record("save: write", writeSeconds);
 
-    if(filePath_ == filename){
-        upToDate = true;
+    Statistics::Timer timer(stats_, "save: results");
+
+    if(exact){
+        ResultSidecar::save(table, filename, fingerprint.value());
+    }else{
+        ResultSidecar::remove(filename);
+    }
+}
+
+void ControlCenter::compactJournal(const Table& table, ChangeJournal& journal, const std::string& filename,
+                                   uint64_t changes){
+    uint64_t fingerprint = 0;
+    // until the new file replaces the old one, the journal must be usable with both of them
+    writeTable(table, filename, [&](const std::string& temporary){
+        fingerprint = ChangeJournal::fingerprint(temporary);
+        journal.checkpoint(fingerprint, changes);
+    });
+    journal.restart(fingerprint, changes);
+}
+
+void ControlCenter::openJournal(){
+    ChangeJournal::Recovery recovery;
+    journal_ = ChangeJournal::open(filePath_, currentTable, journaling_, recovery);
+    if(recovery.found && !recovery.matched){
+        std::cerr << "\nJournal of " << filePath_ << " was written for another content of the file and was removed.";
+    }
+    if(recovery.changes > 0 || recovery.failed > 0){
+        std::cout << "\nJournal replayed. [" << recovery.changes << "/" << recovery.changes + recovery.failed
+                  << "] changes, " << recovery.unsaved << " of them not saved";
+    }
+    if(recovery.unsaved > 0){
+        upToDate = false;
+        changes_++;
+    }
+    compactedChanges_ = journal_ != nullptr ? journal_->baseChanges() : 0;
+}
+
+void ControlCenter::closeJournal(){
+    bool keep = false;
+    if(!upToDate){
+        journal_->dropUnsaved();
+        // the saved changes are replayed when the file is opened again
+        keep = journal_->savedChanges() > journal_->baseChanges();
+    }else if(journal_->savedChanges() > journal_->baseChanges()){
+        compactJournal(currentTable, *journal_, filePath_, journal_->savedChanges());
+    }
+    journal_.reset();
+    if(!keep){
+        ChangeJournal::remove(filePath_);
     }
 }
 
+uint64_t ControlCenter::csvSize(const Table& table){
+    std::string buffer;
+    uint64_t size = 0;
+    for(size_t row = 0; row < table.rowsCount(); row++){
+        for(size_t col = 0; col < table.columnsCount(); col++){
+            size += table.getConstructedCellView(row, col, buffer).size();
+        }
+        // commas between the values, new lines between the rows
+        size += table.columnsCount() - 1;
+        size += row + 1 < table.rowsCount();
+    }
+    return size;
+}
+
+std::string ControlCenter::readTable(const Table& table, const std::vector<std::string>& argumentList){
+    if(argumentList[0] == "PRINT"){
+        if(argumentList.size() != 1){
+            throw std::invalid_argument ("Invalid use of command print: too many arguments");
+        }
+        return table.print();
+    }
+    if(argumentList[0] == "GET"){
+        if(argumentList.size() != 2){
+            throw std::invalid_argument ("Invalid use of command: get <position>");
+        }
+        CellRef ref = CellRef::fromString(argumentList[1]);
+        std::string buffer;
+        return std::string(table.getDisplayableCellView(ref.row(), ref.column(), buffer));
+    }
+    if(argumentList.size() != 1){
+        throw std::invalid_argument ("Invalid use of command memstats: too many arguments");
+    }
+    return table.memoryUsage().report(csvSize(table));
+}
+
 void ControlCenter::createEmptyFile(const std::string& filename){
     if(!checkFormat(filename)){
-        throw std::invalid_argument("Only .csv file format is being currently supported. ");
+        throw std::invalid_argument("Only .csv and .xtb file formats are being currently supported. ");
     }
-    std::ifstream readFile(filename);
-    if(readFile.is_open()){
-        std::cout << "File exists. Are you sure you want to continue and rewrite it? Y/N: ";
-        bool res = confirmAction('Y', 'N');
-        if(!res){
-            return;
-        }
+    if(fileExist(filename) && !confirmOverwrite(filename)){
+        return;
+    }
+
+    if(BinaryWorkbook::hasExtension(filename)){
+        // even an empty table has a header in this format
+        BinaryWorkbook::save(Table(), filename);
+        ChangeJournal::remove(filename);
+        return;
     }
-    readFile.close();
 
     std::ofstream writeFile(filename, std::ios::trunc);
 
     writeFile.close();
+    ResultSidecar::remove(filename);
+    ChangeJournal::remove(filename);
 
 }
 
 void ControlCenter::closeFile(){
+    // a save running in the background may still make the file up to date
+    waitForSaves();
+
     if(filePath_ == ""){
         currentTable.resetTable();
         return;
     }
 
-    if(!upToDate){
+    if(!upToDate && overwrite_ != Overwrite::Ask){
+        std::cerr << "Unsaved changes of " << filePath_ << " dropped.\n";
+    }else if(!upToDate){
         std::cout << "File not saved. Would you like to save? Y/N: ";
         bool res = confirmAction('Y', 'N');
         if(res){
@@ -217,6 +571,11 @@ void ControlCenter::closeFile(){
             saveToFile(filePath_);
         }
     }
+    if(journal_ != nullptr){
+        // the file may be written again with the saved changes
+        waitForSaves();
+        closeJournal();
+    }
     filePath_ = "";
     currentTable.resetTable();
 
@@ -273,6 +632,37 @@ std::vector <std::string> ControlCenter::splitWithQuotes(const std::string& comm
 
 }
 
+std::shared_ptr<const Table> ControlCenter::snapshot(){
+    return std::make_shared<const Table>(currentTable);
+}
+
+bool ControlCenter::executeReadOnly(const Table& table, const std::string& commandLine, std::string& output){
+    std::vector<std::string> argumentList = splitWithQuotes(commandLine);
+    if(argumentList.empty()){
+        return false;
+    }
+    stringToUpper(argumentList[0]);
+    if(argumentList[0] == "STATS" && argumentList.size() == 1){
+        output = stats_.report();
+        return true;
+    }
+    if(argumentList[0] != "PRINT" && argumentList[0] != "GET" && argumentList[0] != "MEMSTATS"){
+        return false;
+    }
+
+    Statistics::Timer timer(stats_, argumentList[0]);
+    Trace::Span span("command");
+    span.argument("command", argumentList[0]);
+    if(table.hasDirtyFormulas()){
+        // reading would calculate them inside the shared table, so they are calculated in a copy of it
+        Table copy(table);
+        output = readTable(copy, argumentList);
+        return true;
+    }
+    output = readTable(table, argumentList);
+    return true;
+}
+
 const std::string ControlCenter::executeCommand(const std::string& commandLine){
 
     std::vector<std::string> argumentList = splitWithQuotes(commandLine);
@@ -284,26 +674,78 @@ const std::string ControlCenter::executeCommand(const std::string& commandLine){
     }
 
     stringToUpper(argumentList[0]);
+    collectSaves();
 
     std::string output = "";
 
+    if(argumentList[0] == "STATS"){
+        if(argumentList.size() == 1){
+            return stats_.report();
+        }
+        stringToUpper(argumentList[1]);
+        if(argumentList.size() != 2 || argumentList[1] != "RESET"){
+            throw std::invalid_argument ("Invalid use of command: stats [reset]");
+        }
+        stats_.reset();
+        return "Statistics reset";
+    }
+
+    if(argumentList[0] == "TRACE"){
+        if(argumentList.size() >= 2){
+            stringToUpper(argumentList[1]);
+        }
+        if(argumentList.size() == 2 && argumentList[1] == "START"){
+            Trace::start();
+            return "Tracing started";
+        }
+        if(argumentList.size() == 3 && argumentList[1] == "STOP"){
+            size_t spans = Trace::stop(argumentList[2]);
+            return "Trace of " + std::to_string(spans) + " spans written to " + argumentList[2];
+        }
+        throw std::invalid_argument ("Invalid use of command: trace start | trace stop <path>");
+    }
+
+    Statistics::Timer timer(stats_, argumentList[0]);
+    Trace::Span span("command");
+    span.argument("command", argumentList[0]);
+
     if(argumentList[0] == "EDIT"){
 
         if(argumentList.size() != 3){
             throw std::invalid_argument ("Invalid use of command: edit <position> <value>");
         }
-        size_t row = Table::getRow(argumentList[1]);
-        size_t col = Table::getColumn(argumentList[1]);
-        currentTable.setCellValue(row, col, argumentList[2]);
-        output += "Successfully set " + argumentList[1] + " to " + argumentList[2];
+        CellRef ref = CellRef::fromString(argumentList[1]);
+        currentTable.setCellValue(ref.row(), ref.column(), argumentList[2]);
         upToDate = false;
+        changes_++;
+        if(journal_ != nullptr){
+            journal_->recordSet(ref.row(), ref.column(), argumentList[2]);
+        }
+        output += "Successfully set " + argumentList[1] + " to " + argumentList[2];
 
-    }else if(argumentList[0] == "PRINT"){
+    }else if(argumentList[0] == "FILL"){
 
-        if(argumentList.size() != 1){
-            throw std::invalid_argument ("Invalid use of command print: too many arguments");
+        if(argumentList.size() != 3){
+            throw std::invalid_argument ("Invalid use of command: fill <position> <position>:<position>");
+        }
+        CellRef source = CellRef::fromString(argumentList[1]);
+        size_t colon = argumentList[2].find(':');
+        CellRef from = CellRef::fromString(argumentList[2].substr(0, colon));
+        CellRef to = from;
+        if(colon != std::string::npos){
+            to = CellRef::fromString(argumentList[2].substr(colon + 1));
+        }
+        currentTable.fill(source.row(), source.column(), from.row(), from.column(), to.row(), to.column());
+        upToDate = false;
+        changes_++;
+        if(journal_ != nullptr){
+            journal_->recordFill(source.row(), source.column(), from.row(), from.column(), to.row(), to.column());
         }
-        output = currentTable.print();
+        output += "Successfully filled " + argumentList[2] + " from " + argumentList[1];
+
+    }else if(argumentList[0] == "PRINT" || argumentList[0] == "GET" || argumentList[0] == "MEMSTATS"){
+
+        output = readTable(currentTable, argumentList);
 
     }else if(argumentList[0] == "OPEN"){
 
@@ -317,6 +759,7 @@ const std::string ControlCenter::executeCommand(const std::string& commandLine){
         }
         closeFile();
         loadFromFile(argumentList[1]);
+        openJournal();
 
     }else if(argumentList[0] == "CLOSE"){
 
@@ -337,6 +780,51 @@ const std::string ControlCenter::executeCommand(const std::string& commandLine){
         }
         saveToFile(argumentList[1]);
 
+    }else if(argumentList[0] == "STORAGE"){
+
+        if(argumentList.size() != 2){
+            throw std::invalid_argument ("Invalid use of command: storage <cells|columnar>");
+        }
+        stringToUpper(argumentList[1]);
+        if(argumentList[1] == "CELLS"){
+            currentTable.setColumnar(false);
+        }else if(argumentList[1] == "COLUMNAR"){
+            currentTable.setColumnar(true);
+        }else{
+            throw std::invalid_argument ("Invalid use of command: storage <cells|columnar>");
+        }
+        output += "Storage set to " + argumentList[1];
+
+    }else if(argumentList[0] == "CALCULATION"){
+
+        if(argumentList.size() != 2){
+            throw std::invalid_argument ("Invalid use of command: calculation <eager|lazy>");
+        }
+        stringToUpper(argumentList[1]);
+        if(argumentList[1] == "EAGER"){
+            currentTable.setLazyCalculation(false);
+        }else if(argumentList[1] == "LAZY"){
+            currentTable.setLazyCalculation(true);
+        }else{
+            throw std::invalid_argument ("Invalid use of command: calculation <eager|lazy>");
+        }
+        output += "Calculation set to " + argumentList[1];
+
+    }else if(argumentList[0] == "JOURNAL"){
+
+        if(argumentList.size() != 2){
+            throw std::invalid_argument ("Invalid use of command: journal <on|off>");
+        }
+        stringToUpper(argumentList[1]);
+        if(argumentList[1] == "ON"){
+            setJournaling(true);
+        }else if(argumentList[1] == "OFF"){
+            setJournaling(false);
+        }else{
+            throw std::invalid_argument ("Invalid use of command: journal <on|off>");
+        }
+        output += "Journal set to " + argumentList[1] + " for the files opened from now on";
+
     }else if(argumentList[0] == "SAVE"){
         if(filePath_ == ""){
             throw std::invalid_argument ("File not opened.");
@@ -344,6 +832,7 @@ const std::string ControlCenter::executeCommand(const std::string& commandLine){
         saveToFile(filePath_);
 
     }else{
+        timer.cancel();
         throw std::invalid_argument
             ("Unknown command: " + argumentList[0]);
     }
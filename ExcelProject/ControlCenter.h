@@ -2,9 +2,16 @@
 #define CONTROL_CENTER_H
 
 #include <iostream>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "Table.h"
+#include "ChangeJournal.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
 
 /** ControlCenter is a class which aims to centralize all the main logic of this app.
  *  An instance of this class is required in order to work with the functionality
@@ -13,13 +20,31 @@
  */
 
 class ControlCenter{
+public:
+
+    /** What happens when a command would replace an existing file - \ref setOverwrite
+     */
+    enum class Overwrite{
+        Ask,        /**< the user is asked (interactive use) */
+        Always,     /**< the file is replaced without asking */
+        Never       /**< the command fails */
+    };
 
 private:
 
     /** If a fail is opened, this variable checks whether local changes have been made
      *  without save
      */
-    bool upToDate;
+    bool upToDate = true;
+
+    /** Count of changes of the table, so that a save in the background knows whether the table
+     *  changed after it was started - \ref collectSaves
+     */
+    uint64_t changes_ = 0;
+
+    /** Whether existing files may be replaced - \ref Overwrite
+     */
+    Overwrite overwrite_ = Overwrite::Ask;
 
     /** Holds the path to the last opened file
      */
@@ -30,6 +55,46 @@ private:
      */
     Table currentTable;
 
+    /** Durations of the executed commands and of the phases of loading and saving files - \ref executeCommand
+     */
+    Statistics stats_;
+
+    /** Save which has finished in the background - \ref setBackgroundSaving
+     */
+    struct FinishedSave{
+        std::string filename;
+        uint64_t changes;       /**< \ref changes_ when the save was started */
+        bool succeeded;
+    };
+
+    /** Whether files are written by another thread - \ref setBackgroundSaving */
+    bool backgroundSaving_ = false;
+
+    /** Saves which have finished in the background but not yet been collected and the count of the
+     *  ones still running, guarded by \ref savesMutex_
+     */
+    std::vector<FinishedSave> finishedSaves_;
+    size_t runningSaves_ = 0;
+    std::mutex savesMutex_;
+    std::condition_variable savesFinished_;
+
+    /** Whether files opened from now on get a journal - \ref setJournaling */
+    bool journaling_ = false;
+
+    /** Journal of the opened file, if it has one */
+    std::shared_ptr<ChangeJournal> journal_;
+
+    /** Number of the first saved change of the journal which is not in the file and not being written into it,
+     *  and how many saved changes make the file written again - \ref setCompactionChanges
+     */
+    uint64_t compactedChanges_ = 0;
+    uint64_t compactionChanges_ = COMPACTION_CHANGES;
+
+    /** Thread writing the files in the background, one after another, created by the first such save.
+     *  Declared last, so that it finishes the saves before anything they use is destroyed.
+     */
+    std::unique_ptr<ThreadPool> saver_;
+
     /** Given a string, this method splits it by whitespace where
      *  \li Quotes indicate that anything inside them should be considered as a whole.
      *  Does not include the quotes themselves.
@@ -45,11 +110,20 @@ private:
     /** Makes the user to confirm its most recent action. Usually used to warn
      *  the user that their action might have result, which does not satisfy
      *  the user themselves.
+     *  \n If there is nothing more to read from the standard input, the action is not confirmed.
      *
      *  \param 2 char parameters which should be considered as yes and no respectively
      */
     bool confirmAction(char yes, char no);
 
+    /** Decides whether an existing file may be replaced, according to \ref overwrite_.
+     *  Saving the opened file again is always allowed, unless the user is asked and refuses.
+     *
+     *  \exception invalid_argument the file exists and the policy is \ref Overwrite::Never
+     *  \return whether to continue
+     */
+    bool confirmOverwrite(const std::string& filename);
+
     /** Given a string, changes all lower case English chars inside into upper case
      *
      *  \param string to be turned into upper case
@@ -64,7 +138,7 @@ private:
     bool fileExist(const std::string& filename);
 
     /** Checks whether a string has acceptable format. For this app, this means
-     *  to end on '.csv' and have non-empty filename
+     *  to end on '.csv' or '.xtb' (\ref BinaryWorkbook) and have non-empty filename
      *
      *  \param path or filename to check
      *  \return whether the file is from valid format or not
@@ -81,7 +155,8 @@ private:
 
     /** Similar to other text editor's close file functionality, this method also:
      *  \li checks whether there's actually a file to be closed
-     *  \li remind the user to save if it means that they would lose local changes otherwise - \ref confirmAction
+     *  \li remind the user to save if it means that they would lose local changes otherwise - \ref confirmAction.
+     *  Unless the user is asked (\ref Overwrite::Ask), unsaved changes are dropped with a warning: scripts save explicitly.
      *
      *  \exception invalid_argument unsupported file format
      *  \param path or filename of the file to be created
@@ -91,6 +166,10 @@ private:
     /** Reads table cell values from csv file, where every rows means new table row and
      *  every comma means start of a new column. The information is saved into a local instance
      *  of class Table in this class
+     *  \n Formulas are calculated once after all cells are read, unless their results were saved
+     *  together with the file - \ref ResultSidecar
+     *  \n Durations of the phases are recorded: "load: read" (lines of the file), "load: parse" (splitting
+     *  them into values), "load: type" (creating the cells) and "load: recalc" (results of the formulas)
      *
      *  \exception invalid_argument unsupported file format
      *  \exception invalid_argument file not found
@@ -103,6 +182,9 @@ private:
      *  filename, where before processing to action, checks whether file with such a path
      *  or filename exists and if it does, informs the user and waits for its confirmation or disallowing
      *  of continuing the process.
+     *  \n With \ref setBackgroundSaving, the file is written by another thread from a snapshot of the table
+     *  (\ref Table::operator=) and this method returns right away.
+     *  \n Saving the opened file with a journal only appends to the journal - \ref setJournaling
      *
      *  \exception invalid_argument unsupported file format
      *  \exception invalid_argument Unexpected error while processing to write into the file.
@@ -110,13 +192,115 @@ private:
      */
     void saveToFile(const std::string& filename);
 
+    /** Writes a table to a file - \ref saveToFile. The content is written to a temporary file next to it,
+     *  which then replaces the file, so that the file is never left half written.
+     *  \n Results of the formulas are saved next to a csv file - \ref ResultSidecar
+     *  \n Durations of the phases are recorded: "save: format" (values of the cells as text),
+     *  "save: write" and "save: results"
+     *
+     *  \param written called with the temporary file after it is written, before it replaces the file
+     *  \exception invalid_argument Unexpected error while processing to write into the file.
+     */
+    void writeTable(const Table& table, const std::string& filename,
+                    const std::function<void(const std::string&)>& written = nullptr);
+
+    /** Writes a snapshot of the current table by another thread - \ref setBackgroundSaving
+     *
+     *  \param write writes the snapshot, the failure is reported if it throws
+     */
+    void runInBackground(const std::string& filename, const std::function<void(const Table&)>& write);
+
+    /** Starts to journal the changes of the file just opened, if it has a journal or should get one,
+     *  after replaying the changes of its journal - \ref ChangeJournal::open
+     */
+    void openJournal();
+
+    /** Writes the file again with the changes of its journal, up to a number, which are then forgotten by the
+     *  journal. The table should be the file with exactly those changes.
+     *
+     *  \exception invalid_argument the file or the journal cannot be written
+     */
+    void compactJournal(const Table& table, ChangeJournal& journal, const std::string& filename, uint64_t changes);
+
+    /** Stops journaling the opened file while closing it. If the changes were saved, the file is written again
+     *  with them and the journal is removed, otherwise the unsaved changes are forgotten by the journal.
+     */
+    void closeJournal();
+
+    /** Takes the saves which have finished in the background. The opened file is up to date if it was saved
+     *  successfully and the table has not changed since the save was started.
+     */
+    void collectSaves();
+
+    /** \return size in bytes of a table written as a csv file - \ref saveToFile
+     */
+    static uint64_t csvSize(const Table& table);
+
+    /** Executes PRINT, GET or MEMSTATS on a table
+     *
+     *  \param argumentList the command split into arguments, its name in upper case - \ref splitWithQuotes
+     *  \exception invalid_argument wrong arguments
+     */
+    static std::string readTable(const Table& table, const std::vector<std::string>& argumentList);
+
 
 
 public:
+
+    /** Count of saved changes of a journal after which the file is written again with them by default -
+     *  \ref setCompactionChanges
+     */
+    static constexpr uint64_t COMPACTION_CHANGES = 10000;
+
     /** Empty constructor
      */
     ControlCenter();
 
+    /** Sets what happens when a command would replace an existing file. With any other policy than
+     *  \ref Overwrite::Ask, no command waits for the user - e.g. for running scripts - \ref ScriptRunner
+     */
+    void setOverwrite(Overwrite overwrite);
+
+    /** \return what happens when a command would replace an existing file
+     */
+    Overwrite overwrite() const;
+
+    /** Chooses how SAVE and SAVEAS write the files.
+     *  \li false (default) - the command returns after the file is written, and fails if it cannot be written
+     *  \li true - the command returns right away and the file is written by another thread, while the next
+     *  commands are executed. When it is done, "Saved <file>" is written to the standard output, or
+     *  the reason of the failure to the standard error.
+     *  \n Commands closing the file wait for the saves to finish first.
+     */
+    void setBackgroundSaving(bool background);
+
+    /** \return whether files are written by another thread - \ref setBackgroundSaving
+     */
+    bool isBackgroundSaving() const;
+
+    /** Waits until every save running in the background has finished - \ref setBackgroundSaving
+     */
+    void waitForSaves();
+
+    /** Chooses whether files opened from now on get a journal of their changes - \ref ChangeJournal.
+     *  Also set by command JOURNAL ON / JOURNAL OFF.
+     *  \n With a journal, SAVE only appends to the journal. The file itself is written again with the saved
+     *  changes after every \ref setCompactionChanges of them (in the background with \ref setBackgroundSaving)
+     *  and when it is closed, the journal is removed then.
+     *  \n A file which has a journal (e.g. the program ended without closing it) always uses it: the changes
+     *  are replayed when it is opened.
+     */
+    void setJournaling(bool journaling);
+
+    /** \return whether files opened from now on get a journal - \ref setJournaling
+     */
+    bool isJournaling() const;
+
+    /** Sets the count of saved changes of a journal after which the file is written again with them -
+     *  \ref setJournaling
+     */
+    void setCompactionChanges(uint64_t changes);
+
     /** Given a command, this function tries to execute it. 3 Possible outcomes:
      *  \li command execution was successful, but had no purpose of giving feedback,
      *  so it returns empty string
@@ -124,11 +308,33 @@ public:
      *  information related with the executed command
      *  \li command execution was not successful, so it throws an exception
      *  any or does not catch any thrown exception
+     *  \n The duration of every command is recorded, also of the failed ones. Command STATS shows them
+     *  together with the work done meanwhile, STATS RESET forgets them - \ref Statistics
+     *  \n GET followed by a position (e.g. GET B3) gives the displayed value of that cell.
+     *  \n MEMSTATS shows how much memory the current table takes and what for - \ref Table::memoryUsage
+     *  \n TRACE START records what the commands do until TRACE STOP writes it to the given file - \ref Trace
+     *  \n JOURNAL ON / JOURNAL OFF - \ref setJournaling
      *
      *  \exception invalid_argument Thrown to signal that the request failed
      */
     const std::string executeCommand(const std::string& commandLine);
 
+    /** \return a copy of the current table, which any count of threads can read at once while this control center
+     *  changes the table - \ref Table::operator=. Formulas waiting to be calculated (\ref Table::setLazyCalculation)
+     *  are not calculated, they stay dirty in the copy too - \ref executeReadOnly
+     */
+    std::shared_ptr<const Table> snapshot();
+
+    /** Executes a command which only reads the table (PRINT, GET, MEMSTATS, STATS) on a copy of it - \ref snapshot.
+     *  Can be called by several threads at once, also while another thread executes commands - e.g. \ref Server.
+     *  If the table has dirty formulas, they are calculated in a private copy of it, so the table is never changed.
+     *
+     *  \param output receives the result of the command
+     *  \return false if the command is not one of those, in which case nothing is executed
+     *  \exception invalid_argument the command failed
+     */
+    bool executeReadOnly(const Table& table, const std::string& commandLine, std::string& output);
+
 };
 
 
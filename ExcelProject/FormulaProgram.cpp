@@ -0,0 +1,846 @@
+#include <math.h>
+#include <cctype>
+#include <limits>
+#include <algorithm>
+#include <charconv>
+
+#include "FormulaProgram.h"
+#include "CellDouble.h"
+#include "CellRef.h"
+#include "Table.h"
+
+static_assert(sizeof(FormulaProgram::Instruction) == 40, "Instructions are stored in files as they are");
+
+FormulaProgram::FormulaProgram(){
+
+}
+
+FormulaProgram::FormulaProgram(const std::vector<Instruction>& code)
+    :code_(code)
+{
+    measureStacks();
+}
+
+void FormulaProgram::measureStacks(){
+    // an evaluation stops at the first instruction which fails, so it never gets deeper than this
+    size_t values = 0;
+    size_t arguments = 0;
+    valuesDepth_ = 0;
+    argumentsDepth_ = 0;
+    for(const Instruction& ins : code_){
+        switch(ins.code){
+        case OpCode::Number:
+        case OpCode::Cell:
+        case OpCode::SumProduct:
+            values++;
+            break;
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide:
+        case OpCode::Power:
+            if(values < 2){
+                return;
+            }
+            values--;
+            break;
+        case OpCode::Range:
+            arguments++;
+            break;
+        case OpCode::Value:
+            if(values == 0){
+                return;
+            }
+            values--;
+            arguments++;
+            break;
+        case OpCode::Function:
+            if(arguments < ins.count){
+                return;
+            }
+            arguments -= ins.count;
+            values++;
+            break;
+        default:
+            return;
+        }
+        valuesDepth_ = std::max(valuesDepth_, values);
+        argumentsDepth_ = std::max(argumentsDepth_, arguments);
+    }
+}
+
+bool FormulaProgram::isRange(std::string_view str, Instruction& range){
+    size_t colon = str.find(':');
+    if(colon == std::string_view::npos){
+        return false;
+    }
+    CellRef from, to;
+    if(!CellRef::parse(str.substr(0, colon), from) || !CellRef::parse(str.substr(colon + 1), to)){
+        return false;
+    }
+    range.fromRow = std::min(from.row(), to.row());
+    range.fromColumn = std::min(from.column(), to.column());
+    range.toRow = std::max(from.row(), to.row());
+    range.toColumn = std::max(from.column(), to.column());
+    return true;
+}
+
+bool FormulaProgram::applyOperation(OpCode code, double left, double right, double& result){
+    if(code == OpCode::Add){
+        result = left + right;
+    }else if(code == OpCode::Subtract){
+        result = left - right;
+    }else if(code == OpCode::Multiply){
+        result = left * right;
+    }else if(code == OpCode::Divide){
+        if(fabs(right) < zero_){
+            return false;
+        }
+        result = left / right;
+    }else{
+        result = pow(left, right);
+    }
+    return true;
+}
+
+void FormulaProgram::appendOperation(OpCode code, size_t leftStart, size_t rightStart){
+    bool leftNumber = rightStart == leftStart + 1 && code_[leftStart].code == OpCode::Number;
+    bool rightNumber = code_.size() == rightStart + 1 && code_[rightStart].code == OpCode::Number;
+    double result;
+    if(leftNumber && rightNumber && applyOperation(code, code_[leftStart].number, code_[rightStart].number, result)){
+        code_.pop_back();
+        code_.back().number = result;
+        return;
+    }
+    if(rightNumber){
+        double right = code_[rightStart].number;
+        if(((code == OpCode::Multiply || code == OpCode::Divide || code == OpCode::Power) && right == 1) ||
+           (code == OpCode::Subtract && right == 0 && !signbit(right))){
+            code_.pop_back();
+            return;
+        }
+    }
+    if(leftNumber && code == OpCode::Multiply && code_[leftStart].number == 1){
+        code_.erase(code_.begin() + leftStart);
+        return;
+    }
+    Instruction operation;
+    operation.code = code;
+    code_.push_back(operation);
+}
+
+namespace{
+
+/** Operation or bracket waiting on the stack of \ref FormulaProgram::compileExpression
+ */
+struct Pending{
+    enum class Kind : uint8_t{
+        Operation,
+        Bracket,
+        Function
+    };
+    Kind kind;
+    FormulaProgram::OpCode code;            /**< operation */
+    FormulaProgram::Function function;      /**< function */
+    uint32_t count;                         /**< function - count of arguments so far */
+    size_t codeStart;                       /**< function - where its instructions start */
+    size_t operands;                        /**< function - count of operands on the stack when it was called */
+};
+
+bool isOperation(char ch){
+    return ch == '+' || ch == '-' || ch == '*' || ch == '/' || ch == '^';
+}
+
+/** end of the operand starting at the given position - numbers, references, ranges and names of functions
+ */
+size_t operandEnd(const std::string& str, size_t pos){
+    while(pos < str.size() && !isOperation(str[pos]) && str[pos] != '(' && str[pos] != ')' && str[pos] != ','){
+        pos++;
+    }
+    return pos;
+}
+
+/** priority of an operation - the higher, the sooner it is calculated
+ */
+int priority(FormulaProgram::OpCode code){
+    if(code == FormulaProgram::OpCode::Add || code == FormulaProgram::OpCode::Subtract){
+        return 1;
+    }
+    if(code == FormulaProgram::OpCode::Multiply || code == FormulaProgram::OpCode::Divide){
+        return 2;
+    }
+    return 3;
+}
+
+bool equalsIgnoreCase(std::string_view str, const char* upper){
+    size_t i = 0;
+    for(; i < str.size() && upper[i] != '\0'; i++){
+        if(toupper((unsigned char)str[i]) != upper[i]){
+            return false;
+        }
+    }
+    return i == str.size() && upper[i] == '\0';
+}
+
+}
+
+bool FormulaProgram::findFunction(std::string_view name, Function& function){
+    static const std::pair<const char*, Function> functions[] = {
+        {"SUM", Function::Sum}, {"AVERAGE", Function::Average}, {"MIN", Function::Min},
+        {"MAX", Function::Max}, {"COUNT", Function::Count}
+    };
+    for(const auto& candidate : functions){
+        if(equalsIgnoreCase(name, candidate.first)){
+            function = candidate.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t FormulaProgram::compileSumProduct(const std::string& expression, size_t pos){
+    Instruction first, second;
+    size_t firstEnd = operandEnd(expression, pos);
+    size_t secondEnd = (firstEnd < expression.size() && expression[firstEnd] == ',')
+                       ? operandEnd(expression, firstEnd + 1) : firstEnd;
+    if(secondEnd == firstEnd || secondEnd >= expression.size() || expression[secondEnd] != ')'
+        || !isRange(std::string_view(expression).substr(pos, firstEnd - pos), first)
+        || !isRange(std::string_view(expression).substr(firstEnd + 1, secondEnd - firstEnd - 1), second)){
+        throw std::invalid_argument("SUMPRODUCT takes exactly 2 ranges");
+    }
+    if(first.toRow - first.fromRow != second.toRow - second.fromRow
+        || first.toColumn - first.fromColumn != second.toColumn - second.fromColumn){
+        throw std::invalid_argument("SUMPRODUCT ranges must have the same size");
+    }
+    first.code = OpCode::SumProduct;
+    first.otherRow = second.fromRow;
+    first.otherColumn = second.fromColumn;
+    code_.push_back(first);
+    return secondEnd + 1;
+}
+
+void FormulaProgram::compileExpression(const std::string& expression){
+    // operations and brackets which are not complete yet, and where the code of every operand
+    // which does not belong to a complete operation yet starts
+    std::vector<Pending> pending;
+    std::vector<size_t> operands;
+
+    // every operation, bracket and comma adds at most 2 instructions (an operand and the operation, or the call of
+    // a function and its last argument), so the program never needs to grow while it is compiled
+    size_t separators = 0;
+    for(size_t i = 0; i < expression.size(); i++){
+        char ch = expression[i];
+        separators += isOperation(ch) || ch == '(' || ch == ',';
+    }
+    code_.reserve(code_.size() + 2 * separators + 1);
+
+    auto reduce = [&](){
+        size_t rightStart = operands.back();
+        operands.pop_back();
+        appendOperation(pending.back().code, operands.back(), rightStart);
+        pending.pop_back();
+    };
+    auto reduceAll = [&](){
+        while(!pending.empty() && pending.back().kind == Pending::Kind::Operation){
+            reduce();
+        }
+    };
+    // the argument of the innermost function is complete
+    auto completeArgument = [&](){
+        if(pending.empty() || pending.back().kind != Pending::Kind::Function){
+            throw std::invalid_argument("Comma outside of a function");
+        }
+        Pending& call = pending.back();
+        if(operands.size() > call.operands){
+            // an expression, given to the function as a number
+            operands.pop_back();
+            Instruction argument;
+            argument.code = OpCode::Value;
+            argument.function = call.function;
+            code_.push_back(argument);
+        }
+        call.count++;
+    };
+
+    bool expectOperand = true;
+    bool expressionStart = true;
+    bool argumentStart = false;
+    size_t pos = 0;
+    while(pos < expression.size()){
+        char ch = expression[pos];
+
+        if(expectOperand){
+            if(expressionStart && (ch == '+' || ch == '-')){
+                // leading sign - the expression is subtracted from (added to) 0
+                operands.push_back(code_.size());
+                code_.push_back(Instruction());
+                expectOperand = expressionStart = argumentStart = false;
+                continue;
+            }
+            if(ch == '('){
+                Pending bracket = {};
+                bracket.kind = Pending::Kind::Bracket;
+                pending.push_back(bracket);
+                expressionStart = true;
+                argumentStart = false;
+                pos++;
+                continue;
+            }
+
+            size_t end = operandEnd(expression, pos);
+            if(end == pos){
+                throw std::invalid_argument("Invalid string. Possibly, a binary operation with fewer than 2 operands was given.");
+            }
+            std::string_view operand = std::string_view(expression).substr(pos, end - pos);
+            bool argumentEnd = end < expression.size() && (expression[end] == ',' || expression[end] == ')');
+            Instruction instruction;
+            CellRef ref;
+
+            if(end < expression.size() && expression[end] == '('){
+                // call of a function
+                size_t nameLength = 0;
+                while(nameLength < operand.size() && isalpha((unsigned char)operand[nameLength])){
+                    nameLength++;
+                }
+                if(nameLength != operand.size()){
+                    throw std::invalid_argument("Entered formula is incorrect - contains unrecognizable characters");
+                }
+                if(end + 1 < expression.size() && expression[end + 1] == ')'){
+                    throw std::invalid_argument("Function called without arguments");
+                }
+                if(equalsIgnoreCase(operand, "SUMPRODUCT")){
+                    operands.push_back(code_.size());
+                    pos = compileSumProduct(expression, end + 1);
+                    expectOperand = expressionStart = argumentStart = false;
+                    continue;
+                }
+                Pending call = {};
+                call.kind = Pending::Kind::Function;
+                if(!findFunction(operand, call.function)){
+                    throw std::invalid_argument("Unknown function: " + std::string(operand));
+                }
+                call.codeStart = code_.size();
+                call.operands = operands.size();
+                pending.push_back(call);
+                expressionStart = argumentStart = true;
+                pos = end + 1;
+                continue;
+            }
+
+            if(argumentStart && argumentEnd && isRange(operand, instruction)){
+                instruction.code = OpCode::Range;
+            }else if(CellRef::parse(operand, ref)){
+                // a single reference given to a function behaves as a range of 1 cell
+                instruction.code = (argumentStart && argumentEnd) ? OpCode::Range : OpCode::Cell;
+                instruction.fromRow = instruction.toRow = ref.row();
+                instruction.fromColumn = instruction.toColumn = ref.column();
+            }else{
+                // anything else is a number
+                try{
+                    CellDouble number;
+                    number.setValue(std::string(operand));
+                    instruction.number = number.getValue();
+                }catch(std::invalid_argument& e){
+                    throw std::invalid_argument("Entered formula is incorrect - contains unrecognizable characters");
+                }catch(std::out_of_range& e){
+                    throw std::invalid_argument("Number is too large");
+                }
+            }
+            if(instruction.code == OpCode::Range){
+                // an argument on its own, not an operand
+                instruction.function = pending.back().function;
+                code_.push_back(instruction);
+            }else{
+                operands.push_back(code_.size());
+                code_.push_back(instruction);
+            }
+            expectOperand = expressionStart = argumentStart = false;
+            pos = end;
+            continue;
+        }
+
+        if(isOperation(ch)){
+            OpCode code = (ch == '+') ? OpCode::Add : (ch == '-') ? OpCode::Subtract : (ch == '*') ? OpCode::Multiply
+                          : (ch == '/') ? OpCode::Divide : OpCode::Power;
+            // * and / are calculated from right to left, + - and ^ from left to right
+            bool rightToLeft = priority(code) == 2;
+            while(!pending.empty() && pending.back().kind == Pending::Kind::Operation
+                  && (priority(pending.back().code) > priority(code)
+                      || (priority(pending.back().code) == priority(code) && !rightToLeft))){
+                reduce();
+            }
+            Pending operation = {};
+            operation.kind = Pending::Kind::Operation;
+            operation.code = code;
+            pending.push_back(operation);
+            expectOperand = true;
+            pos++;
+        }else if(ch == ')'){
+            reduceAll();
+            if(pending.empty()){
+                throw std::invalid_argument("Closing bracket without an opening one");
+            }
+            if(pending.back().kind == Pending::Kind::Function){
+                completeArgument();
+                Instruction call;
+                call.code = OpCode::Function;
+                call.function = pending.back().function;
+                call.count = pending.back().count;
+                code_.push_back(call);
+                operands.push_back(pending.back().codeStart);
+            }
+            pending.pop_back();
+            pos++;
+        }else if(ch == ','){
+            reduceAll();
+            completeArgument();
+            expectOperand = expressionStart = argumentStart = true;
+            pos++;
+        }else{
+            throw std::invalid_argument("Operand without an operation before it");
+        }
+    }
+
+    if(expectOperand){
+        throw std::invalid_argument("Invalid string. Possibly, a binary operation with fewer than 2 operands was given.");
+    }
+    reduceAll();
+    if(!pending.empty()){
+        throw std::invalid_argument("Opening bracket without a closing one");
+    }
+}
+
+FormulaProgram FormulaProgram::compile(const std::string& formula){
+    FormulaProgram program;
+    if(formula.empty() || formula[0] != '='){
+        return program;
+    }
+
+    std::string pureFormula = formula.substr(1);
+    pureFormula.erase(std::remove(pureFormula.begin(), pureFormula.end(), ' '), pureFormula.end());
+
+    try{
+        program.compileExpression(pureFormula);
+    }catch(std::invalid_argument& e){
+        program.code_.clear();
+    }
+    program.measureStacks();
+    return program;
+}
+
+bool FormulaProgram::isValid() const{
+    return !code_.empty();
+}
+
+const std::vector<FormulaProgram::Instruction>& FormulaProgram::code() const{
+    return code_;
+}
+
+bool FormulaProgram::shiftPosition(uint32_t row, uint32_t column, int64_t rowOffset, int64_t columnOffset,
+                                   size_t& shiftedRow, size_t& shiftedColumn){
+    int64_t newRow = (int64_t)row + rowOffset;
+    int64_t newColumn = (int64_t)column + columnOffset;
+    if(newRow < 0 || newRow > (int64_t)CellRef::LAST_ROW || newColumn < 0 || newColumn >= (int64_t)CellRef::MAX_COLUMNS){
+        return false;
+    }
+    shiftedRow = newRow;
+    shiftedColumn = newColumn;
+    return true;
+}
+
+std::string FormulaProgram::shiftReferences(const std::string& formula, int64_t rowOffset, int64_t columnOffset){
+    std::string result;
+    result.reserve(formula.size() + 8);
+    shiftReferences(formula, rowOffset, columnOffset, result);
+    return result;
+}
+
+void FormulaProgram::shiftReferences(const std::string& formula, int64_t rowOffset, int64_t columnOffset, std::string& result){
+    result.clear();
+    for(size_t i = 0; i < formula.size(); ){
+        // a reference cannot continue a number or a name
+        bool boundary = i == 0 || !(isalnum((unsigned char)formula[i - 1]) || formula[i - 1] == '.');
+        CellRef ref;
+        size_t length = boundary ? CellRef::parsePrefix(std::string_view(formula).substr(i), ref) : 0;
+        if(length == 0){
+            result += formula[i++];
+            continue;
+        }
+        size_t row, column;
+        if(shiftPosition(ref.row(), ref.column(), rowOffset, columnOffset, row, column)){
+            CellRef::appendColumnName(column, result);
+            char digits[24];
+            std::to_chars_result res = std::to_chars(digits, digits + sizeof(digits), row);
+            result.append(digits, res.ptr);
+        }else{
+            result += "#REF";
+        }
+        i += length;
+    }
+}
+
+const char* FormulaProgram::errorText(Error error){
+    switch(error){
+    case Error::None:
+        return "";
+    case Error::DivideByZero:
+        return "#DIV/0";
+    case Error::Reference:
+        return "#REF";
+    case Error::Cycle:
+        return "#CYCLE";
+    default:
+        return "#VALUE";
+    }
+}
+
+FormulaProgram::Error FormulaProgram::evaluate(const Table& table, double& result, int64_t rowOffset, int64_t columnOffset) const{
+    result = 0;
+    if(code_.empty()){
+        return Error::Value;
+    }
+    size_t fromRow, fromColumn, toRow, toColumn, otherRow, otherColumn;
+
+    // the stacks are kept in local arrays, unless the program needs deeper ones - \ref measureStacks
+    double localValues[LOCAL_STACK];
+    Table::RangeAggregate localArguments[LOCAL_STACK];
+    // the error of every argument, if it has one - errors inside ranges matter only after the function is known
+    Error localErrors[LOCAL_STACK];
+    std::vector<double> heapValues;
+    std::vector<Table::RangeAggregate> heapArguments;
+    std::vector<Error> heapErrors;
+    double* values = localValues;
+    Table::RangeAggregate* arguments = localArguments;
+    Error* argumentErrors = localErrors;
+    if(valuesDepth_ > LOCAL_STACK){
+        heapValues.resize(valuesDepth_);
+        values = heapValues.data();
+    }
+    if(argumentsDepth_ > LOCAL_STACK){
+        heapArguments.resize(argumentsDepth_);
+        heapErrors.resize(argumentsDepth_);
+        arguments = heapArguments.data();
+        argumentErrors = heapErrors.data();
+    }
+    size_t depth = 0;
+    size_t argumentsDepth = 0;
+
+    for(size_t i = 0; i < code_.size(); i++){
+        const Instruction& ins = code_[i];
+        switch(ins.code){
+        case OpCode::Number:
+            values[depth++] = ins.number;
+            break;
+
+        case OpCode::Cell:{
+            double value;
+            if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset, columnOffset, fromRow, fromColumn)){
+                return Error::Reference;
+            }
+            if(table.getNumericValue(fromRow, fromColumn, value) == Table::ValueKind::Error){
+                return table.getFormulaError(fromRow, fromColumn);
+            }
+            values[depth++] = value;
+            break;
+        }
+
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide:
+        case OpCode::Power:{
+            if(depth < 2){
+                return Error::Value;
+            }
+            double right = values[--depth];
+            double& left = values[depth - 1];
+            if(!applyOperation(ins.code, left, right, left)){
+                return Error::DivideByZero;
+            }
+            break;
+        }
+
+        case OpCode::Range:
+            if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset, columnOffset, fromRow, fromColumn) ||
+               !shiftPosition(ins.toRow, ins.toColumn, rowOffset, columnOffset, toRow, toColumn)){
+                return Error::Reference;
+            }
+            arguments[argumentsDepth] = table.aggregateRange(fromRow, fromColumn, toRow, toColumn);
+            argumentErrors[argumentsDepth] = Error::None;
+            if(arguments[argumentsDepth].error){
+                argumentErrors[argumentsDepth] = std::max(table.findRangeError(fromRow, fromColumn, toRow, toColumn), Error::Value);
+            }
+            argumentsDepth++;
+            break;
+
+        case OpCode::Value:{
+            if(depth == 0){
+                return Error::Value;
+            }
+            Table::RangeAggregate& argument = arguments[argumentsDepth];
+            argument = Table::RangeAggregate();
+            argument.sum = argument.min = argument.max = values[--depth];
+            argument.count = 1;
+            argumentErrors[argumentsDepth] = Error::None;
+            argumentsDepth++;
+            break;
+        }
+
+        case OpCode::Function:{
+            if(argumentsDepth < ins.count){
+                return Error::Value;
+            }
+            Table::RangeAggregate total;
+            Error error = Error::None;
+            total.min = std::numeric_limits<double>::infinity();
+            total.max = -std::numeric_limits<double>::infinity();
+            for(size_t arg = argumentsDepth - ins.count; arg < argumentsDepth; arg++){
+                const Table::RangeAggregate& part = arguments[arg];
+                if(part.count > 0){
+                    total.sum += part.sum;
+                    total.min = std::min(total.min, part.min);
+                    total.max = std::max(total.max, part.max);
+                    total.count += part.count;
+                }
+                if(error == Error::None){
+                    error = argumentErrors[arg];
+                }
+            }
+            argumentsDepth -= ins.count;
+
+            // as in other spreadsheets, count skips the cells it cannot use, including errors
+            if(ins.function == Function::Count){
+                values[depth++] = total.count;
+                break;
+            }
+            if(error != Error::None){
+                return error;
+            }
+            if(ins.function == Function::Sum){
+                values[depth++] = total.sum;
+            }else if(ins.function == Function::Average){
+                if(total.count == 0){
+                    return Error::DivideByZero;
+                }
+                values[depth++] = total.sum / total.count;
+            }else if(total.count == 0){
+                // MIN and MAX of no numbers
+                values[depth++] = 0;
+            }else{
+                values[depth++] = ins.function == Function::Min ? total.min : total.max;
+            }
+            break;
+        }
+
+        case OpCode::SumProduct:{
+            double value;
+            if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset, columnOffset, fromRow, fromColumn) ||
+               !shiftPosition(ins.toRow, ins.toColumn, rowOffset, columnOffset, toRow, toColumn) ||
+               !shiftPosition(ins.otherRow, ins.otherColumn, rowOffset, columnOffset, otherRow, otherColumn) ||
+               otherRow + (toRow - fromRow) > CellRef::LAST_ROW ||
+               otherColumn + (toColumn - fromColumn) >= CellRef::MAX_COLUMNS){
+                return Error::Reference;
+            }
+            if(!table.sumProductRanges(fromRow, fromColumn, toRow, toColumn, otherRow, otherColumn, value)){
+                Error error = table.findRangeError(fromRow, fromColumn, toRow, toColumn);
+                if(error == Error::None){
+                    error = table.findRangeError(otherRow, otherColumn, otherRow + (toRow - fromRow),
+                                                 otherColumn + (toColumn - fromColumn));
+                }
+                return std::max(error, Error::Value);
+            }
+            values[depth++] = value;
+            break;
+        }
+
+        default:
+            return Error::Value;
+        }
+    }
+
+    if(depth != 1 || argumentsDepth != 0){
+        return Error::Value;
+    }
+    result = values[0];
+    return Error::None;
+}
+
+bool FormulaProgram::evaluateRun(const Table& table, int64_t rowOffset, int64_t columnOffset, size_t count, double* results) const{
+    if(code_.empty() || count == 0){
+        return false;
+    }
+    size_t fromRow, fromColumn, toRow, toColumn, otherRow, otherColumn;
+
+    // every slot of both stacks holds one entry per cell of the run
+    std::vector<double> values;
+    std::vector<Table::RangeAggregate> arguments;
+    size_t depth = 0;
+    size_t argumentsDepth = 0;
+    values.reserve(valuesDepth_ * count);
+    arguments.reserve(argumentsDepth_ * count);
+
+    for(size_t i = 0; i < code_.size(); i++){
+        const Instruction& ins = code_[i];
+        switch(ins.code){
+        case OpCode::Number:{
+            values.resize((depth + 1) * count);
+            std::fill(values.begin() + depth * count, values.end(), ins.number);
+            depth++;
+            break;
+        }
+
+        case OpCode::Cell:{
+            // the cells of the run refer to consecutive rows of one column
+            if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset, columnOffset, fromRow, fromColumn) ||
+               !shiftPosition(ins.fromRow, ins.fromColumn, rowOffset + (int64_t)count - 1, columnOffset, toRow, toColumn)){
+                return false;
+            }
+            values.resize((depth + 1) * count);
+            if(!table.gatherNumericValues(fromRow, fromColumn, count, values.data() + depth * count)){
+                return false;
+            }
+            depth++;
+            break;
+        }
+
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide:
+        case OpCode::Power:{
+            if(depth < 2){
+                return false;
+            }
+            double* left = values.data() + (depth - 2) * count;
+            const double* right = left + count;
+            if(ins.code == OpCode::Add){
+                for(size_t k = 0; k < count; k++){
+                    left[k] += right[k];
+                }
+            }else if(ins.code == OpCode::Subtract){
+                for(size_t k = 0; k < count; k++){
+                    left[k] -= right[k];
+                }
+            }else if(ins.code == OpCode::Multiply){
+                for(size_t k = 0; k < count; k++){
+                    left[k] *= right[k];
+                }
+            }else if(ins.code == OpCode::Divide){
+                bool divisible = true;
+                for(size_t k = 0; k < count; k++){
+                    divisible &= fabs(right[k]) >= zero_;
+                }
+                if(!divisible){
+                    return false;
+                }
+                for(size_t k = 0; k < count; k++){
+                    left[k] /= right[k];
+                }
+            }else{
+                for(size_t k = 0; k < count; k++){
+                    left[k] = pow(left[k], right[k]);
+                }
+            }
+            depth--;
+            values.resize(depth * count);
+            break;
+        }
+
+        case OpCode::Range:
+            arguments.resize((argumentsDepth + 1) * count);
+            for(size_t k = 0; k < count; k++){
+                if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset + (int64_t)k, columnOffset, fromRow, fromColumn) ||
+                   !shiftPosition(ins.toRow, ins.toColumn, rowOffset + (int64_t)k, columnOffset, toRow, toColumn)){
+                    return false;
+                }
+                arguments[argumentsDepth * count + k] = table.aggregateRange(fromRow, fromColumn, toRow, toColumn);
+            }
+            argumentsDepth++;
+            break;
+
+        case OpCode::Value:{
+            if(depth == 0){
+                return false;
+            }
+            depth--;
+            arguments.resize((argumentsDepth + 1) * count);
+            for(size_t k = 0; k < count; k++){
+                Table::RangeAggregate& argument = arguments[argumentsDepth * count + k];
+                argument = Table::RangeAggregate();
+                argument.sum = argument.min = argument.max = values[depth * count + k];
+                argument.count = 1;
+            }
+            values.resize(depth * count);
+            argumentsDepth++;
+            break;
+        }
+
+        case OpCode::Function:{
+            if(argumentsDepth < ins.count){
+                return false;
+            }
+            argumentsDepth -= ins.count;
+            values.resize((depth + 1) * count);
+            for(size_t k = 0; k < count; k++){
+                Table::RangeAggregate total;
+                total.min = std::numeric_limits<double>::infinity();
+                total.max = -std::numeric_limits<double>::infinity();
+                for(size_t arg = argumentsDepth; arg < argumentsDepth + ins.count; arg++){
+                    const Table::RangeAggregate& part = arguments[arg * count + k];
+                    if(part.count > 0){
+                        total.sum += part.sum;
+                        total.min = std::min(total.min, part.min);
+                        total.max = std::max(total.max, part.max);
+                        total.count += part.count;
+                    }
+                    total.error = total.error || part.error;
+                }
+
+                double& value = values[depth * count + k];
+                if(ins.function == Function::Count){
+                    value = total.count;
+                }else if(total.error || (ins.function == Function::Average && total.count == 0)){
+                    return false;
+                }else if(ins.function == Function::Sum){
+                    value = total.sum;
+                }else if(ins.function == Function::Average){
+                    value = total.sum / total.count;
+                }else if(total.count == 0){
+                    value = 0;
+                }else{
+                    value = ins.function == Function::Min ? total.min : total.max;
+                }
+            }
+            arguments.resize(argumentsDepth * count);
+            depth++;
+            break;
+        }
+
+        case OpCode::SumProduct:{
+            values.resize((depth + 1) * count);
+            for(size_t k = 0; k < count; k++){
+                if(!shiftPosition(ins.fromRow, ins.fromColumn, rowOffset + (int64_t)k, columnOffset, fromRow, fromColumn) ||
+                   !shiftPosition(ins.toRow, ins.toColumn, rowOffset + (int64_t)k, columnOffset, toRow, toColumn) ||
+                   !shiftPosition(ins.otherRow, ins.otherColumn, rowOffset + (int64_t)k, columnOffset, otherRow, otherColumn) ||
+                   otherRow + (toRow - fromRow) > CellRef::LAST_ROW ||
+                   otherColumn + (toColumn - fromColumn) >= CellRef::MAX_COLUMNS ||
+                   !table.sumProductRanges(fromRow, fromColumn, toRow, toColumn, otherRow, otherColumn,
+                                           values[depth * count + k])){
+                    return false;
+                }
+            }
+            depth++;
+            break;
+        }
+
+        default:
+            return false;
+        }
+    }
+
+    if(depth != 1 || argumentsDepth != 0){
+        return false;
+    }
+    std::copy(values.begin(), values.begin() + count, results);
+    return true;
+}
@@ -0,0 +1,229 @@
+#ifndef FORMULA_PROGRAM_H
+#define FORMULA_PROGRAM_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+class Table;
+
+/** FormulaProgram is a formula compiled into a short list of instructions (bytecode) for a stack machine.
+ *  A formula is parsed only once - \ref compile. Calculating it again after a referenced cell has changed only
+ *  runs the instructions - \ref evaluate. Instructions have a fixed size and no pointers, so programs can be
+ *  stored in files as they are - \ref BinaryWorkbook
+ *  \n Operations are calculated in the same order as \ref CellFormula always did it:
+ *  \li ^ first, then * and /, then + and -
+ *  \li + - and ^ from left to right, * and / from right to left (A0/B0*C0 is A0/(B0*C0))
+ *  \li a sign at the beginning of an expression (or of brackets, or of an argument) is applied to 0,
+ *  so -A0^2 is 0-(A0^2). A sign after another operation is not valid.
+ *  \li operands are numbers, references to cells (e.g. A0), expressions in brackets and calls of functions
+ *  (e.g. SUM(A0:B10, 2))
+ *  \li operations whose result does not depend on any cell are calculated once, while compiling - \ref appendOperation
+ *  \n Functions are SUM, AVERAGE, MIN, MAX, COUNT (ranges, references and expressions as arguments)
+ *  and SUMPRODUCT (exactly 2 ranges of the same size).
+ */
+class FormulaProgram{
+public:
+
+    /** Operation of one instruction
+     */
+    enum class OpCode : uint8_t{
+        Number,         /**< pushes \ref Instruction::number */
+        Cell,           /**< pushes the value of the cell (fromRow, fromColumn). Fails if it is a formula with error */
+        Add,            /**< pops 2 values and pushes the result */
+        Subtract,
+        Multiply,
+        Divide,         /**< fails if the divider is (almost) 0 */
+        Power,
+        Range,          /**< pushes the summary of the range as an argument of \ref Instruction::function */
+        Value,          /**< pops a value and pushes it as an argument of \ref Instruction::function */
+        Function,       /**< pops \ref Instruction::count arguments and pushes the result of \ref Instruction::function */
+        SumProduct      /**< pushes SUMPRODUCT of the range and the range of the same size starting from (otherRow, otherColumn) */
+    };
+
+    /** Why a formula has no value. Errors are results like any other: a formula referring to a cell with an error
+     *  gets the same error - \ref evaluate. Shown instead of the value - \ref errorText
+     */
+    enum class Error : uint8_t{
+        None,
+        Value,          /**< #VALUE - the formula is not valid (or has not been calculated yet) */
+        DivideByZero,   /**< #DIV/0 - division by (almost) 0, or AVERAGE of no numbers */
+        Reference,      /**< #REF - reference moved outside of the largest possible table */
+        Cycle           /**< #CYCLE - the formula refers to itself, directly or through other formulas */
+    };
+
+    /** Aggregate functions
+     */
+    enum class Function : uint8_t{
+        None,
+        Sum,
+        Average,
+        Min,
+        Max,
+        Count
+    };
+
+    /** One instruction. Its layout does not depend on the compiler (40 bytes, no implicit padding).
+     *  Ranges are stored with fromRow <= toRow and fromColumn <= toColumn.
+     */
+    struct Instruction{
+        OpCode code = OpCode::Number;
+        Function function = Function::None;
+        uint16_t reserved = 0;
+        uint32_t count = 0;
+        double number = 0;
+        uint32_t fromRow = 0;
+        uint32_t fromColumn = 0;
+        uint32_t toRow = 0;
+        uint32_t toColumn = 0;
+        uint32_t otherRow = 0;
+        uint32_t otherColumn = 0;
+    };
+
+private:
+
+    /** private constant representing an extremely low positive floating number. Used to indicate whether
+     *  a floating number is so close to zero, that it can be freely considered as a zero
+     */
+    static constexpr double zero_ = 0.0000001;
+
+    /** Instructions in the order of execution. Empty if the formula could not be compiled. */
+    std::vector<Instruction> code_;
+
+    /** Depth of the stacks of values and of arguments which fits into local arrays of \ref evaluate */
+    static constexpr size_t LOCAL_STACK = 16;
+
+    /** Most values and most arguments on the stacks at once while the program runs - \ref measureStacks */
+    size_t valuesDepth_ = 0;
+    size_t argumentsDepth_ = 0;
+
+    /** Checks whether a string is a range of cells, given as 2 references separated by ':' (e.g. A0:B10)
+     *
+     *  \param range receives the range if the string is a valid one
+     */
+    static bool isRange(std::string_view str, Instruction& range);
+
+    /** Finds an aggregate function by its name, in any case (e.g. "sum")
+     *
+     *  \return false if there's no such function
+     */
+    static bool findFunction(std::string_view name, Function& function);
+
+    /** Applies an arithmetic operation (Add, Subtract, Multiply, Divide or Power) to 2 numbers
+     *
+     *  \return false if the operation fails (division by 0)
+     */
+    static bool applyOperation(OpCode code, double left, double right, double& result);
+
+    /** Appends an arithmetic operation whose operands have just been compiled, the left one starting from
+     *  leftStart and the right one from rightStart. The operation is simplified if the result is the same for
+     *  every value of the operands (including infinities, NaN and the sign of 0):
+     *  \li operation of 2 numbers becomes its result, unless it fails
+     *  \li x*1, 1*x, x/1, x-0 and x^1 become x
+     *  \n x+0 is not simplified, because -0 + 0 is 0.
+     */
+    void appendOperation(OpCode code, size_t leftStart, size_t rightStart);
+
+    /** Compiles the arguments of SUMPRODUCT, starting from the given position (after the opening bracket),
+     *  and appends the call to the program
+     *
+     *  \return position after the closing bracket
+     *  \exception invalid_argument the arguments are not 2 ranges of the same size
+     */
+    size_t compileSumProduct(const std::string& expression, size_t pos);
+
+    /** Compiles a whitespace trimmed expression and appends it to the program. The expression is read once,
+     *  from left to right: operations waiting for their right operand and unclosed brackets are kept in
+     *  a stack on the heap, so the time is linear and nesting is not limited by the call stack.
+     *
+     *  \exception invalid_argument the expression is not valid
+     */
+    void compileExpression(const std::string& expression);
+
+    /** Finds how deep the stacks get while the program runs (\ref valuesDepth_, \ref argumentsDepth_), so that
+     *  \ref evaluate allocates nothing for them unless they are deeper than \ref LOCAL_STACK
+     */
+    void measureStacks();
+
+public:
+
+    /** Empty program, which always fails
+     */
+    FormulaProgram();
+
+    /** Program consisting of the given instructions - \ref code
+     */
+    explicit FormulaProgram(const std::vector<Instruction>& code);
+
+    /** Compiles a formula (text starting with '='). A formula which is not valid gives
+     *  an empty program, which always fails - \ref isValid
+     */
+    static FormulaProgram compile(const std::string& formula);
+
+    /** \return whether the formula was compiled successfully (the program is not empty)
+     */
+    bool isValid() const;
+
+    /** \return the instructions of the program
+     */
+    const std::vector<Instruction>& code() const;
+
+    /** Runs the program with the cells of the given table.
+     *  \li empty cells, cells outside of the table and strings are 0
+     *  \li formulas with errors make the program fail with the same error, except inside COUNT, which skips them.
+     *  A range holding several errors gives the first of them, column by column.
+     *  \n The same program serves every cell of a filled range: every reference is moved by the offsets
+     *  of the cell from the one the formula was written for - \ref shiftReferences
+     *
+     *  \param table table to take the referenced cells from
+     *  \param result receives the result, 0 if the program fails
+     *  \param rowOffset, columnOffset added to every referenced position
+     *  \return Error::None, or why the program fails (invalid formula, division by 0, error in a referenced cell,
+     *  reference moved before the first row or column...)
+     */
+    Error evaluate(const Table& table, double& result, int64_t rowOffset = 0, int64_t columnOffset = 0) const;
+
+    /** Runs the program for a run of cells of one column filled with the same formula, one instruction at a time
+     *  for all of them: cell k of the run is evaluated with the offsets rowOffset + k and columnOffset - \ref evaluate
+     *  \n Every instruction works on arrays with one value per cell, and the referenced cells are read column by column
+     *  (\ref Table::gatherNumericValues), so a long run costs far less than evaluating its cells one by one.
+     *  \n A run either succeeds as a whole or fails as a whole: if any of its cells would fail, nothing is
+     *  known about the others and they need to be evaluated one by one.
+     *
+     *  \param results receives the result of every cell of the run
+     *  \param count count of cells of the run
+     *  \return false if the program fails for any of the cells
+     */
+    bool evaluateRun(const Table& table, int64_t rowOffset, int64_t columnOffset, size_t count, double* results) const;
+
+    /** \return text shown instead of the value of a formula with the given error, e.g. "#DIV/0".
+     *  Empty for Error::None.
+     */
+    static const char* errorText(Error error);
+
+    /** Moves a position by the given offsets - \ref evaluate
+     *
+     *  \return false if the moved position is outside of the largest possible table - \ref CellRef
+     */
+    static bool shiftPosition(uint32_t row, uint32_t column, int64_t rowOffset, int64_t columnOffset,
+                              size_t& shiftedRow, size_t& shiftedColumn);
+
+    /** Moves every reference inside a formula by the given offsets, as when the formula is copied
+     *  to another cell (e.g. "=A1*B1" moved 1 row down is "=A2*B2"). Moved references which are
+     *  outside of the largest possible table become #REF, so the formula is not valid any more.
+     *
+     *  \return the formula with moved references
+     */
+    static std::string shiftReferences(const std::string& formula, int64_t rowOffset, int64_t columnOffset);
+
+    /** Same as \ref shiftReferences, but writes the formula into a string, which must not be the given formula.
+     *  The string's capacity is reused, so a buffer passed repeatedly is allocated only once.
+     */
+    static void shiftReferences(const std::string& formula, int64_t rowOffset, int64_t columnOffset, std::string& result);
+
+};
+
+
+#endif // FORMULA_PROGRAM_H
@@ -0,0 +1,65 @@
+#include <cstdio>
+
+#include "MemoryUsage.h"
+
+namespace{
+
+void appendLine(const char* name, uint64_t bytes, uint64_t total, std::string& result){
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-18s %14llu B %6.1f%%\n", name, (unsigned long long)bytes,
+                  total == 0 ? 0.0 : 100.0 * bytes / total);
+    result += line;
+}
+
+void appendCells(const char* name, const MemoryUsage::Cells& cells, uint64_t total, std::string& result){
+    char line[112];
+    std::snprintf(line, sizeof(line), "%-18s %14llu B %6.1f%%  %llu cells\n", name, (unsigned long long)cells.bytes,
+                  total == 0 ? 0.0 : 100.0 * cells.bytes / total, (unsigned long long)cells.count);
+    result += line;
+}
+
+}
+
+uint64_t MemoryUsage::total() const{
+    return ints.bytes + doubles.bytes + strings.bytes + formulas.bytes + stringPayloads + formulaText +
+           formulaPrograms + grid + dependencies + caches;
+}
+
+uint64_t MemoryUsage::heapBytes(const std::string& str){
+    // short strings are kept inside of the object (small string optimization)
+    const char* data = str.data();
+    if(data >= (const char*)&str && data < (const char*)(&str + 1)){
+        return 0;
+    }
+    return str.capacity() + 1;
+}
+
+std::string MemoryUsage::report(uint64_t sourceBytes) const{
+    uint64_t sum = total();
+    std::string result;
+    appendCells("integers", ints, sum, result);
+    appendCells("floating numbers", doubles, sum, result);
+    appendCells("strings", strings, sum, result);
+    appendCells("formulas", formulas, sum, result);
+    appendLine("string payloads", stringPayloads, sum, result);
+    appendLine("formula text", formulaText, sum, result);
+    appendLine("formula programs", formulaPrograms, sum, result);
+    appendLine("grid", grid, sum, result);
+    appendLine("dependencies", dependencies, sum, result);
+    appendLine("caches", caches, sum, result);
+    appendLine("total", sum, sum, result);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "allocated blocks: %llu (about %llu B more used by the allocator)\n",
+                  (unsigned long long)blocks, (unsigned long long)(blocks * BLOCK_OVERHEAD));
+    result += line;
+    if(sourceBytes == 0){
+        result += "csv size: 0 B";
+    }else{
+        std::snprintf(line, sizeof(line), "csv size: %llu B, memory is %.2fx the csv size (%.2fx with the allocator)",
+                      (unsigned long long)sourceBytes, (double)sum / sourceBytes,
+                      (double)(sum + blocks * BLOCK_OVERHEAD) / sourceBytes);
+        result += line;
+    }
+    return result;
+}
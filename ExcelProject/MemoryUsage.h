@@ -0,0 +1,70 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+/** MemoryUsage tells how much memory a table takes and what for - \ref Table::memoryUsage
+ *  \n Every part is counted in bytes the way the table holds it: the objects themselves, the arrays and
+ *  strings they own (by capacity, not by size) and the nodes of the maps the table keeps. The overhead of
+ *  the allocator is not included, it is estimated from the count of allocated blocks - \ref report
+ *  \n Memory shared by several formulas (\ref CellFormula::Template) is counted once, with the first of them -
+ *  \ref counted
+ */
+struct MemoryUsage{
+
+    /** Cells of one type: objects extending \ref Cell or slots of the typed arrays of the columns
+     */
+    struct Cells{
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    Cells ints;
+    Cells doubles;
+    Cells strings;
+    Cells formulas;
+
+    uint64_t stringPayloads = 0;    /**< text of strings which does not fit inside of the string objects */
+    uint64_t formulaText = 0;       /**< text of the formulas, as they were written */
+    uint64_t formulaPrograms = 0;   /**< compiled formulas (\ref FormulaProgram) and their templates */
+    uint64_t grid = 0;              /**< columns, their arrays of pointers to cells and their bitmaps */
+    uint64_t dependencies = 0;      /**< which formulas refer to which cells */
+    uint64_t caches = 0;            /**< summaries of ranges, cells to calculate, cells created on demand */
+    uint64_t blocks = 0;            /**< count of allocated blocks of memory */
+
+    /** Shared objects which are already counted */
+    std::unordered_set<const void*> counted;
+
+    /** \return sum of every part in bytes
+     */
+    uint64_t total() const;
+
+    /** \return bytes a string has allocated for its text, 0 if the text fits inside of the object itself
+     */
+    static uint64_t heapBytes(const std::string& str);
+
+    /** Bytes an element of a hash map (unordered_map or unordered_set) takes besides its own value
+     */
+    static constexpr uint64_t HASH_NODE = sizeof(void*);
+
+    /** Bytes an element of an ordered map (map or set) takes besides its own value
+     */
+    static constexpr uint64_t TREE_NODE = 4 * sizeof(void*);
+
+    /** Estimated bytes the allocator uses for every allocated block (its header, glibc malloc)
+     */
+    static constexpr uint64_t BLOCK_OVERHEAD = 8;
+
+    /** \param sourceBytes size of the table written as a csv file, 0 if unknown
+     *  \return every part with its share of the total, the estimated overhead of the allocator and how many
+     *  times more memory than the csv file the table takes, as displayable text
+     */
+    std::string report(uint64_t sourceBytes) const;
+
+};
+
+
+#endif // MEMORY_USAGE_H
@@ -0,0 +1,149 @@
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "ResultSidecar.h"
+#include "Column.h"
+#include "CellFormula.h"
+
+namespace{
+
+const char MAGIC[8] = {'X', 'T', 'R', 'S', '\r', '\n', 0x1A, 0};
+const uint32_t VERSION = 2;
+
+struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fingerprint;       /**< of the CSV file */
+    uint64_t count;             /**< ResultRecord[count] */
+};
+
+struct ResultRecord{
+    uint32_t row;
+    uint32_t column;
+    uint64_t formula;           /**< fingerprint of the text of the formula */
+    double result;
+    uint64_t error;             /**< FormulaProgram::Error */
+};
+
+uint64_t formulaFingerprint(std::string_view formula){
+    ResultSidecar::Fingerprint fingerprint;
+    fingerprint.addLine(formula);
+    return fingerprint.value();
+}
+
+}
+
+ResultSidecar::Fingerprint::Fingerprint(){
+    value_ = 0xcbf29ce484222325ULL;
+}
+
+void ResultSidecar::Fingerprint::addLine(std::string_view line){
+    if(line.empty()){
+        return;
+    }
+    uint64_t value = value_;
+    for(size_t i = 0; i < line.size(); i++){
+        value = (value ^ (unsigned char)line[i]) * 0x100000001b3ULL;
+    }
+    value_ = (value ^ '\n') * 0x100000001b3ULL;
+}
+
+uint64_t ResultSidecar::Fingerprint::value() const{
+    return value_;
+}
+
+std::string ResultSidecar::pathFor(const std::string& filename){
+    return filename + EXTENSION;
+}
+
+void ResultSidecar::save(const Table& table, const std::string& filename, uint64_t fingerprint){
+    // a dirty formula has no result to remember yet
+    table.calculateDirtyFormulas();
+    std::vector<ResultRecord> records;
+    std::string buffer;
+    for(size_t col = 0; col < table.columnsCount(); col++){
+        const Column& column = table.columnAt(col);
+        const std::vector<uint64_t>& cells = column.cellBits();
+        for(size_t word = 0; word < cells.size(); word++){
+            for(uint64_t bits = cells[word]; bits != 0; bits &= bits - 1){
+                size_t row = word * 64 + __builtin_ctzll(bits);
+                const CellFormula* cf = dynamic_cast<const CellFormula*>(column.getStoredCell(row));
+                if(cf == nullptr){
+                    continue;
+                }
+                ResultRecord record;
+                memset(&record, 0, sizeof(record));
+                record.row = row;
+                record.column = col;
+                record.formula = formulaFingerprint(cf->getConstructView(buffer));
+                record.result = cf->getValue();
+                record.error = (uint64_t)cf->errorCode();
+                records.push_back(record);
+            }
+        }
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.fingerprint = fingerprint;
+    header.count = records.size();
+
+    std::ofstream writeFile(pathFor(filename), std::ios::binary | std::ios::trunc);
+    writeFile.write((const char*)&header, sizeof(header));
+    writeFile.write((const char*)records.data(), records.size() * sizeof(ResultRecord));
+    writeFile.close();
+    if(writeFile.fail()){
+        throw std::invalid_argument("Unexpected error while writing the results of the formulas. ");
+    }
+}
+
+bool ResultSidecar::load(const std::string& filename, uint64_t fingerprint, Table& table){
+    std::ifstream readFile(pathFor(filename), std::ios::binary);
+    if(!readFile.is_open()){
+        return false;
+    }
+
+    FileHeader header;
+    if(!readFile.read((char*)&header, sizeof(header))){
+        return false;
+    }
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+       header.fingerprint != fingerprint || header.count != table.formulasCount()){
+        return false;
+    }
+
+    std::vector<ResultRecord> records(header.count);
+    if(!readFile.read((char*)records.data(), records.size() * sizeof(ResultRecord))){
+        return false;
+    }
+
+    // every result must belong to the same formula it was calculated for, before any of them is used.
+    // Results are written column by column, so a repeated position would break the order
+    std::string buffer;
+    for(size_t i = 0; i < records.size(); i++){
+        if(i > 0 && (records[i].column < records[i - 1].column ||
+                     (records[i].column == records[i - 1].column && records[i].row <= records[i - 1].row))){
+            return false;
+        }
+        const CellFormula* cf = dynamic_cast<const CellFormula*>(table.getCellPointer(records[i].row, records[i].column));
+        if(cf == nullptr || formulaFingerprint(cf->getConstructView(buffer)) != records[i].formula ||
+           records[i].error > (uint64_t)FormulaProgram::Error::Cycle){
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < records.size(); i++){
+        table.restoreFormulaResult(records[i].row, records[i].column, records[i].result,
+                                   (FormulaProgram::Error)records[i].error);
+    }
+    return true;
+}
+
+void ResultSidecar::remove(const std::string& filename){
+    std::remove(pathFor(filename).c_str());
+}
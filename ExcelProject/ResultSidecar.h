@@ -0,0 +1,76 @@
+#ifndef RESULT_SIDECAR_H
+#define RESULT_SIDECAR_H
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Table.h"
+
+/** ResultSidecar remembers the calculated results of the formulas of a table saved as CSV, in a separate
+ *  file next to it (the name of the CSV file followed by \ref EXTENSION).
+ *  \n A CSV file holds only the formulas, so every one of them would have to be calculated again when the
+ *  file is opened. Instead, the results are read from the sidecar file - \ref load. They are trusted only if
+ *  the sidecar file was written for exactly the same content of the CSV file, which is checked by
+ *  comparing the fingerprints of both contents - \ref Fingerprint. Otherwise (the CSV file was changed by
+ *  another program, the sidecar file is missing or damaged...) the formulas are calculated as usual.
+ *  \n Files in the native format keep the results inside - \ref BinaryWorkbook
+ */
+class ResultSidecar{
+public:
+
+    /** Appended to the name of the CSV file
+     */
+    static constexpr const char* EXTENSION = ".results";
+
+    /** Fingerprint of the content of a CSV file, given line by line (without the line breaks).
+     *  Empty lines are skipped, as they are skipped when the file is read.
+     *  \n 64-bit FNV-1a hash: not meant to protect against intentional changes, only to notice ordinary ones.
+     */
+    class Fingerprint{
+    private:
+        uint64_t value_;
+
+    public:
+        Fingerprint();
+
+        /** Adds the next line of the file
+         */
+        void addLine(std::string_view line);
+
+        /** \return the fingerprint of every line added so far
+         */
+        uint64_t value() const;
+    };
+
+    /** \return name of the sidecar file of a CSV file
+     */
+    static std::string pathFor(const std::string& filename);
+
+    /** Writes the result of every formula of the table into the sidecar file of a CSV file.
+     *  The file is replaced if it exists.
+     *
+     *  \param fingerprint fingerprint of the content just written to the CSV file
+     *  \exception invalid_argument the file cannot be written
+     */
+    static void save(const Table& table, const std::string& filename, uint64_t fingerprint);
+
+    /** Reads the sidecar file of a CSV file and gives every formula of the table its remembered result -
+     *  \ref Table::restoreFormulaResult. Nothing is changed unless the file exists, was written for the
+     *  same fingerprint, and holds a result for exactly every formula of the table.
+     *
+     *  \param fingerprint fingerprint of the content just read from the CSV file
+     *  \return whether the results were restored
+     */
+    static bool load(const std::string& filename, uint64_t fingerprint, Table& table);
+
+    /** Deletes the sidecar file of a CSV file, if there's such, e.g. when the CSV file
+     *  is written in a way that the results cannot be matched to
+     */
+    static void remove(const std::string& filename);
+
+};
+
+
+#endif // RESULT_SIDECAR_H
@@ -0,0 +1,65 @@
+#include "ScriptRunner.h"
+
+ScriptRunner::ScriptRunner(ControlCenter& controlCenter, const Options& options)
+    : controlCenter_(controlCenter), options_(options){
+}
+
+bool ScriptRunner::runLine(const std::string& line, size_t number, std::ostream& output, std::ostream& errors,
+                           bool& exit){
+    size_t first = line.find_first_not_of(" \t\r");
+    if(first == std::string::npos || line[first] == '#'){
+        return true;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    std::string command = line.substr(first, last - first + 1);
+    std::string upper = command;
+    for(char& c : upper){
+        if('a' <= c && c <= 'z'){
+            c = c + 'A' - 'a';
+        }
+    }
+    if(upper == "EXIT"){
+        exit = true;
+        return true;
+    }
+
+    try{
+        std::string result = controlCenter_.executeCommand(command);
+        if(!options_.quiet){
+            output << "OK: " << result << '\n';
+        }
+        return true;
+    }catch(std::invalid_argument& e){
+        errors << "FAIL (line " << number << ": " << command << "): " << e.what() << '\n';
+        return false;
+    }
+}
+
+size_t ScriptRunner::run(std::istream& script, std::ostream& output, std::ostream& errors){
+    size_t failed = 0;
+    bool exit = false;
+    std::string line;
+    for(size_t number = 1; !exit && std::getline(script, line); number++){
+        if(!runLine(line, number, output, errors, exit)){
+            failed++;
+            if(!options_.keepGoing){
+                break;
+            }
+        }
+    }
+    return failed;
+}
+
+size_t ScriptRunner::run(const std::vector<std::string>& commands, std::ostream& output, std::ostream& errors){
+    size_t failed = 0;
+    bool exit = false;
+    for(size_t i = 0; !exit && i < commands.size(); i++){
+        if(!runLine(commands[i], i + 1, output, errors, exit)){
+            failed++;
+            if(!options_.keepGoing){
+                break;
+            }
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,65 @@
+#ifndef SCRIPT_RUNNER_H
+#define SCRIPT_RUNNER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ControlCenter.h"
+
+/** ScriptRunner executes commands of \ref ControlCenter one after another with nobody to answer questions,
+ *  e.g. to process many files by a scheduled job:
+ *  \code
+ *  ExcelProject --overwrite always --script nightly.txt
+ *  ExcelProject -c "OPEN in.csv" -c "SAVEAS out.xtb"
+ *  \endcode
+ *  \li a script has one command per line. Empty lines and lines starting with # are skipped, EXIT ends it
+ *  \li the result of every command is written as "OK: ..." (as in the interactive mode), unless
+ *  they are not wanted - \ref Options::quiet
+ *  \li a failed command is written as "FAIL (line N: command): reason" and stops the script, unless
+ *  the script is wanted to continue - \ref Options::keepGoing
+ *  \n The control center should not ask the user anything - \ref ControlCenter::setOverwrite
+ */
+class ScriptRunner{
+public:
+
+    struct Options{
+        bool keepGoing = false;     /**< continue after a failed command */
+        bool quiet = false;         /**< write only the failures */
+    };
+
+private:
+
+    ControlCenter& controlCenter_;
+    Options options_;
+
+    /** Executes one line of a script
+     *
+     *  \return false if the line failed
+     */
+    bool runLine(const std::string& line, size_t number, std::ostream& output, std::ostream& errors, bool& exit);
+
+public:
+
+    /** \param controlCenter executes the commands, keeps the opened file between runs
+     */
+    ScriptRunner(ControlCenter& controlCenter, const Options& options);
+
+    /** Executes every line of a script
+     *
+     *  \param output receives the results of the commands
+     *  \param errors receives the failures
+     *  \return count of failed commands
+     */
+    size_t run(std::istream& script, std::ostream& output, std::ostream& errors);
+
+    /** Executes commands given one by one, e.g. as arguments of the program. They are numbered as lines from 1.
+     *
+     *  \return count of failed commands
+     */
+    size_t run(const std::vector<std::string>& commands, std::ostream& output, std::ostream& errors);
+
+};
+
+
+#endif // SCRIPT_RUNNER_H
@@ -0,0 +1,355 @@
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SERVER_SOCKETS
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "Server.h"
+#include "ThreadPool.h"
+
+namespace{
+
+    std::string trim(const std::string& str){
+        size_t first = str.find_first_not_of(" \t\r");
+        if(first == std::string::npos){
+            return "";
+        }
+        size_t last = str.find_last_not_of(" \t\r");
+        return str.substr(first, last - first + 1);
+    }
+
+    std::string toUpper(std::string str){
+        for(char& c : str){
+            if('a' <= c && c <= 'z'){
+                c = c + 'A' - 'a';
+            }
+        }
+        return str;
+    }
+
+#ifdef SERVER_SOCKETS
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+    /** One connection with the commands received from it and not yet executed
+     */
+    struct Connection{
+        int fd;
+        Server::Session session;
+        std::string received;           /**< start of a line not received entirely */
+        std::mutex mutex;
+        std::deque<std::string> lines;  /**< guarded by mutex, like the two flags */
+        bool running = false;           /**< a task of the pool is executing the lines */
+        bool quit = false;
+
+        Connection(int fd, const Server::Session& session) : fd(fd), session(session){
+        }
+
+        ~Connection(){
+            close(fd);
+        }
+
+        /** \return false if the other side cannot receive anymore
+         */
+        bool send(const std::string& data){
+            size_t sent = 0;
+            while(sent < data.size()){
+                ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if(n < 0 && errno == EINTR){
+                    continue;
+                }
+                if(n <= 0){
+                    return false;
+                }
+                sent += n;
+            }
+            return true;
+        }
+    };
+#endif
+
+}
+
+Server::Server(const Options& options) : options_(options), stopping_(false){
+#ifdef SERVER_SOCKETS
+    int wake[2];
+    if(pipe(wake) != 0){
+        throw std::invalid_argument("Server cannot be created: " + std::string(std::strerror(errno)) + ". ");
+    }
+    wakeRead_ = wake[0];
+    wakeWrite_ = wake[1];
+    fcntl(wakeRead_, F_SETFL, O_NONBLOCK);
+    fcntl(wakeWrite_, F_SETFL, O_NONBLOCK);
+#endif
+}
+
+Server::~Server(){
+#ifdef SERVER_SOCKETS
+    close(wakeRead_);
+    close(wakeWrite_);
+#endif
+}
+
+std::shared_ptr<Server::Workbook> Server::createWorkbook() const{
+    std::shared_ptr<Workbook> workbook = std::make_shared<Workbook>();
+    workbook->controlCenter.setOverwrite(options_.overwrite);
+    workbook->loaded = true;
+    publishSnapshot(*workbook);
+    return workbook;
+}
+
+void Server::publishSnapshot(Workbook& workbook){
+    std::shared_ptr<const Table> snapshot = workbook.controlCenter.snapshot();
+    std::lock_guard<std::mutex> lock(workbook.snapshotMutex);
+    // the old copy is released by the last command reading it
+    workbook.snapshot.swap(snapshot);
+}
+
+Server::Session Server::createSession() const{
+    Session session;
+    session.workbook = createWorkbook();
+    return session;
+}
+
+std::shared_ptr<Server::Workbook> Server::openWorkbook(const std::string& path){
+    std::shared_ptr<Workbook> workbook;
+    bool load = false;
+    {
+        std::lock_guard<std::mutex> lock(workbooksMutex_);
+        std::shared_ptr<Workbook>& resident = workbooks_[path];
+        if(resident == nullptr){
+            resident = std::make_shared<Workbook>();
+            resident->controlCenter.setOverwrite(options_.overwrite);
+            load = true;
+        }
+        workbook = resident;
+    }
+
+    if(load){
+        // sessions opening the same file meanwhile wait for the lock
+        std::unique_lock<std::shared_mutex> lock(workbook->mutex);
+        try{
+            workbook->controlCenter.executeCommand("OPEN \"" + path + "\"");
+            workbook->loaded = true;
+            publishSnapshot(*workbook);
+        }catch(std::invalid_argument&){
+            std::lock_guard<std::mutex> registryLock(workbooksMutex_);
+            workbooks_.erase(path);
+            throw;
+        }
+    }else{
+        std::shared_lock<std::shared_mutex> lock(workbook->mutex);
+        if(!workbook->loaded){
+            throw std::invalid_argument("File " + path + " could not be opened. ");
+        }
+    }
+    return workbook;
+}
+
+bool Server::execute(Session& session, const std::string& line, std::string& response, bool& quit){
+    std::string command = trim(line);
+    size_t nameEnd = command.find_first_of(" \t");
+    std::string name = toUpper(command.substr(0, nameEnd));
+    std::string arguments = nameEnd == std::string::npos ? "" : trim(command.substr(nameEnd));
+
+    response.clear();
+    try{
+        if(name == "QUIT"){
+            quit = true;
+            return true;
+        }else if(name == "OPEN"){
+            if(arguments.size() >= 2 && arguments.front() == '"' && arguments.back() == '"'){
+                arguments = arguments.substr(1, arguments.size() - 2);
+            }
+            if(arguments.empty()){
+                throw std::invalid_argument("Invalid use of command: open <file path>");
+            }
+            session.workbook = openWorkbook(arguments);
+            response = "Opened " + arguments;
+            return true;
+        }else if(name == "CLOSE"){
+            session.workbook = createWorkbook();
+            return true;
+        }else if(name == "NEW"){
+            // NEW of the control center would replace the workbook of every session sharing it
+            session.workbook = createWorkbook();
+        }
+
+        Workbook& workbook = *session.workbook;
+        std::shared_ptr<const Table> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(workbook.snapshotMutex);
+            snapshot = workbook.snapshot;
+        }
+        if(workbook.controlCenter.executeReadOnly(*snapshot, command, response)){
+            return true;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(workbook.mutex);
+        try{
+            response = workbook.controlCenter.executeCommand(command);
+        }catch(std::invalid_argument&){
+            // a failed command may have changed the table before failing
+            publishSnapshot(workbook);
+            throw;
+        }
+        publishSnapshot(workbook);
+        return true;
+    }catch(std::invalid_argument& e){
+        response = e.what();
+        return false;
+    }
+}
+
+void Server::run(){
+#ifdef SERVER_SOCKETS
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(options_.socketPath.empty() || options_.socketPath.size() >= sizeof(address.sun_path)){
+        throw std::invalid_argument("Invalid socket path: " + options_.socketPath + ". ");
+    }
+    std::memcpy(address.sun_path, options_.socketPath.c_str(), options_.socketPath.size());
+
+    struct stat info;
+    if(stat(options_.socketPath.c_str(), &info) == 0){
+        if(!S_ISSOCK(info.st_mode)){
+            throw std::invalid_argument("File " + options_.socketPath + " exists and is not a socket. ");
+        }
+        unlink(options_.socketPath.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0){
+        std::string reason = std::strerror(errno);
+        if(listener >= 0){
+            close(listener);
+        }
+        throw std::invalid_argument("Socket " + options_.socketPath + " cannot be created: " + reason + ". ");
+    }
+
+    std::map<int, std::shared_ptr<Connection>> connections;
+    {
+        // destroyed before the connections, after finishing the received commands
+        ThreadPool pool(options_.threads);
+
+        auto serve = [this](std::shared_ptr<Connection> connection){
+            while(true){
+                std::string line;
+                {
+                    std::lock_guard<std::mutex> lock(connection->mutex);
+                    if(connection->lines.empty() || connection->quit){
+                        connection->running = false;
+                        return;
+                    }
+                    line = std::move(connection->lines.front());
+                    connection->lines.pop_front();
+                }
+                std::string response;
+                bool quit = false;
+                bool ok = execute(connection->session, line, response, quit);
+                std::string frame = (ok ? "OK " : "FAIL ") + std::to_string(response.size()) + "\n";
+                frame += response;
+                frame += '\n';
+                if(!connection->send(frame)){
+                    quit = true;
+                }
+                if(quit){
+                    std::lock_guard<std::mutex> lock(connection->mutex);
+                    connection->quit = true;
+                    // the thread waiting for connections sees the end and forgets it
+                    shutdown(connection->fd, SHUT_RDWR);
+                }
+            }
+        };
+
+        std::vector<pollfd> descriptors;
+        std::vector<char> buffer(1 << 16);
+        while(!stopping_){
+            descriptors.clear();
+            descriptors.push_back({wakeRead_, POLLIN, 0});
+            descriptors.push_back({listener, POLLIN, 0});
+            for(const auto& connection : connections){
+                descriptors.push_back({connection.first, POLLIN, 0});
+            }
+            if(poll(descriptors.data(), descriptors.size(), -1) < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                break;
+            }
+
+            if(descriptors[0].revents != 0){
+                while(read(wakeRead_, buffer.data(), buffer.size()) > 0){
+                }
+            }
+            if(descriptors[1].revents & POLLIN){
+                int fd = accept(listener, nullptr, nullptr);
+                if(fd >= 0){
+                    connections[fd] = std::make_shared<Connection>(fd, createSession());
+                }
+            }
+            for(size_t i = 2; i < descriptors.size(); i++){
+                if(descriptors[i].revents == 0){
+                    continue;
+                }
+                std::shared_ptr<Connection> connection = connections[descriptors[i].fd];
+                ssize_t n = recv(connection->fd, buffer.data(), buffer.size(), 0);
+                if(n < 0 && errno == EINTR){
+                    continue;
+                }
+                std::vector<std::string> lines;
+                if(n > 0){
+                    connection->received.append(buffer.data(), n);
+                    size_t start = 0;
+                    size_t end;
+                    while((end = connection->received.find('\n', start)) != std::string::npos){
+                        lines.push_back(connection->received.substr(start, end - start));
+                        start = end + 1;
+                    }
+                    connection->received.erase(0, start);
+                }else{
+                    // the other side sends nothing more, the received commands are still answered
+                    lines.push_back(connection->received);
+                    connections.erase(connection->fd);
+                }
+
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                for(std::string& line : lines){
+                    if(!trim(line).empty()){
+                        connection->lines.push_back(std::move(line));
+                    }
+                }
+                if(!connection->lines.empty() && !connection->running && !connection->quit){
+                    connection->running = true;
+                    pool.submit([serve, connection](){ serve(connection); });
+                }
+            }
+        }
+    }
+
+    close(listener);
+    unlink(options_.socketPath.c_str());
+#else
+    throw std::invalid_argument("Server mode needs Unix domain sockets, which this system does not have. ");
+#endif
+}
+
+void Server::stop(){
+    stopping_ = true;
+#ifdef SERVER_SOCKETS
+    // write is allowed in signal handlers, unlike notifying a condition variable
+    ssize_t written = write(wakeWrite_, "", 1);
+    (void)written;
+#endif
+}
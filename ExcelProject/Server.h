@@ -0,0 +1,131 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <iostream>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "ControlCenter.h"
+
+/** Server keeps workbooks loaded and executes commands of \ref ControlCenter sent by other programs over
+ *  a Unix domain socket, so that a workbook is read and calculated once for many requests - \ref run
+ *  \n Every connection is a session. A session sends commands, one per line, and gets a response to every one
+ *  of them, in the same order:
+ *  \code
+ *  OK <length>\n<length bytes of the result>\n
+ *  FAIL <length>\n<length bytes of the reason>\n
+ *  \endcode
+ *  Empty lines get no response. Commands of a session are executed one after another, commands of different
+ *  sessions by a pool of threads (\ref ThreadPool) at the same time.
+ *  \n Some commands are executed by the server itself:
+ *  \li OPEN path - the session works with the workbook from now on. A workbook is loaded by the first session
+ *  which opens it and stays loaded for every other session until the server stops.
+ *  \li CLOSE - the session works with an empty workbook of its own again
+ *  \li NEW path - same as CLOSE followed by NEW of the control center
+ *  \li QUIT - ends the session
+ *  \n Sessions working with the same workbook share it. Commands which only read it (PRINT, GET...) read a copy
+ *  of the table taken after the last command which changed it (\ref ControlCenter::snapshot), so they never wait,
+ *  not even for a command changing the workbook - \ref ControlCenter::executeReadOnly. Taking the copy calculates
+ *  nothing, so the formulas of a lazy workbook are still calculated only when they are read. Any other command waits
+ *  until no other such command is executed on the workbook.
+ *  \n No command asks anything - \ref Options::overwrite
+ */
+class Server{
+public:
+
+    struct Options{
+        std::string socketPath;
+        size_t threads = 4;
+        ControlCenter::Overwrite overwrite = ControlCenter::Overwrite::Never;
+    };
+
+    /** A workbook with the lock of the sessions working with it
+     */
+    struct Workbook{
+        std::shared_mutex mutex;
+        ControlCenter controlCenter;
+        bool loaded = false;        /**< whether opening the file has finished successfully */
+
+        /** Copy of the table read by the commands which do not change it, replaced after every other command.
+         *  Guarded by snapshotMutex, which is only held to take or replace the pointer.
+         */
+        std::shared_ptr<const Table> snapshot;
+        std::mutex snapshotMutex;
+    };
+
+    /** State of one session
+     */
+    struct Session{
+        std::shared_ptr<Workbook> workbook;
+    };
+
+private:
+
+    Options options_;
+
+    /** Loaded workbooks by their paths */
+    std::map<std::string, std::shared_ptr<Workbook>> workbooks_;
+    std::mutex workbooksMutex_;
+
+    std::atomic<bool> stopping_;
+
+    /** Pipe which wakes the thread waiting for connections - \ref stop */
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+
+    /** \return a new empty workbook, not shared with other sessions
+     */
+    std::shared_ptr<Workbook> createWorkbook() const;
+
+    /** Replaces the copy of the table of a workbook, while the workbook is locked by the calling thread
+     */
+    static void publishSnapshot(Workbook& workbook);
+
+    /** \return the loaded workbook of the file, loaded now if it is not yet
+     *  \exception invalid_argument the file cannot be opened - \ref ControlCenter::executeCommand
+     */
+    std::shared_ptr<Workbook> openWorkbook(const std::string& path);
+
+public:
+
+    /** \exception invalid_argument the server cannot be created on this system
+     */
+    explicit Server(const Options& options);
+
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /** Prepares a new session, working with an empty workbook of its own
+     */
+    Session createSession() const;
+
+    /** Executes one command of a session, as if it was received over the socket
+     *
+     *  \param response receives the result or the reason of the failure
+     *  \param quit set to true if the session should end
+     *  \return whether the command succeeded
+     */
+    bool execute(Session& session, const std::string& line, std::string& response, bool& quit);
+
+    /** Accepts connections and executes their commands until \ref stop is called. The socket file is created
+     *  (replacing a socket left by a server which did not stop properly) and removed at the end.
+     *  Commands which were received before stopping are finished.
+     *
+     *  \exception invalid_argument the socket cannot be created
+     */
+    void run();
+
+    /** Makes \ref run return. Can be called by any thread, and by a signal handler.
+     */
+    void stop();
+
+};
+
+
+#endif // SERVER_H
@@ -0,0 +1,207 @@
+#include <fstream>
+#include <vector>
+#include "SheetGenerator.h"
+#include "CellRef.h"
+
+SheetGenerator::SheetGenerator(const Options& options)
+    :options_(options)
+{
+    if(options.rows == 0 || options.columns == 0){
+        throw std::invalid_argument("The table needs at least 1 row and 1 column.");
+    }
+    if(options.rows > CellRef::LAST_ROW + 1 || options.columns > CellRef::MAX_COLUMNS){
+        throw std::invalid_argument("The table is larger than the largest possible one.");
+    }
+    if(options.integers < 0 || options.doubles < 0 || options.strings < 0 || options.formulas < 0 || options.empty < 0){
+        throw std::invalid_argument("Shares cannot be negative.");
+    }
+    if(options.integers + options.doubles + options.strings + options.formulas + options.empty <= 0){
+        throw std::invalid_argument("At least 1 share must be positive.");
+    }
+    if(options.distinctStrings == 0 || options.references == 0 || options.rangeRows == 0 || options.chainDepth == 0){
+        throw std::invalid_argument("Count of strings, references, rows of ranges and chain depth must be positive.");
+    }
+    if(!(options.ranges >= 0 && options.ranges <= 1) || !(options.sharedReferences >= 0 && options.sharedReferences <= 1)){
+        throw std::invalid_argument("Parts of formulas and references must be between 0 and 1.");
+    }
+}
+
+const SheetGenerator::Options& SheetGenerator::options() const{
+    return options_;
+}
+
+uint64_t SheetGenerator::random(size_t row, size_t column, uint64_t purpose) const{
+    // splitmix64 of the seed mixed with the position - every cell on its own, in any order
+    uint64_t x = options_.seed ^ ((uint64_t)row * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)column << 40) ^ (purpose << 56);
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+SheetGenerator::Kind SheetGenerator::kind(size_t row, size_t column) const{
+    const Options& o = options_;
+    double total = o.integers + o.doubles + o.strings + o.formulas;
+    // the first column is never empty, so that no line of a CSV file is empty
+    if(column != 0){
+        total += o.empty;
+    }
+    if(total <= 0){
+        return Kind::Integer;
+    }
+    double choice = (random(row, column, 0) >> 11) * (1.0 / 9007199254740992.0) * total;
+    if(choice < o.integers){
+        return Kind::Integer;
+    }
+    if((choice -= o.integers) < o.doubles){
+        return Kind::Double;
+    }
+    if((choice -= o.doubles) < o.strings){
+        return Kind::String;
+    }
+    if((choice -= o.strings) < o.formulas){
+        return Kind::Formula;
+    }
+    return Kind::Empty;
+}
+
+void SheetGenerator::appendOperand(size_t row, size_t column, uint64_t purpose, std::string& value) const{
+    uint64_t r = random(row, column, purpose);
+    const Options& o = options_;
+    if(o.sharedCells > 0 && (r >> 11) * (1.0 / 9007199254740992.0) < o.sharedReferences){
+        CellRef::appendColumnName((r >> 32) % std::min(o.sharedCells, o.columns), value);
+        value += '0';
+        return;
+    }
+    // a few tries to find a cell which is not a formula, so that chains do not get longer
+    for(size_t attempt = 0; attempt < 4; attempt++, r = random(row, column, purpose + 16 * (attempt + 1))){
+        size_t distance = 1 + r % 8;
+        size_t sourceRow = row >= distance ? row - distance : 0;
+        size_t sourceColumn = (r >> 8) % o.columns;
+        if(kind(sourceRow, sourceColumn) != Kind::Formula){
+            CellRef::appendColumnName(sourceColumn, value);
+            value += std::to_string(sourceRow);
+            return;
+        }
+    }
+    value += std::to_string(1 + r % 9);
+}
+
+void SheetGenerator::appendFormula(size_t row, size_t column, std::string& value) const{
+    const Options& o = options_;
+    value += '=';
+    if(row == 0){
+        // nothing above to refer to
+        value += std::to_string(random(row, column, 2) % 100);
+        value += "*2";
+        return;
+    }
+
+    if((random(row, column, 3) >> 11) * (1.0 / 9007199254740992.0) < o.ranges){
+        // a part of one column above
+        const char* functions[] = {"SUM(", "MAX(", "AVERAGE(", "MIN(", "COUNT("};
+        uint64_t r = random(row, column, 4);
+        value += functions[(r >> 40) % 5];
+        size_t height = 1 + r % o.rangeRows;
+        size_t sourceColumn = (r >> 8) % o.columns;
+        CellRef::appendColumnName(sourceColumn, value);
+        value += std::to_string(row >= height ? row - height : 0);
+        value += ':';
+        CellRef::appendColumnName(sourceColumn, value);
+        value += std::to_string(row - 1);
+        value += ')';
+        return;
+    }
+
+    const char operations[] = {'+', '-', '*'};
+    for(size_t i = 0; i < o.references; i++){
+        if(i > 0){
+            value += operations[random(row, column, 5 + 2 * i) % 3];
+        }
+        if(i == 0 && row % o.chainDepth != 0 && kind(row - 1, column) == Kind::Formula){
+            // the chain goes on from the formula right above
+            CellRef::appendColumnName(column, value);
+            value += std::to_string(row - 1);
+        }else{
+            appendOperand(row, column, 6 + 2 * i, value);
+        }
+    }
+}
+
+void SheetGenerator::cellValue(size_t row, size_t column, std::string& value) const{
+    value.clear();
+    uint64_t r = random(row, column, 1);
+    switch(kind(row, column)){
+    case Kind::Integer:
+        value += std::to_string((int64_t)(r % 1000000) - 1000);
+        break;
+    case Kind::Double:{
+        int64_t hundredths = (int64_t)(r % 10000000) - 100000;
+        if(hundredths < 0){
+            value += '-';
+            hundredths = -hundredths;
+        }
+        value += std::to_string(hundredths / 100);
+        value += '.';
+        value += (char)('0' + hundredths / 10 % 10);
+        value += (char)('0' + hundredths % 10);
+        break;
+    }
+    case Kind::String:
+        value += "\"item ";
+        value += std::to_string(r % options_.distinctStrings);
+        value += '\"';
+        break;
+    case Kind::Formula:
+        appendFormula(row, column, value);
+        break;
+    default:
+        break;
+    }
+}
+
+void SheetGenerator::fill(Table& table) const{
+    Table tmp(options_.rows, options_.columns);
+    tmp.setColumnar(table.isColumnar());
+    tmp.setLazyCalculation(table.isLazyCalculation());
+    std::string value;
+    for(size_t row = 0; row < options_.rows; row++){
+        for(size_t column = 0; column < options_.columns; column++){
+            cellValue(row, column, value);
+            if(!value.empty()){
+                tmp.loadCellValue(row, column, value);
+            }
+        }
+    }
+    tmp.recalculateAllFormulas();
+    table = tmp;
+}
+
+uint64_t SheetGenerator::writeCsv(const std::string& filename) const{
+    std::ofstream writeFile(filename, std::ios::trunc | std::ios::binary);
+    if(writeFile.fail()){
+        throw std::invalid_argument("Unexpected error while opening file " + filename);
+    }
+    std::string line;
+    std::string value;
+    uint64_t size = 0;
+    for(size_t row = 0; row < options_.rows; row++){
+        line.clear();
+        for(size_t column = 0; column < options_.columns; column++){
+            cellValue(row, column, value);
+            line += value;
+            if(column + 1 < options_.columns){
+                line += ',';
+            }
+        }
+        if(row + 1 < options_.rows){
+            line += '\n';
+        }
+        writeFile << line;
+        size += line.size();
+        if(writeFile.fail()){
+            throw std::invalid_argument("Unexpected error while writing file " + filename);
+        }
+    }
+    return size;
+}
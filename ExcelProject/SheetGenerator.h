@@ -0,0 +1,120 @@
+#ifndef SHEET_GENERATOR_H
+#define SHEET_GENERATOR_H
+
+#include <iostream>
+#include <cstdint>
+#include <string>
+
+#include "Table.h"
+
+/** SheetGenerator makes up the content of a table of any size: integers, floating numbers, strings,
+ *  formulas and empty cells in the wanted shares, e.g. for measuring how fast the table works.
+ *  \n The content depends only on the options: every cell is derived from the seed and its position
+ *  (\ref cellValue), so the same options always give the same table, and a table of any size can be
+ *  written to a file row by row, without keeping it in memory - \ref writeCsv
+ *  \n Formulas are built like the ones of real workbooks:
+ *  \li arithmetic formulas combine a few cells of the rows just above (fan-in - \ref Options::references),
+ *  e.g. =B10*C11-D9, and some of them continue a chain: they refer to the formula right above them
+ *  (\ref Options::chainDepth)
+ *  \li other formulas summarize a part of a column above, e.g. =SUM(C2:C11) - \ref Options::ranges
+ *  \li a few cells of the first row (rates, constants...) can be referred to by many formulas
+ *  (fan-out - \ref Options::sharedCells)
+ *  \n Formulas refer only to cells of the rows above them, so they never refer to themselves.
+ *  Cells of the first column are never empty, so that no line of a CSV file is empty.
+ */
+class SheetGenerator{
+public:
+
+    /** What to generate. Shares of the cell types are relative to each other (e.g. 1, 1, 0, 2 and 0 means
+     *  a half of formulas and a quarter of integers and floating numbers).
+     */
+    struct Options{
+        size_t rows = 1000;
+        size_t columns = 10;
+        double integers = 3;        /**< share of integers */
+        double doubles = 3;         /**< share of floating numbers */
+        double strings = 1;         /**< share of strings */
+        double formulas = 2;        /**< share of formulas */
+        double empty = 1;           /**< share of empty cells */
+        uint64_t seed = 1;
+
+        size_t distinctStrings = 1000;  /**< count of different strings (cardinality) */
+        size_t references = 2;          /**< count of cells an arithmetic formula refers to */
+        double ranges = 0.5;            /**< part of formulas (0 to 1) which summarize a range instead */
+        size_t rangeRows = 16;          /**< most rows of such a range */
+        /** longest chain of arithmetic formulas referring to the formula right above them. Their other references
+         *  are to cells which are not formulas, so with no ranges this is the longest chain of dependent formulas.
+         */
+        size_t chainDepth = 8;
+        size_t sharedCells = 0;         /**< count of cells of the first row which formulas can refer to */
+        double sharedReferences = 0.1;  /**< part of references (0 to 1) to those cells, if there are such */
+    };
+
+    /** Type of a generated cell
+     */
+    enum class Kind : uint8_t{
+        Integer,
+        Double,
+        String,
+        Formula,
+        Empty
+    };
+
+private:
+
+    Options options_;
+
+    /** \return pseudo-random number which depends only on the seed, the position and the purpose
+     *  it is used for (so different decisions about one cell are independent)
+     */
+    uint64_t random(size_t row, size_t column, uint64_t purpose) const;
+
+    /** Appends a reference to a cell which is not a formula, up to 8 rows above the given one, or to a number
+     *  if there's no such cell
+     */
+    void appendOperand(size_t row, size_t column, uint64_t purpose, std::string& value) const;
+
+    /** Appends a formula for the cell on position row and column
+     */
+    void appendFormula(size_t row, size_t column, std::string& value) const;
+
+public:
+
+    /** \exception invalid_argument no rows or columns, a negative share, all shares are 0, or
+     *  a formula option out of its range
+     */
+    explicit SheetGenerator(const Options& options);
+
+    /** \return the options this generator was created with
+     */
+    const Options& options() const;
+
+    /** \return type of the cell on position row and column
+     */
+    Kind kind(size_t row, size_t column) const;
+
+    /** Writes the value of the cell on position row and column, as it is given to \ref Table::setCellValue
+     *  (empty for an empty cell)
+     *
+     *  \param value receives the value, its capacity is reused
+     */
+    void cellValue(size_t row, size_t column, std::string& value) const;
+
+    /** Replaces the content of the table with the generated cells and calculates the formulas.
+     *  The table gets the size of the generated one and keeps its settings (\ref Table::setColumnar,
+     *  \ref Table::setLazyCalculation).
+     */
+    void fill(Table& table) const;
+
+    /** Writes the generated table as a CSV file, in the format \ref ControlCenter reads, one row at a time.
+     *  The file is replaced if it exists.
+     *
+     *  \exception invalid_argument the file cannot be written
+     *  \return size of the written file in bytes
+     */
+    uint64_t writeCsv(const std::string& filename) const;
+
+};
+
+
+#endif // SHEET_GENERATOR_H
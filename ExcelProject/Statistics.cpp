@@ -0,0 +1,158 @@
+#include <cstdio>
+
+#include "Statistics.h"
+
+std::atomic<uint64_t> Statistics::cellsCreated(0);
+std::atomic<uint64_t> Statistics::formulasEvaluated(0);
+std::atomic<uint64_t> Statistics::bytesRead(0);
+std::atomic<uint64_t> Statistics::bytesWritten(0);
+Statistics::AllocationCounter Statistics::allocationCounters_[ALLOCATION_COUNTERS];
+
+namespace{
+
+/** Counter of the calling thread plus 1, 0 until the thread allocates for the first time */
+thread_local size_t allocationCounter = 0;
+
+std::atomic<size_t> allocatingThreads(0);
+
+}
+
+void Statistics::Histogram::add(double seconds){
+    if(count == 0 || seconds < min){
+        min = seconds;
+    }
+    if(count == 0 || seconds > max){
+        max = seconds;
+    }
+    count++;
+    total += seconds;
+
+    double microseconds = seconds * 1e6;
+    size_t bucket = 0;
+    while(bucket + 1 < BUCKETS && microseconds >= 1){
+        microseconds /= 2;
+        bucket++;
+    }
+    buckets[bucket]++;
+}
+
+Statistics::Timer::Timer(Statistics& statistics, const std::string& name)
+    : statistics_(&statistics), name_(name), start_(std::chrono::steady_clock::now()){
+}
+
+Statistics::Timer::~Timer(){
+    if(statistics_ != nullptr){
+        statistics_->record(name_, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+    }
+}
+
+void Statistics::Timer::cancel(){
+    statistics_ = nullptr;
+}
+
+Statistics::Statistics(){
+    reset();
+}
+
+Statistics::Counters Statistics::counters(){
+    Counters result;
+    result.cellsCreated = cellsCreated.load(std::memory_order_relaxed);
+    result.formulasEvaluated = formulasEvaluated.load(std::memory_order_relaxed);
+    result.bytesRead = bytesRead.load(std::memory_order_relaxed);
+    result.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    for(const AllocationCounter& counter : allocationCounters_){
+        result.allocations += counter.count.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void Statistics::countAllocation(){
+    if(allocationCounter == 0){
+        allocationCounter = allocatingThreads.fetch_add(1, std::memory_order_relaxed) % ALLOCATION_COUNTERS + 1;
+    }
+    AllocationCounter& counter = allocationCounters_[allocationCounter - 1];
+    // only this thread writes the counter, unless there are more threads than counters
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::record(const std::string& name, double seconds){
+    std::lock_guard<std::mutex> lock(mutex_);
+    histograms_[name].add(seconds);
+}
+
+Statistics::Histogram Statistics::histogram(const std::string& name) const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = histograms_.find(name);
+    if(found == histograms_.end()){
+        return Histogram();
+    }
+    return found->second;
+}
+
+Statistics::Counters Statistics::countersSinceReset() const{
+    Counters now = counters();
+    std::lock_guard<std::mutex> lock(mutex_);
+    now.cellsCreated -= start_.cellsCreated;
+    now.formulasEvaluated -= start_.formulasEvaluated;
+    now.bytesRead -= start_.bytesRead;
+    now.bytesWritten -= start_.bytesWritten;
+    now.allocations -= start_.allocations;
+    return now;
+}
+
+void Statistics::appendDuration(double seconds, std::string& result){
+    char text[32];
+    if(seconds < 1e-3){
+        std::snprintf(text, sizeof(text), "%.1f us", seconds * 1e6);
+    }else if(seconds < 1){
+        std::snprintf(text, sizeof(text), "%.1f ms", seconds * 1e3);
+    }else{
+        std::snprintf(text, sizeof(text), "%.2f s", seconds);
+    }
+    result += text;
+}
+
+std::string Statistics::report() const{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::string result;
+    if(histograms_.empty()){
+        result += "No commands recorded.\n";
+    }
+    for(const auto& [name, histogram] : histograms_){
+        result += name + ": " + std::to_string(histogram.count) + "x, total ";
+        appendDuration(histogram.total, result);
+        result += ", mean ";
+        appendDuration(histogram.total / histogram.count, result);
+        result += ", min ";
+        appendDuration(histogram.min, result);
+        result += ", max ";
+        appendDuration(histogram.max, result);
+        result += "\n   ";
+        // only the buckets from the fastest to the slowest duration
+        size_t first = 0;
+        size_t last = Histogram::BUCKETS - 1;
+        while(histogram.buckets[first] == 0) first++;
+        while(histogram.buckets[last] == 0) last--;
+        for(size_t bucket = first; bucket <= last; bucket++){
+            result += " <";
+            appendDuration((double)(1ull << bucket) / 1e6, result);
+            result += ":" + std::to_string(histogram.buckets[bucket]);
+        }
+        result += "\n";
+    }
+
+    lock.unlock();
+    Counters work = countersSinceReset();
+    result += "cells created: " + std::to_string(work.cellsCreated) +
+              ", formulas evaluated: " + std::to_string(work.formulasEvaluated) +
+              ", bytes read: " + std::to_string(work.bytesRead) +
+              ", bytes written: " + std::to_string(work.bytesWritten) +
+              ", allocations: " + std::to_string(work.allocations);
+    return result;
+}
+
+void Statistics::reset(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    histograms_.clear();
+    start_ = counters();
+}
@@ -0,0 +1,140 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+/** Statistics collects where the time of the application goes: how long every command (and every phase of
+ *  loading and saving files) took - \ref record, and how much work was done meanwhile - \ref Counters.
+ *  \n Durations are kept as histograms, with a bucket for every power of 2 microseconds, so that
+ *  a few slow runs of a command stand out among many fast ones - \ref report
+ *  \n The counters are shared by the whole process and updated by the classes doing the work
+ *  (e.g. \ref Table counts the formulas it calculates). An instance only remembers their values when
+ *  it was reset and reports the differences.
+ *  \n Every method can be called by several threads at once.
+ */
+class Statistics{
+public:
+
+    /** Work done by the whole process
+     */
+    struct Counters{
+        uint64_t cellsCreated = 0;
+        uint64_t formulasEvaluated = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t allocations = 0;       /**< calls of operator new */
+    };
+
+    /** Durations of one command or phase
+     */
+    struct Histogram{
+        static constexpr size_t BUCKETS = 40;
+
+        uint64_t count = 0;
+        double total = 0;           /**< seconds */
+        double min = 0;
+        double max = 0;
+        /** bucket 0 counts durations below 1 microsecond, bucket i those from 2^(i-1) to 2^i microseconds */
+        uint64_t buckets[BUCKETS] = {};
+
+        /** Adds a duration in seconds
+         */
+        void add(double seconds);
+    };
+
+    /** Records the time from its creation to its destruction, also if an exception leaves the scope
+     */
+    class Timer{
+        Statistics* statistics_;
+        std::string name_;
+        std::chrono::steady_clock::time_point start_;
+    public:
+        Timer(Statistics& statistics, const std::string& name);
+        ~Timer();
+
+        /** Nothing is recorded
+         */
+        void cancel();
+    };
+
+    /** Cells set by their value (\ref Table::setCellValue, \ref Table::loadCellValue, \ref Table::fill) */
+    static std::atomic<uint64_t> cellsCreated;
+    static std::atomic<uint64_t> formulasEvaluated;
+    static std::atomic<uint64_t> bytesRead;
+    static std::atomic<uint64_t> bytesWritten;
+
+    /** Count of allocation counters - \ref countAllocation */
+    static constexpr size_t ALLOCATION_COUNTERS = 64;
+
+private:
+
+    /** Allocations are counted by every thread in a counter of its own, on a cache line of its own, as every thread
+     *  allocates all the time. The threads after the first \ref ALLOCATION_COUNTERS ones share them.
+     */
+    struct alignas(64) AllocationCounter{
+        std::atomic<uint64_t> count{0};
+    };
+
+    static AllocationCounter allocationCounters_[ALLOCATION_COUNTERS];
+
+    /** Guards \ref histograms_ and \ref start_, as commands may be recorded by several threads at once */
+    mutable std::mutex mutex_;
+
+    /** Histograms by the name of the command or phase (e.g. "OPEN", "load: parse") */
+    std::map<std::string, Histogram> histograms_;
+
+    /** Values of the counters when this instance was reset */
+    Counters start_;
+
+    /** Appends a duration in a short readable form (e.g. "12.5 ms")
+     */
+    static void appendDuration(double seconds, std::string& result);
+
+public:
+
+    /** Statistics starting from now - \ref reset
+     */
+    Statistics();
+
+    /** \return current values of the counters of the process
+     */
+    static Counters counters();
+
+    /** Counts one call of operator new by the calling thread - \ref Counters::allocations
+     */
+    static void countAllocation();
+
+    /** Adds a duration of a command or a phase
+     *
+     *  \param name name of the command, or "command: phase"
+     *  \param seconds duration
+     */
+    void record(const std::string& name, double seconds);
+
+    /** \return histogram of a command or a phase, empty if it was not recorded since the last reset
+     */
+    Histogram histogram(const std::string& name) const;
+
+    /** \return work done since the last reset
+     */
+    Counters countersSinceReset() const;
+
+    /** \return every recorded command and phase (count, total, mean, minimum and maximum duration, and the
+     *  histogram) and the counters since the last reset, as displayable text
+     */
+    std::string report() const;
+
+    /** Forgets every recorded duration and starts counting the work from now
+     */
+    void reset();
+
+};
+
+
+#endif // STATISTICS_H
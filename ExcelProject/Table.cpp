@@ -1,5 +1,10 @@
 #include <iostream>
 #include <vector>
+#include <limits>
+#include <algorithm>
+#include <unordered_set>
+#include <tuple>
+#include <atomic>
 
 #include "Table.h"
 #include "Cell.h"
@@ -7,232 +12,1280 @@
 #include "CellDouble.h"
 #include "CellString.h"
 #include "CellFormula.h"
+#include "AggregateKernels.h"
+#include "Statistics.h"
+#include "Trace.h"
 
-Cell*** Table::allocateTable(std::size_t rows, std::size_t columns){
+void Table::extendTable(size_t rows, size_t columns){
+    Trace::Span span("Table::extendTable");
+    span.argument("rows", rows);
+    span.argument("columns", columns);
 
-    try{
-        Cell*** tmp = new Cell**[rows];
-        for(size_t  currentRow = 0; currentRow < rows; currentRow++){
-            tmp[currentRow] = new Cell*[columns];
-            for(size_t currentCol = 0; currentCol< columns; currentCol++){
-                tmp[currentRow][currentCol] = nullptr;
-            }
+    size_t newRowsCount = std::max(rows, rowsCount_);
+    size_t oldColumnsCount = columns_->size();
+    size_t newColumnsCount = std::max(columns, oldColumnsCount);
+
+    if(newRowsCount > rowsCount_){
+        for(size_t col = 0; col < oldColumnsCount; col++){
+            editColumn(col).resize(newRowsCount);
         }
-        return tmp;
-    }catch(std::bad_alloc& e){
-        std::cerr << "\nTable allocation failed!\n";
-        releaseTableData(false);
-        throw e;
     }
-}
-
-void Table::releaseTableData(bool fullDataClear){
-    for(size_t row = 0; row < rowsCount_; row++){
-        for(size_t  col = 0; col < columnsCount_ && fullDataClear; col++){
-            delete table_[row][col];
+    if(newColumnsCount > oldColumnsCount){
+        editColumns().resize(newColumnsCount);
+        for(size_t col = oldColumnsCount; col < newColumnsCount; col++){
+            (*columns_)[col] = std::make_shared<Column>();
+            (*columns_)[col]->resize(newRowsCount);
         }
-        delete[] table_[row];
     }
-    delete[] table_;
+    rowsCount_ = newRowsCount;
+
+    // the new cells are empty, so the remembered summaries only need room for them
+    for(auto& [column, cache] : aggregateCaches_){
+        cache.reserve((rowsCount_ + AggregateCache::BLOCK_ROWS - 1) / AggregateCache::BLOCK_ROWS);
+    }
 }
 
-void Table::extendTable(size_t rows, size_t columns){
+namespace{
 
-    size_t newRowsCount = std::max(rows, rowsCount_);
-    size_t newColumnsCount = std::max(columns, columnsCount_);
-
-    Cell*** tmp = allocateTable(newRowsCount, newColumnsCount);
+/** \return whether nobody else holds the object, so that it can be changed in place
+ */
+template<class T>
+bool isUnique(const std::shared_ptr<T>& pointer){
+    if(pointer.use_count() != 1){
+        return false;
+    }
+    // whatever the threads which released it did with it happens before the changes made from here on
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
 
-    if(tmp == nullptr) return;
+}
 
-    for(size_t row = 0; row < rowsCount_; row++){
-        for(size_t col = 0; col < columnsCount_; col++){
-            // intended pointer copy
-            tmp[row][col] = table_[row][col];
-        }
+std::vector<std::shared_ptr<Column>>& Table::editColumns() const{
+    if(!isUnique(columns_)){
+        columns_ = std::make_shared<std::vector<std::shared_ptr<Column>>>(*columns_);
     }
+    return *columns_;
+}
 
-    releaseTableData(false);
-
-    table_ = tmp;
-    rowsCount_ = newRowsCount;
-    columnsCount_ = newColumnsCount;
+Column& Table::editColumn(size_t column) const{
+    std::shared_ptr<Column>& shared = editColumns()[column];
+    if(!isUnique(shared)){
+        shared = std::make_shared<Column>(*shared);
+    }
+    return *shared;
+}
 
+Table::Dependencies& Table::editDependencies(){
+    if(!isUnique(dependencies_)){
+        dependencies_ = std::make_shared<Dependencies>(*dependencies_);
+    }
+    return *dependencies_;
 }
 
 Table::Table(){
-    rowsCount_ = 1;
-    columnsCount_ = 1;
-    table_ = allocateTable(rowsCount_, columnsCount_);
+    columns_ = std::make_shared<std::vector<std::shared_ptr<Column>>>();
+    dependencies_ = std::make_shared<Dependencies>();
+    rowsCount_ = 0;
+    columnar_ = false;
+    lazy_ = false;
+    extendTable(1, 1);
 }
 
 Table::Table(size_t rows, size_t cols){
-    rowsCount_ = rows;
-    columnsCount_ = cols;
-    table_ = allocateTable(rowsCount_, columnsCount_);
+    if(rows == 0 || cols == 0){
+        throw std::invalid_argument("Table cannot have 0 rows or 0 columns");
+    }
+    columns_ = std::make_shared<std::vector<std::shared_ptr<Column>>>();
+    dependencies_ = std::make_shared<Dependencies>();
+    rowsCount_ = 0;
+    columnar_ = false;
+    lazy_ = false;
+    extendTable(rows, cols);
 }
 
-// doesnt copy objects, only pointers
-// TO DO: object copy
 Table& Table::operator=(const Table& other){
-    releaseTableData(false);
-    rowsCount_ = other.rowsCount_;
-    columnsCount_ = other.columnsCount_;
-    table_ = allocateTable(rowsCount_, columnsCount_);
-    for(size_t row = 0; row < rowsCount_; row++){
-        for(size_t col = 0; col < columnsCount_; col++){
-            if(other.table_[row][col] == nullptr){
-                table_[row][col] = nullptr;
-            }else{
-                table_[row][col] = other.table_[row][col]->clone();
-            }
-
-        }
+    if(this == &other){
+        return *this;
     }
+    columns_ = other.columns_;
+    rowsCount_ = other.rowsCount_;
+    columnar_ = other.columnar_;
+    dependencies_ = other.dependencies_;
+    // the summaries are built again when they are needed
+    aggregateCaches_.clear();
+    lazy_ = other.lazy_;
+    // each table calculates them in its own copies of their columns
+    dirty_ = other.dirty_;
     return *this;
 }
 
 Table::Table(const Table& copy){
+    rowsCount_ = 0;
+    columnar_ = false;
+    lazy_ = false;
     *this = copy;
 }
 
 Table::~Table(){
-    releaseTableData(true);
+
 }
 
 bool Table::isCellInsideTable(size_t row, size_t column) const{
-    if(row >= rowsCount_ || column >= columnsCount_) return false;
+    if(row >= rowsCount_ || column >= columns_->size()) return false;
     return true;
 }
 
 void Table::recalculateAllFormulas(){
-    for(size_t row = 0; row < rowsCount_; row++){
-        for(size_t col = 0; col < columnsCount_; col++){
-            if(table_[row][col] != nullptr){
-                CellFormula* cf = dynamic_cast<CellFormula*>(table_[row][col]);
-                if(cf != nullptr){
-                    cf->recalculate();
+    Trace::Span span("Table::recalculateAllFormulas");
+    span.argument("formulas", dependencies_->formulaReferences.size());
+    std::vector<uint64_t> formulas;
+    for(auto it = dependencies_->formulaReferences.begin(); it != dependencies_->formulaReferences.end(); it++){
+        formulas.push_back(it->first);
+    }
+    if(lazy_){
+        recalculateDependents(formulas);
+        return;
+    }
+    // every formula is calculated, whether its inputs have changed or not
+    std::vector<std::vector<uint64_t>> components;
+    std::vector<bool> circular;
+    std::vector<size_t> levels;
+    findComponents(formulas, true, components, circular, levels);
+    calculateComponents(components, circular, levels, true, nullptr);
+}
+
+void Table::registerFormula(size_t row, size_t column, const CellFormula& formula){
+    uint64_t key = CellRef(row, column).key();
+    Dependencies& dependencies = editDependencies();
+    std::vector<Range>& references = dependencies.formulaReferences[key];
+    formula.collectReferences(references);
+    for(size_t i = 0; i < references.size(); i++){
+        const Range& ref = references[i];
+        if(ref.fromRow == ref.toRow && ref.fromColumn == ref.toColumn){
+            dependencies.cellDependents[CellRef(ref.fromRow, ref.fromColumn).key()].push_back(key);
+            continue;
+        }
+        for(size_t col = ref.fromColumn; col <= ref.toColumn; col++){
+            dependencies.rangeDependents[col].push_back({ref.fromRow, ref.toRow, key});
+            if(ref.toRow - ref.fromRow + 1 >= CACHED_RANGE_ROWS){
+                dependencies.cachedColumns[col]++;
+            }
+        }
+    }
+}
+
+void Table::unregisterFormula(size_t row, size_t column){
+    uint64_t key = CellRef(row, column).key();
+    if(dependencies_->formulaReferences.count(key) == 0){
+        return;
+    }
+    Dependencies& dependencies = editDependencies();
+    auto found = dependencies.formulaReferences.find(key);
+    const std::vector<Range>& references = found->second;
+    for(size_t i = 0; i < references.size(); i++){
+        const Range& ref = references[i];
+        if(ref.fromRow == ref.toRow && ref.fromColumn == ref.toColumn){
+            auto cell = dependencies.cellDependents.find(CellRef(ref.fromRow, ref.fromColumn).key());
+            if(cell == dependencies.cellDependents.end()){
+                continue;
+            }
+            std::vector<uint64_t>& dependents = cell->second;
+            dependents.erase(std::remove(dependents.begin(), dependents.end(), key), dependents.end());
+            if(dependents.empty()){
+                dependencies.cellDependents.erase(cell);
+            }
+            continue;
+        }
+        for(size_t col = ref.fromColumn; col <= ref.toColumn; col++){
+            auto cached = dependencies.cachedColumns.find(col);
+            if(ref.toRow - ref.fromRow + 1 >= CACHED_RANGE_ROWS && cached != dependencies.cachedColumns.end() &&
+               --cached->second == 0){
+                dependencies.cachedColumns.erase(cached);
+                aggregateCaches_.erase(col);
+            }
+            auto ranges = dependencies.rangeDependents.find(col);
+            if(ranges == dependencies.rangeDependents.end()){
+                continue;
+            }
+            std::vector<RangeDependent>& dependents = ranges->second;
+            dependents.erase(std::remove_if(dependents.begin(), dependents.end(),
+                                            [key](const RangeDependent& d){ return d.formula == key; }),
+                             dependents.end());
+            if(dependents.empty()){
+                dependencies.rangeDependents.erase(ranges);
+            }
+        }
+    }
+    dependencies.formulaReferences.erase(found);
+    dirty_.erase(dirtyKey(row, column));
+}
+
+void Table::findDependents(CellRef cell, std::vector<uint64_t>& dependents) const{
+    auto direct = dependencies_->cellDependents.find(cell.key());
+    if(direct != dependencies_->cellDependents.end()){
+        dependents.insert(dependents.end(), direct->second.begin(), direct->second.end());
+    }
+    auto ranges = dependencies_->rangeDependents.find(cell.column());
+    if(ranges != dependencies_->rangeDependents.end()){
+        size_t row = cell.row();
+        for(const RangeDependent& dependent : ranges->second){
+            if(dependent.fromRow <= row && row <= dependent.toRow){
+                dependents.push_back(dependent.formula);
+            }
+        }
+    }
+}
+
+void Table::findDirtyPrecedents(CellRef cell, std::vector<uint64_t>& precedents) const{
+    auto found = dependencies_->formulaReferences.find(cell.key());
+    if(found == dependencies_->formulaReferences.end()){
+        return;
+    }
+    for(const Range& ref : found->second){
+        size_t lastColumn = std::min(ref.toColumn, columns_->size() - 1);
+        for(size_t col = ref.fromColumn; col <= lastColumn; col++){
+            auto it = dirty_.lower_bound(dirtyKey(ref.fromRow, col));
+            uint64_t last = dirtyKey(std::min(ref.toRow, rowsCount_ - 1), col);
+            for(; it != dirty_.end() && *it <= last; it++){
+                precedents.push_back(CellRef(*it & 0xFFFFFFFF, *it >> 32).key());
+            }
+        }
+    }
+}
+
+void Table::findComponents(const std::vector<uint64_t>& cells, bool dependents,
+                           std::vector<std::vector<uint64_t>>& components, std::vector<bool>& circular,
+                           std::vector<size_t>& levels) const{
+
+    struct Visit{
+        size_t index;
+        size_t lowLink;
+        bool onStack;
+        bool circular;      /**< refers to itself directly */
+        size_t level;       /**< above the components found already which are reachable from it */
+        size_t component;
+    };
+    struct Frame{
+        uint64_t cell;
+        std::vector<uint64_t> next;
+        size_t position;
+    };
+
+    std::unordered_map<uint64_t, Visit> visits;
+    std::vector<uint64_t> stack;
+    std::vector<Frame> path;
+
+    auto enter = [&](uint64_t cell){
+        size_t index = visits.size();
+        visits[cell] = {index, index, true, false, 0, 0};
+        stack.push_back(cell);
+        path.push_back({cell, {}, 0});
+        if(dependents){
+            findDependents(CellRef::fromKey(cell), path.back().next);
+        }else{
+            findDirtyPrecedents(CellRef::fromKey(cell), path.back().next);
+        }
+    };
+
+    for(size_t i = 0; i < cells.size(); i++){
+        if(visits.count(cells[i]) != 0){
+            continue;
+        }
+        enter(cells[i]);
+        while(!path.empty()){
+            Frame& frame = path.back();
+            if(frame.position < frame.next.size()){
+                uint64_t next = frame.next[frame.position++];
+                auto visited = visits.find(next);
+                if(visited == visits.end()){
+                    enter(next);
+                    continue;
+                }
+                Visit& current = visits[frame.cell];
+                if(next == frame.cell){
+                    current.circular = true;
+                }
+                if(visited->second.onStack){
+                    current.lowLink = std::min(current.lowLink, visited->second.index);
+                }else{
+                    current.level = std::max(current.level, levels[visited->second.component] + 1);
+                }
+                continue;
+            }
+
+            uint64_t cell = frame.cell;
+            path.pop_back();
+            Visit& visit = visits[cell];
+            if(visit.lowLink == visit.index){
+                components.emplace_back();
+                size_t level = 0;
+                uint64_t member;
+                do{
+                    member = stack.back();
+                    stack.pop_back();
+                    Visit& memberVisit = visits[member];
+                    memberVisit.onStack = false;
+                    memberVisit.component = components.size() - 1;
+                    level = std::max(level, memberVisit.level);
+                    components.back().push_back(member);
+                }while(member != cell);
+                circular.push_back(components.back().size() > 1 || visit.circular);
+                levels.push_back(level);
+            }
+            if(!path.empty()){
+                Visit& parent = visits[path.back().cell];
+                parent.lowLink = std::min(parent.lowLink, visit.lowLink);
+                if(!visit.onStack){
+                    parent.level = std::max(parent.level, levels[visit.component] + 1);
                 }
             }
         }
     }
 }
 
-void Table::setCellValue(size_t row, size_t column, const std::string& value){
-    if(!isCellInsideTable(row, column)){
-        extendTable(row + 1, column + 1);
+bool Table::calculateComponent(const std::vector<uint64_t>& component, bool circular) const{
+    bool changed = false;
+    for(size_t j = 0; j < component.size(); j++){
+        CellRef ref = CellRef::fromKey(component[j]);
+        size_t row = ref.row();
+        size_t col = ref.column();
+        if(!isCellInsideTable(row, col)){
+            continue;
+        }
+        if(columnAt(col).getStoredCell(row) == nullptr){
+            continue;
+        }
+        CellFormula* cf = dynamic_cast<CellFormula*>(editColumn(col).getStoredCell(row));
+        if(cf == nullptr){
+            continue;
+        }
+        Trace::Span span("formula");
+        if(span.active()){
+            span.argument("cell", ref.toString());
+        }
+        double oldValue;
+        ValueKind oldKind = columnAt(col).getNumericValue(row, oldValue);
+        FormulaProgram::Error oldError = cf->errorCode();
+        if(circular){
+            cf->markCircular();
+        }else{
+            // formulas of a copied table still take their references from the table they were copied from
+            cf->setTable(this);
+            cf->recalculate();
+            Statistics::formulasEvaluated.fetch_add(1, std::memory_order_relaxed);
+        }
+        double newValue;
+        ValueKind newKind = columnAt(col).getNumericValue(row, newValue);
+        if(newKind != oldKind || newValue != oldValue){
+            changed = true;
+            cellValueChanged(row, col, oldKind, oldValue);
+        }else if(cf->errorCode() != oldError){
+            // the formulas referring to it get the new error
+            changed = true;
+        }
     }
+    return changed;
+}
 
-    Cell* newCellPtr = nullptr;
+void Table::calculateComponents(const std::vector<std::vector<uint64_t>>& components, const std::vector<bool>& circular,
+                                const std::vector<size_t>& levels, bool dependents,
+                                const std::vector<uint64_t>* changed) const{
+    Trace::Span span("Table::calculateComponents");
+    span.argument("components", components.size());
+
+    // only formulas whose inputs have changed are calculated. A formula which gets the same value
+    // as before does not change anything for the formulas depending on it
+    std::unordered_set<uint64_t> changedInputs;
+    std::vector<uint64_t> found;
+    if(changed != nullptr){
+        changedInputs.insert(changed->begin(), changed->end());
+        for(size_t i = 0; i < changed->size(); i++){
+            findDependents(CellRef::fromKey((*changed)[i]), found);
+        }
+        changedInputs.insert(found.begin(), found.end());
+    }
+    auto needed = [&](const std::vector<uint64_t>& component){
+        if(changed == nullptr){
+            return true;
+        }
+        for(size_t j = 0; j < component.size(); j++){
+            if(changedInputs.count(component[j]) != 0){
+                return true;
+            }
+        }
+        return false;
+    };
+    auto calculated = [&](const std::vector<uint64_t>& component, bool valueChanged){
+        if(changed == nullptr || !valueChanged){
+            return;
+        }
+        for(size_t j = 0; j < component.size(); j++){
+            found.clear();
+            findDependents(CellRef::fromKey(component[j]), found);
+            changedInputs.insert(found.begin(), found.end());
+        }
+    };
+
+    if(components.size() < BATCH_COMPONENTS){
+        for(size_t k = 0; k < components.size(); k++){
+            size_t i = dependents ? components.size() - 1 - k : k;
+            if(needed(components[i])){
+                calculated(components[i], calculateComponent(components[i], circular[i]));
+            }
+        }
+        return;
+    }
+
+    // components of every level next to each other
+    size_t levelsCount = *std::max_element(levels.begin(), levels.end()) + 1;
+    std::vector<size_t> levelStart(levelsCount + 1, 0);
+    for(size_t i = 0; i < components.size(); i++){
+        levelStart[levels[i] + 1]++;
+    }
+    for(size_t l = 0; l < levelsCount; l++){
+        levelStart[l + 1] += levelStart[l];
+    }
+    std::vector<size_t> byLevel(components.size());
+    std::vector<size_t> position(levelStart.begin(), levelStart.end() - 1);
+    for(size_t i = 0; i < components.size(); i++){
+        byLevel[position[levels[i]]++] = i;
+    }
+
+    struct Member{
+        const CellFormula::Template* shared;
+        size_t column;
+        size_t row;
+        size_t component;
+        CellFormula* formula;
+    };
+    std::vector<Member> members;
+    double results[GATHER_ROWS];
 
+    for(size_t k = 0; k < levelsCount; k++){
+        // the components a component refers to have higher levels if they were found by following dependents
+        size_t l = dependents ? levelsCount - 1 - k : k;
+        Trace::Span levelSpan("level");
+        levelSpan.argument("level", l);
+        levelSpan.argument("components", levelStart[l + 1] - levelStart[l]);
+
+        // single formulas can be calculated together, the others one by one
+        members.clear();
+        for(size_t m = levelStart[l]; m < levelStart[l + 1]; m++){
+            size_t i = byLevel[m];
+            if(!needed(components[i])){
+                continue;
+            }
+            CellRef ref = CellRef::fromKey(components[i][0]);
+            CellFormula* cf = nullptr;
+            if(components[i].size() == 1 && !circular[i] && isCellInsideTable(ref.row(), ref.column())){
+                cf = dynamic_cast<CellFormula*>(editColumn(ref.column()).getStoredCell(ref.row()));
+            }
+            if(cf == nullptr){
+                calculated(components[i], calculateComponent(components[i], circular[i]));
+                continue;
+            }
+            members.push_back({cf->getTemplate().get(), ref.column(), ref.row(), i, cf});
+        }
+        std::sort(members.begin(), members.end(), [](const Member& a, const Member& b){
+            return std::tie(a.shared, a.column, a.row) < std::tie(b.shared, b.column, b.row);
+        });
+
+        for(size_t first = 0; first < members.size(); ){
+            // consecutive rows of one column, whose references move down one row at a time
+            const Member& start = members[first];
+            size_t count = 1;
+            while(first + count < members.size() && count < GATHER_ROWS){
+                const Member& next = members[first + count];
+                if(next.shared != start.shared || next.column != start.column || next.row != start.row + count ||
+                   next.formula->rowOffset() != start.formula->rowOffset() + (int64_t)count ||
+                   next.formula->columnOffset() != start.formula->columnOffset()){
+                    break;
+                }
+                count++;
+            }
+            Trace::Span batchSpan("formula batch");
+            if(batchSpan.active()){
+                batchSpan.argument("cell", CellRef(start.row, start.column).toString());
+                batchSpan.argument("formulas", count);
+            }
+
+            bool run = count > 1 && start.shared->program.evaluateRun(*this, start.formula->rowOffset(),
+                                                                       start.formula->columnOffset(), count, results);
+            if(run){
+                Statistics::formulasEvaluated.fetch_add(count, std::memory_order_relaxed);
+            }
+            for(size_t j = first; j < first + count; j++){
+                const Member& member = members[j];
+                const std::vector<uint64_t>& component = components[member.component];
+                if(!run){
+                    // one by one, so that the formulas which fail get their errors
+                    calculated(component, calculateComponent(component, false));
+                    continue;
+                }
+                double oldValue;
+                ValueKind oldKind = columnAt(member.column).getNumericValue(member.row, oldValue);
+                double result = results[j - first];
+                member.formula->restoreResult(result, FormulaProgram::Error::None);
+                bool valueChanged = oldKind != ValueKind::Number || result != oldValue;
+                if(valueChanged){
+                    cellValueChanged(member.row, member.column, oldKind, oldValue);
+                }
+                calculated(component, valueChanged);
+            }
+            first += count;
+        }
+    }
+}
+
+void Table::recalculateDependents(const std::vector<uint64_t>& cells){
+    Trace::Span span("Table::recalculateDependents");
+    span.argument("cells", cells.size());
+
+    if(lazy_){
+        // every formula depending on a dirty one is dirty already, so the walk stops there
+        std::vector<uint64_t> pending(cells);
+        std::vector<uint64_t> dependents;
+        for(size_t i = 0; i < cells.size(); i++){
+            if(dependencies_->formulaReferences.count(cells[i]) != 0){
+                CellRef cell = CellRef::fromKey(cells[i]);
+                dirty_.insert(dirtyKey(cell.row(), cell.column()));
+            }
+        }
+        while(!pending.empty()){
+            CellRef cell = CellRef::fromKey(pending.back());
+            pending.pop_back();
+            dependents.clear();
+            findDependents(cell, dependents);
+            for(size_t i = 0; i < dependents.size(); i++){
+                CellRef dependent = CellRef::fromKey(dependents[i]);
+                if(dirty_.insert(dirtyKey(dependent.row(), dependent.column())).second){
+                    pending.push_back(dependents[i]);
+                }
+            }
+        }
+        return;
+    }
+
+    // strongly connected components, every one after all components depending on it
+    std::vector<std::vector<uint64_t>> components;
+    std::vector<bool> circular;
+    std::vector<size_t> levels;
+    findComponents(cells, true, components, circular, levels);
+    calculateComponents(components, circular, levels, true, &cells);
+}
+
+uint64_t Table::dirtyKey(size_t row, size_t column){
+    return ((uint64_t)column << 32) | (uint32_t)row;
+}
+
+void Table::calculateDirty(const std::vector<uint64_t>& cells) const{
+    Trace::Span span("Table::calculateDirty");
+    span.argument("cells", cells.size());
+    // strongly connected components, every one after all components it refers to
+    std::vector<std::vector<uint64_t>> components;
+    std::vector<bool> circular;
+    std::vector<size_t> levels;
+    findComponents(cells, false, components, circular, levels);
+
+    // none of them is dirty any more, even while the others are being calculated
+    for(size_t i = 0; i < components.size(); i++){
+        for(size_t j = 0; j < components[i].size(); j++){
+            CellRef ref = CellRef::fromKey(components[i][j]);
+            dirty_.erase(dirtyKey(ref.row(), ref.column()));
+        }
+    }
+    calculateComponents(components, circular, levels, false, nullptr);
+}
+
+void Table::calculateIfDirty(size_t row, size_t column) const{
+    if(dirty_.empty() || dirty_.count(dirtyKey(row, column)) == 0){
+        return;
+    }
+    calculateDirty({CellRef(row, column).key()});
+}
+
+void Table::calculateDirtyRange(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const{
+    if(dirty_.empty()){
+        return;
+    }
+    size_t firstRow = std::min(fromRow, toRow);
+    size_t lastRow = std::max(fromRow, toRow);
+    size_t lastColumn = std::min(std::max(fromColumn, toColumn), columns_->size() - 1);
+    std::vector<uint64_t> cells;
+    for(size_t col = std::min(fromColumn, toColumn); col <= lastColumn; col++){
+        auto it = dirty_.lower_bound(dirtyKey(firstRow, col));
+        uint64_t last = dirtyKey(std::min(lastRow, rowsCount_ - 1), col);
+        for(; it != dirty_.end() && *it <= last; it++){
+            cells.push_back(CellRef(*it & 0xFFFFFFFF, *it >> 32).key());
+        }
+    }
+    if(!cells.empty()){
+        calculateDirty(cells);
+    }
+}
+
+bool Table::hasDirtyFormulas() const{
+    return !dirty_.empty();
+}
+
+void Table::calculateDirtyFormulas() const{
+    std::vector<uint64_t> cells;
+    for(uint64_t key : dirty_){
+        cells.push_back(CellRef(key & 0xFFFFFFFF, key >> 32).key());
+    }
+    calculateDirty(cells);
+}
+
+void Table::cellValueChanged(size_t row, size_t column, ValueKind oldKind, double oldValue) const{
+    auto cached = aggregateCaches_.find(column);
+    if(cached == aggregateCaches_.end()){
+        return;
+    }
+    double newValue;
+    ValueKind newKind = columnAt(column).getNumericValue(row, newValue);
+    if(newKind == oldKind && newValue == oldValue){
+        return;
+    }
+    // the block is read again, so that nothing has to be taken back out of its summary
+    size_t block = row / AggregateCache::BLOCK_ROWS;
+    size_t firstRow = block * AggregateCache::BLOCK_ROWS;
+    AggregateKernels::Summary summary;
+    bool error = false;
+    scanRange(firstRow, column, std::min(firstRow + AggregateCache::BLOCK_ROWS, rowsCount_) - 1, column, summary, error);
+    cached->second.setBlock(block, summary, error);
+}
+
+Cell* Table::createCell(const std::string& value){
+
+    // the first type which accepts the value is used. Integers are also valid floating numbers,
+    // so they need to be tried first
     try{
-        CellInt* newCell = new CellInt(value);
-        newCellPtr = dynamic_cast<Cell*>(newCell);
+        return new CellInt(value);
     }catch(std::invalid_argument& e){
         // not an integer
+    }catch(std::out_of_range& e){
+        // too large for an integer, but still might be a floating number
     }
 
     try{
-        CellDouble* newCell = new CellDouble(value);
-        newCellPtr = dynamic_cast<Cell*>(newCell);
+        return new CellDouble(value);
     }catch(std::invalid_argument& e){
         // not a floating number
+    }catch(std::out_of_range& e){
+        // too large even for a floating number
     }
 
     try{
-        CellFormula* newCell = new CellFormula(this, value);
-        newCellPtr = dynamic_cast<CellFormula*>(newCell);
+        return new CellFormula(this, value, FormulaProgram::compile(value), 0, FormulaProgram::Error::Value);
     }catch(std::invalid_argument& e){
         // not a formula
     }
 
     try{
-        CellString* newCell = new CellString(value);
-        newCellPtr = dynamic_cast<Cell*>(newCell);
+        return new CellString(value);
     }catch(std::invalid_argument& e){
         // not a string
     }
 
+    throw std::invalid_argument("Invalid type");
+}
+
+bool Table::parseTypedValue(const std::string& value, TypedValue& typed){
+    try{
+        typed.intValue = CellInt(value).getValue();
+        typed.kind = TypedValue::Kind::Int;
+        return true;
+    }catch(std::invalid_argument& e){
+        // not an integer
+    }catch(std::out_of_range& e){
+        // too large for an integer
+    }
+
+    try{
+        typed.doubleValue = CellDouble(value).getValue();
+        typed.kind = TypedValue::Kind::Double;
+        return true;
+    }catch(std::invalid_argument& e){
+        // not a floating number
+    }catch(std::out_of_range& e){
+        // too large even for a floating number
+    }
+
+    CellString cs;
+    typed.kind = TypedValue::Kind::String;
+    return cs.isValid(value);
+}
+
+bool Table::setTypedValue(size_t row, size_t column, const std::string& value, const TypedValue& typed){
+    Column& target = editColumn(column);
+    switch(typed.kind){
+    case TypedValue::Kind::Int:
+        return target.setInt(row, typed.intValue);
+    case TypedValue::Kind::Double:
+        return target.setDouble(row, typed.doubleValue);
+    default:
+        return target.setString(row, value);
+    }
+}
+
+void Table::storeCellValue(size_t row, size_t column, const std::string& value, bool calculate){
+
+    // make sure the value is valid before changing anything. A typed value is only read here,
+    // anything else becomes a cell right away (or is rejected)
+    Cell* newCellPtr = nullptr;
+    TypedValue typed;
+    if(!columnar_ || value.empty() || value[0] == '=' || !parseTypedValue(value, typed)){
+        newCellPtr = createCell(value);
+    }
+
+    if(!isCellInsideTable(row, column)){
+        extendTable(row + 1, column + 1);
+    }
+
+    double oldValue;
+    ValueKind oldKind = columnAt(column).getNumericValue(row, oldValue);
+
+    if(newCellPtr == nullptr && !setTypedValue(row, column, value, typed)){
+        // does not fit the typed values of the column
+        newCellPtr = createCell(value);
+    }
+
+    unregisterFormula(row, column);
+    CellFormula* cf = dynamic_cast<CellFormula*>(newCellPtr);
     if(newCellPtr != nullptr){
-        deleteCellValue(row, column);
-        table_[row][column] = newCellPtr;
-    }else{
-        throw std::invalid_argument("Invalid type");
+        editColumn(column).setCell(row, newCellPtr);
+        if(cf != nullptr){
+            registerFormula(row, column, *cf);
+            if(lazy_){
+                dirty_.insert(dirtyKey(row, column));
+            }
+        }
+    }
+
+    Statistics::cellsCreated.fetch_add(1, std::memory_order_relaxed);
+    cellValueChanged(row, column, oldKind, oldValue);
+    // a new formula is calculated here, together with the formulas depending on it.
+    // Other values matter to formulas only if they are different numbers (or kinds) than before
+    double newValue;
+    ValueKind newKind = columnAt(column).getNumericValue(row, newValue);
+    if(calculate && (cf != nullptr || newKind != oldKind || newValue != oldValue)){
+        recalculateDependents({CellRef(row, column).key()});
+    }
+
+}
+
+void Table::setCellValue(size_t row, size_t column, const std::string& value){
+    Trace::Span span("Table::setCellValue");
+    if(span.active()){
+        span.argument("cell", CellRef(row, column).toString());
+    }
+    storeCellValue(row, column, value, true);
+}
+
+void Table::loadCellValue(size_t row, size_t column, const std::string& value){
+    storeCellValue(row, column, value, false);
+}
+
+bool Table::restoreFormulaResult(size_t row, size_t column, double result, FormulaProgram::Error error){
+    if(!isCellInsideTable(row, column)){
+        return false;
+    }
+    if(dynamic_cast<const CellFormula*>(columnAt(column).getStoredCell(row)) == nullptr){
+        return false;
+    }
+    CellFormula* cf = dynamic_cast<CellFormula*>(editColumn(column).getStoredCell(row));
+    double oldValue;
+    ValueKind oldKind = columnAt(column).getNumericValue(row, oldValue);
+    cf->restoreResult(result, error);
+    dirty_.erase(dirtyKey(row, column));
+    cellValueChanged(row, column, oldKind, oldValue);
+    return true;
+}
+
+size_t Table::formulasCount() const{
+    return dependencies_->formulaReferences.size();
+}
+
+namespace{
+
+/** Adds the buckets and nodes of a hash map, not what its values own
+ */
+template<class Map>
+void addHashMap(const Map& map, uint64_t& bytes, uint64_t& blocks){
+    bytes += map.bucket_count() * sizeof(void*) + map.size() * (MemoryUsage::HASH_NODE + sizeof(typename Map::value_type));
+    blocks += 1 + map.size();
+}
+
+}
+
+MemoryUsage Table::memoryUsage() const{
+    MemoryUsage usage;
+    // the list of columns and every column live in blocks with their reference counts - \ref editColumn
+    usage.grid += 2 * sizeof(void*) + sizeof(*columns_) + columns_->capacity() * sizeof(std::shared_ptr<Column>);
+    usage.blocks += 1 + !columns_->empty();
+    for(size_t col = 0; col < columns_->size(); col++){
+        usage.grid += 2 * sizeof(void*) + sizeof(Column);
+        usage.blocks++;
+        columnAt(col).addMemoryUsage(usage);
     }
 
-    recalculateAllFormulas();
+    const Dependencies& dependencies = *dependencies_;
+    addHashMap(dependencies.cellDependents, usage.dependencies, usage.blocks);
+    for(const auto& [cell, formulas] : dependencies.cellDependents){
+        usage.dependencies += formulas.capacity() * sizeof(uint64_t);
+        usage.blocks += !formulas.empty();
+    }
+    addHashMap(dependencies.rangeDependents, usage.dependencies, usage.blocks);
+    for(const auto& [column, formulas] : dependencies.rangeDependents){
+        usage.dependencies += formulas.capacity() * sizeof(RangeDependent);
+        usage.blocks += !formulas.empty();
+    }
+    addHashMap(dependencies.cachedColumns, usage.dependencies, usage.blocks);
+    addHashMap(dependencies.formulaReferences, usage.dependencies, usage.blocks);
+    for(const auto& [formula, references] : dependencies.formulaReferences){
+        usage.dependencies += references.capacity() * sizeof(Range);
+        usage.blocks += !references.empty();
+    }
 
+    usage.caches += dirty_.size() * (MemoryUsage::TREE_NODE + sizeof(uint64_t));
+    usage.caches += aggregateCaches_.size() * (MemoryUsage::TREE_NODE + sizeof(decltype(aggregateCaches_)::value_type));
+    usage.blocks += dirty_.size() + 2 * aggregateCaches_.size();
+    for(const auto& [column, cache] : aggregateCaches_){
+        usage.caches += cache.bytes();
+    }
+    return usage;
 }
 
 void Table::deleteCellValue(size_t row, size_t column){
     if(!isCellInsideTable(row, column)){
         return;
     }
-    delete table_[row][column];
+    double oldValue;
+    ValueKind oldKind = columnAt(column).getNumericValue(row, oldValue);
+    unregisterFormula(row, column);
+    editColumn(column).erase(row);
+    cellValueChanged(row, column, oldKind, oldValue);
+    if(oldKind != ValueKind::Empty){
+        recalculateDependents({CellRef(row, column).key()});
+    }
+}
+
+void Table::fill(size_t sourceRow, size_t sourceColumn, size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn){
+    Trace::Span span("Table::fill");
+    size_t firstRow = std::min(fromRow, toRow);
+    size_t lastRow = std::max(fromRow, toRow);
+    size_t firstColumn = std::min(fromColumn, toColumn);
+    size_t lastColumn = std::max(fromColumn, toColumn);
+
+    std::string buffer;
+    std::string value(getConstructedCellView(sourceRow, sourceColumn, buffer));
+    const CellFormula* source = nullptr;
+    if(isCellInsideTable(sourceRow, sourceColumn)){
+        source = dynamic_cast<const CellFormula*>(columnAt(sourceColumn).getStoredCell(sourceRow));
+    }
+    // the source may be replaced while the range is filled, the template stays alive
+    std::shared_ptr<const CellFormula::Template> shared;
+    int64_t rowOffset = 0;
+    int64_t columnOffset = 0;
+    if(source != nullptr){
+        shared = source->getTemplate();
+        rowOffset = source->rowOffset() - (int64_t)sourceRow;
+        columnOffset = source->columnOffset() - (int64_t)sourceColumn;
+    }
+
+    if(!value.empty() && !isCellInsideTable(lastRow, lastColumn)){
+        extendTable(lastRow + 1, lastColumn + 1);
+    }
+
+    std::vector<uint64_t> changed;
+    for(size_t col = firstColumn; col <= lastColumn; col++){
+        for(size_t row = firstRow; row <= lastRow; row++){
+            if((row == sourceRow && col == sourceColumn) || (value.empty() && !isCellInsideTable(row, col))){
+                continue;
+            }
+            if(shared == nullptr){
+                if(value.empty()){
+                    double oldValue;
+                    ValueKind oldKind = columnAt(col).getNumericValue(row, oldValue);
+                    unregisterFormula(row, col);
+                    editColumn(col).erase(row);
+                    cellValueChanged(row, col, oldKind, oldValue);
+                }else{
+                    storeCellValue(row, col, value, false);
+                }
+            }else{
+                CellFormula* cf = new CellFormula(this, shared, rowOffset + (int64_t)row, columnOffset + (int64_t)col, 0,
+                                                   FormulaProgram::Error::Value);
+                double oldValue;
+                ValueKind oldKind = columnAt(col).getNumericValue(row, oldValue);
+                unregisterFormula(row, col);
+                editColumn(col).setCell(row, cf);
+                registerFormula(row, col, *cf);
+                if(lazy_){
+                    dirty_.insert(dirtyKey(row, col));
+                }
+                Statistics::cellsCreated.fetch_add(1, std::memory_order_relaxed);
+                cellValueChanged(row, col, oldKind, oldValue);
+            }
+            changed.push_back(CellRef(row, col).key());
+        }
+    }
+    recalculateDependents(changed);
 }
 
 void Table::resetTable(){
-    releaseTableData(true);
-    rowsCount_ = 1;
-    columnsCount_ = 1;
-    table_ = allocateTable(rowsCount_, columnsCount_);
+    columns_ = std::make_shared<std::vector<std::shared_ptr<Column>>>();
+    rowsCount_ = 0;
+    dependencies_ = std::make_shared<Dependencies>();
+    aggregateCaches_.clear();
+    dirty_.clear();
+    extendTable(1, 1);
+}
+
+void Table::setColumnar(bool columnar){
+    columnar_ = columnar;
+    for(size_t col = 0; col < columns_->size(); col++){
+        if(columnar){
+            editColumn(col).storeTyped();
+        }else{
+            editColumn(col).storeCells();
+        }
+    }
+}
+
+bool Table::isColumnar() const{
+    return columnar_;
+}
+
+void Table::setLazyCalculation(bool lazy){
+    if(!lazy){
+        calculateDirtyFormulas();
+    }
+    lazy_ = lazy;
+}
+
+bool Table::isLazyCalculation() const{
+    return lazy_;
 }
 
 std::string Table::getDisplayableCellValue(size_t row, size_t column){
-    if(isCellInsideTable(row, column) && table_[row][column] != nullptr){
-        return table_[row][column]->getDisplayableString();
+    std::string buffer;
+    return std::string(getDisplayableCellView(row, column, buffer));
+}
+
+std::string Table::getConstructedCellValue(size_t row, size_t column){
+    std::string buffer;
+    return std::string(getConstructedCellView(row, column, buffer));
+}
+
+const Cell* Table::getCellPointer(size_t row, size_t column, std::unique_ptr<Cell>& buffer) const{
+    if(!isCellInsideTable(row, column)){
+        return nullptr;
+    }
+    calculateIfDirty(row, column);
+    return columnAt(column).getCellPointer(row, buffer);
+}
+
+const Cell* Table::getCellPointer(size_t row, size_t column){
+    if(isCellInsideTable(row, column)){
+        calculateIfDirty(row, column);
+        // the Cell object of a typed value is created inside the column
+        if(columnAt(column).getStoredCell(row) != nullptr){
+            return columnAt(column).getStoredCell(row);
+        }
+        return editColumn(column).getCellPointer(row);
     }else{
-        return "";
+        return nullptr;
     }
 }
 
-std::string Table::getConstructedCellValue(size_t row, size_t column){
-    if(isCellInsideTable(row, column) && table_[row][column] != nullptr){
-        return table_[row][column]->getConstructString();
+const Column& Table::columnAt(size_t column) const{
+    return *(*columns_)[column];
+}
+
+void Table::assignColumns(std::vector<Column>& columns, size_t rows){
+    if(rows == 0 || columns.empty()){
+        throw std::invalid_argument("Table cannot have 0 rows or 0 columns");
+    }
+    columns_ = std::make_shared<std::vector<std::shared_ptr<Column>>>();
+    for(size_t col = 0; col < columns.size(); col++){
+        columns_->push_back(std::make_shared<Column>(std::move(columns[col])));
+    }
+    columns.clear();
+    rowsCount_ = rows;
+    dependencies_ = std::make_shared<Dependencies>();
+    aggregateCaches_.clear();
+    dirty_.clear();
+
+    for(size_t col = 0; col < columns_->size(); col++){
+        const std::vector<uint64_t>& cells = columnAt(col).cellBits();
+        for(size_t word = 0; word < cells.size(); word++){
+            for(uint64_t bits = cells[word]; bits != 0; bits &= bits - 1){
+                size_t row = word * 64 + __builtin_ctzll(bits);
+                CellFormula* cf = dynamic_cast<CellFormula*>(columnAt(col).getStoredCell(row));
+                if(cf != nullptr){
+                    cf->setTable(this);
+                    registerFormula(row, col, *cf);
+                }
+            }
+        }
+    }
+}
+
+std::string_view Table::getDisplayableCellView(size_t row, size_t column, std::string& buffer) const{
+    if(isCellInsideTable(row, column)){
+        calculateIfDirty(row, column);
+        return columnAt(column).getDisplayableView(row, buffer);
     }else{
-        return "";
+        return std::string_view();
     }
 }
 
-const Cell* Table::getCellPointer(size_t row, size_t column) const{
-    if(isCellInsideTable(row, column) && table_[row][column] != nullptr){
-        return table_[row][column];
+std::string_view Table::getConstructedCellView(size_t row, size_t column, std::string& buffer) const{
+    if(isCellInsideTable(row, column)){
+        return columnAt(column).getConstructView(row, buffer);
     }else{
+        return std::string_view();
+    }
+}
+
+Table::ValueKind Table::getNumericValue(size_t row, size_t column, double& value) const{
+    if(!isCellInsideTable(row, column)){
+        value = 0;
+        return ValueKind::Empty;
+    }
+    calculateIfDirty(row, column);
+    return columnAt(column).getNumericValue(row, value);
+}
+
+bool Table::gatherColumn(size_t column, size_t fromRow, size_t count, double* values, uint64_t* validity) const{
+    return columnAt(column).gather(fromRow, count, values, validity);
+}
+
+FormulaProgram::Error Table::getFormulaError(size_t row, size_t column) const{
+    if(!isCellInsideTable(row, column)){
+        return FormulaProgram::Error::None;
+    }
+    calculateIfDirty(row, column);
+    const CellFormula* cf = dynamic_cast<const CellFormula*>(columnAt(column).getStoredCell(row));
+    return cf == nullptr ? FormulaProgram::Error::None : cf->errorCode();
+}
+
+FormulaProgram::Error Table::findRangeError(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const{
+    size_t firstRow = std::min(fromRow, toRow);
+    size_t lastRow = std::min(std::max(fromRow, toRow), rowsCount_ - 1);
+    size_t lastColumn = std::min(std::max(fromColumn, toColumn), columns_->size() - 1);
+    if(firstRow > lastRow){
+        return FormulaProgram::Error::None;
+    }
+    calculateDirtyRange(firstRow, std::min(fromColumn, toColumn), lastRow, lastColumn);
+
+    // only cells kept as objects can be formulas
+    for(size_t col = std::min(fromColumn, toColumn); col <= lastColumn; col++){
+        const std::vector<uint64_t>& cells = columnAt(col).cellBits();
+        for(size_t word = firstRow / 64; word <= lastRow / 64 && word < cells.size(); word++){
+            uint64_t bits = cells[word];
+            if(word == firstRow / 64){
+                bits &= ~0ULL << (firstRow % 64);
+            }
+            if(word == lastRow / 64 && lastRow % 64 != 63){
+                bits &= (1ULL << (lastRow % 64 + 1)) - 1;
+            }
+            for(; bits != 0; bits &= bits - 1){
+                const CellFormula* cf = dynamic_cast<const CellFormula*>(columnAt(col).getStoredCell(word * 64 + __builtin_ctzll(bits)));
+                if(cf != nullptr && cf->error()){
+                    return cf->errorCode();
+                }
+            }
+        }
+    }
+    return FormulaProgram::Error::None;
+}
+
+bool Table::gatherNumericValues(size_t fromRow, size_t column, size_t count, double* values) const{
+    std::fill(values, values + count, 0.0);
+    if(column >= columns_->size() || fromRow >= rowsCount_){
+        return true;
+    }
+    // cells outside of the table stay 0
+    count = std::min(count, rowsCount_ - fromRow);
+    calculateDirtyRange(fromRow, column, fromRow + count - 1, column);
+
+    uint64_t validity[GATHER_ROWS / 64];
+    bool error = false;
+    for(size_t done = 0; done < count; done += GATHER_ROWS){
+        size_t part = std::min(GATHER_ROWS, count - done);
+        double* run = values + done;
+        error = gatherColumn(column, fromRow + done, part, run, validity) || error;
+        for(size_t i = 0; i < part; i++){
+            run[i] = ((validity[i >> 6] >> (i & 63)) & 1) ? run[i] : 0.0;
+        }
+    }
+    return !error;
+}
+
+void Table::scanRange(size_t firstRow, size_t firstColumn, size_t lastRow, size_t lastColumn,
+                      AggregateKernels::Summary& summary, bool& error) const{
+    double values[GATHER_ROWS];
+    uint64_t validity[GATHER_ROWS / 64];
+
+    // column by column, so that every kernel call gets a run of consecutive cells
+    for(size_t col = firstColumn; col <= lastColumn; col++){
+        size_t row = firstRow;
+        while(row <= lastRow){
+            // runs end on multiples of GATHER_ROWS, so that typed columns can be read in place
+            size_t count = std::min(GATHER_ROWS - row % GATHER_ROWS, lastRow - row + 1);
+            const double* run;
+            const uint64_t* runValidity;
+            if(columnAt(col).getDoubleRun(row, count, run, runValidity)){
+                AggregateKernels::summarize(run, runValidity, count, summary);
+            }else{
+                error = gatherColumn(col, row, count, values, validity) || error;
+                AggregateKernels::summarize(values, validity, count, summary);
+            }
+            row += count;
+        }
+    }
+}
+
+const AggregateCache* Table::findAggregateCache(size_t column) const{
+    auto cached = aggregateCaches_.find(column);
+    if(cached != aggregateCaches_.end()){
+        return &cached->second;
+    }
+    if(dependencies_->cachedColumns.count(column) == 0){
         return nullptr;
     }
+    size_t blocks = (rowsCount_ + AggregateCache::BLOCK_ROWS - 1) / AggregateCache::BLOCK_ROWS;
+    AggregateCache& cache = aggregateCaches_.emplace(column, AggregateCache(blocks)).first->second;
+    for(size_t block = 0; block < blocks; block++){
+        size_t firstRow = block * AggregateCache::BLOCK_ROWS;
+        AggregateKernels::Summary summary;
+        bool error = false;
+        scanRange(firstRow, column, std::min(firstRow + AggregateCache::BLOCK_ROWS, rowsCount_) - 1, column, summary, error);
+        cache.setBlock(block, summary, error);
+    }
+    return &cache;
+}
+
+Table::RangeAggregate Table::aggregateRange(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const{
+    RangeAggregate res;
+
+    // nothing outside of the table can contribute, so the range is clipped to it
+    size_t firstRow = std::min(fromRow, toRow);
+    size_t firstColumn = std::min(fromColumn, toColumn);
+    size_t lastRow = std::min(std::max(fromRow, toRow), rowsCount_ - 1);
+    size_t lastColumn = std::min(std::max(fromColumn, toColumn), columns_->size() - 1);
+    if(firstRow > lastRow || firstColumn > lastColumn){
+        return res;
+    }
+    calculateDirtyRange(firstRow, firstColumn, lastRow, lastColumn);
+
+    AggregateKernels::Summary summary;
+    if(lastRow - firstRow + 1 < CACHED_RANGE_ROWS){
+        scanRange(firstRow, firstColumn, lastRow, lastColumn, summary, res.error);
+    }else{
+        for(size_t col = firstColumn; col <= lastColumn; col++){
+            const AggregateCache* cache = findAggregateCache(col);
+            if(cache == nullptr){
+                scanRange(firstRow, col, lastRow, col, summary, res.error);
+                continue;
+            }
+            // whole blocks come from the tree, the rows before and after them are read
+            size_t fromBlock = (firstRow + AggregateCache::BLOCK_ROWS - 1) / AggregateCache::BLOCK_ROWS;
+            size_t toBlock = (lastRow + 1) / AggregateCache::BLOCK_ROWS;
+            if(firstRow < fromBlock * AggregateCache::BLOCK_ROWS){
+                scanRange(firstRow, col, fromBlock * AggregateCache::BLOCK_ROWS - 1, col, summary, res.error);
+            }
+            cache->summarize(fromBlock, toBlock - 1, summary, res.error);
+            if(toBlock * AggregateCache::BLOCK_ROWS <= lastRow){
+                scanRange(toBlock * AggregateCache::BLOCK_ROWS, col, lastRow, col, summary, res.error);
+            }
+        }
+    }
+
+    res.sum = summary.sum;
+    res.count = summary.count;
+    if(res.count > 0){
+        res.min = summary.min;
+        res.max = summary.max;
+    }
+
+    return res;
+}
+
+size_t Table::aggregateCachesCount() const{
+    return aggregateCaches_.size();
+}
+
+bool Table::sumProductRanges(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn,
+                             size_t otherRow, size_t otherColumn, double& result) const{
+    result = 0;
+
+    size_t firstRow = std::min(fromRow, toRow);
+    size_t rows = std::max(fromRow, toRow) - firstRow + 1;
+    size_t firstColumn = std::min(fromColumn, toColumn);
+    size_t columns = std::max(fromColumn, toColumn) - firstColumn + 1;
+    calculateDirtyRange(firstRow, firstColumn, firstRow + rows - 1, firstColumn + columns - 1);
+    calculateDirtyRange(otherRow, otherColumn, otherRow + rows - 1, otherColumn + columns - 1);
+
+    double leftValues[GATHER_ROWS];
+    uint64_t leftValidity[GATHER_ROWS / 64];
+    double rightValues[GATHER_ROWS];
+    uint64_t rightValidity[GATHER_ROWS / 64];
+    bool error = false;
+
+    for(size_t col = 0; col < columns; col++){
+        // cells outside of the table are empty, so they add nothing to the result
+        if(firstColumn + col >= columns_->size() || otherColumn + col >= columns_->size()){
+            continue;
+        }
+        for(size_t row = 0; row < rows && firstRow + row < rowsCount_ && otherRow + row < rowsCount_; row += GATHER_ROWS){
+            size_t count = std::min(GATHER_ROWS, rows - row);
+            count = std::min(count, rowsCount_ - (firstRow + row));
+            count = std::min(count, rowsCount_ - (otherRow + row));
+            error = gatherColumn(firstColumn + col, firstRow + row, count, leftValues, leftValidity) || error;
+            error = gatherColumn(otherColumn + col, otherRow + row, count, rightValues, rightValidity) || error;
+            result += AggregateKernels::sumProduct(leftValues, leftValidity, rightValues, rightValidity, count);
+        }
+    }
+
+    return !error;
 }
 
-void Table::getCenteredString(std::string& result, const std::string& value, size_t length, char filling){
+void Table::appendCenteredString(std::string& result, std::string_view value, size_t length, char filling) const{
     if(value.size() > length){
         throw std::invalid_argument("new length cannot be smaller than original length");
 
     }
-    std::string s(length, filling);
-    size_t valueSize = value.size();
-    size_t fillingCount = length - valueSize;
+    size_t fillingCount = length - value.size();
     size_t pos = fillingCount/2;
-    for(size_t i = 0; i < valueSize; i++){
-        s[pos + i] = value[i];
-    }
-    result = s;
+    result.append(pos, filling);
+    result.append(value);
+    result.append(fillingCount - pos, filling);
 }
 
-std::string Table::print(){
+std::string Table::print() const{
+    Trace::Span span("Table::print");
 
-    std::vector<size_t> columnsLength (columnsCount_);
+    calculateDirtyFormulas();
+
+    size_t columnsCount = columns_->size();
+    std::vector<size_t> columnsLength (columnsCount, 1);
+    std::vector<std::string> columnNames (columnsCount);
     std::string output;
+    std::string buffer;
 
     output += "\n";
 
-    for(size_t col = 0; col < columnsCount_; col++){
-        columnsLength.push_back(0);
-        columnsLength[col] = 1;
+    for(size_t col = 0; col < columnsCount; col++){
+        CellRef::appendColumnName(col, columnNames[col]);
+        columnsLength[col] = columnNames[col].size();
         for(size_t row = 0; row < rowsCount_; row++){
-            if(isCellInsideTable(row, col) && table_[row][col] != nullptr){
-                size_t s = table_[row][col]->getDisplayableString().size();
-                if(columnsLength[col] < s)
-                    columnsLength[col] = s;
-            }
+            size_t s = columnAt(col).getDisplayableView(row, buffer).size();
+            if(columnsLength[col] < s)
+                columnsLength[col] = s;
         }
 
         columnsLength[col] += 2;
@@ -240,31 +1293,24 @@ std::string Table::print(){
 
     size_t rowsDigit = std::to_string(rowsCount_).size();
 
-    std::string res;
-    getCenteredString(res, "", rowsDigit, ' ');
-    output += res;
+    appendCenteredString(output, "", rowsDigit, ' ');
 
-    for(size_t col = 0 ; col < columnsCount_; col++){
+    for(size_t col = 0 ; col < columnsCount; col++){
         output += "|";
-        output += " " + std::string(1, (char)('A' + col));
-        getCenteredString(res, "", columnsLength[col]-2, ' ');
-        output += res;
+        output += " ";
+        output += columnNames[col];
+        appendCenteredString(output, "", columnsLength[col] - 1 - columnNames[col].size(), ' ');
     }
 
-    output += (std::string)"|" + "\n";
+    output += "|\n";
 
     for(size_t row = 0 ; row < rowsCount_; row++){
-        std::string res;
-        std::string out = std::to_string(row);
-        getCenteredString(res, out, rowsDigit, ' ');
-        output += res + '|';
-        for(size_t col = 0 ; col < columnsCount_; col++){
-            out = "";
-            if(table_[row][col] != nullptr){
-                out = table_[row][col]->getDisplayableString();
-            }
-            getCenteredString(res, out, columnsLength[col], ' ');
-            output += res + "|";
+        appendCenteredString(output, std::to_string(row), rowsDigit, ' ');
+        output += '|';
+        for(size_t col = 0 ; col < columnsCount; col++){
+            std::string_view out = columnAt(col).getDisplayableView(row, buffer);
+            appendCenteredString(output, out, columnsLength[col], ' ');
+            output += "|";
         }
         output += '\n';
     }
@@ -272,39 +1318,26 @@ std::string Table::print(){
     return output;
 }
 
-size_t Table::rowsCount(){
+size_t Table::rowsCount() const{
     return rowsCount_;
 }
 
-size_t Table::columnsCount(){
-    return columnsCount_;
+size_t Table::columnsCount() const{
+    return columns_->size();
 }
 
 size_t Table::getRow(const std::string& pos){
-    if(pos.size() <= 1){
+    CellRef ref;
+    if(!CellRef::parse(pos, ref)){
         throw std::invalid_argument("Invalid position (column) format.");
     }
-    size_t col = 0;
-    for(size_t i = 1; i < pos.size(); i++){
-        if('0' <= pos[i] && pos[i] <= '9'){
-            col *= 10;
-            col += (pos[i] - '0');
-        }else{
-            throw std::invalid_argument("Invalid position (column) format.");
-        }
-    }
-    return col;
+    return ref.row();
 }
 
 size_t Table::getColumn(const std::string& pos){
-    if(pos.size() < 1){
-        throw std::invalid_argument("Invalid position (row) format.");
-    }
-    if('A' <= pos[0] && pos[0] <= 'Z'){
-        return (pos[0] - 'A');
-    }else if('a' <= pos[0] && pos[0] <= 'z'){
-        return (pos[0] - 'a');
-    }else{
+    CellRef ref;
+    if(!CellRef::parse(pos, ref)){
         throw std::invalid_argument("Invalid position (row) format.");
     }
+    return ref.column();
 }
@@ -2,12 +2,23 @@
 #define TABLE_H
 
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include "Cell.h"
-#include "Cell.h"
+#include "Column.h"
+#include "CellRef.h"
+#include "AggregateCache.h"
+#include "FormulaProgram.h"
 
 /** Table is a class which takes care of a collection of objects of abstract type \ref Cell
- *  Table holds a 2-dimensional dynamic array of pointers to Cell.
+ *  Table holds its cells column by column - \ref Column.
  *  Using polymorphism, it can create objects of any class type which extends the abstract class Cell.
+ *  \n Optionally, integers, floating numbers and strings can be stored as typed values in contiguous arrays
+ *  instead of separate objects - \ref setColumnar. Calculations over columns are then much faster and take less memory.
  *  Currently, only 4 child-classes are being supported:
  *  \li CellInt
  *  \li CellDouble
@@ -24,33 +35,279 @@
  *  \li get direct access to pointer of the appropriate class a cell is created by - \ref getCellPointer
  *  \li prints the entire table this class holds in an appropriate way - \ref print
  *  \li get row and column max count the table has ever reached - \ref rowsCount and \ref columnsCount
+ *  \li switch between storing every cell as an object and storing typed columns - \ref setColumnar
+ *  \li switch between calculating formulas right away and only when they are read - \ref setLazyCalculation
+ *  \n Table knows which formulas refer to which cells. When a cell changes, only the formulas depending
+ *  on it (directly or through other formulas) are calculated again, each one after the formulas it refers to.
+ *  Columns referred to by large ranges keep the summaries of their rows in a tree, updated cell by cell - \ref AggregateCache
+ *  \n Copying a table takes constant time: the copy shares the columns with the original until either of them
+ *  changes a column, which is copied then - \ref operator=. A copy is a consistent snapshot, which another
+ *  thread can read while the original is being changed.
  */
 
+class CellFormula;
+
 class Table{
+public:
+
+    /** What a cell contributes to a calculation - \ref getNumericValue
+     */
+    typedef Column::ValueKind ValueKind;
+
+    /** Summary of every numeric cell inside a rectangular range - \ref aggregateRange
+     */
+    struct RangeAggregate{
+        double sum = 0;
+        double min = 0;
+        double max = 0;
+        size_t count = 0;       /**< count of numeric cells */
+        bool error = false;     /**< at least one cell is a formula with error */
+    };
+
+    /** Rectangular range of cells, fromRow <= toRow and fromColumn <= toColumn.
+     *  A single cell is a range whose corners are equal.
+     */
+    struct Range{
+        size_t fromRow = 0;
+        size_t fromColumn = 0;
+        size_t toRow = 0;
+        size_t toColumn = 0;
+    };
+
 private:
 
-    /** 2-dimensional dynamic array of Cell pointers */
-    Cell*** table_;
+    /** Columns of this table. Every column has exactly \ref rowsCount_ rows.
+     *  \n The list and the columns are shared with copies of the table until they are changed - \ref editColumn.
+     *  Mutable, as formulas calculated when they are read (\ref setLazyCalculation) change their columns.
+     */
+    mutable std::shared_ptr<std::vector<std::shared_ptr<Column>>> columns_;
 
-    /** Allocated count of rows in this table */
+    /** Count of rows in this table */
     size_t rowsCount_;
 
-    /** Allocated count of column in this table */
-    size_t columnsCount_;
+    /** Whether integers, floating numbers and strings are stored as typed values - \ref setColumnar */
+    bool columnar_;
+
+    /** Formula on a range of cells - \ref rangeDependents_ */
+    struct RangeDependent{
+        size_t fromRow;
+        size_t toRow;
+        uint64_t formula;       /**< \ref CellRef::key of the formula */
+    };
+
+    /** What the table knows about the references of its formulas
+     */
+    struct Dependencies{
+        /** For every cell referred to by a formula as a single cell, the formulas which refer to it */
+        std::unordered_map<uint64_t, std::vector<uint64_t>> cellDependents;
+
+        /** For every column, the formulas which refer to ranges containing a part of it */
+        std::unordered_map<size_t, std::vector<RangeDependent>> rangeDependents;
+
+        /** For every formula, the cells and ranges it refers to - \ref CellFormula::collectReferences */
+        std::unordered_map<uint64_t, std::vector<Range>> formulaReferences;
+
+        /** For every column, the count of references to ranges of at least \ref CACHED_RANGE_ROWS rows
+         *  containing a part of it - \ref aggregateCaches_
+         */
+        std::unordered_map<size_t, size_t> cachedColumns;
+    };
+
+    /** Shared with copies of the table until a formula is added or removed - \ref editDependencies */
+    std::shared_ptr<Dependencies> dependencies_;
+
+    /** Whether formulas are calculated only when their values are read - \ref setLazyCalculation */
+    bool lazy_;
+
+    /** Formulas which need to be calculated before their values are read, in lazy mode - \ref setLazyCalculation.
+     *  Ordered column by column (\ref dirtyKey), so that the ones inside a range are found quickly.
+     *  \n Every formula depending on a formula in this set is in the set as well.
+     */
+    mutable std::set<uint64_t> dirty_;
+
+    /** Summaries of the columns in \ref Dependencies::cachedColumns, by column. Every range of a column
+     *  shares the same tree, which is built the first time a large range of the column is asked for,
+     *  and dropped when no formula refers to such a range any more - \ref aggregateRange
+     */
+    mutable std::map<size_t, AggregateCache> aggregateCaches_;
+
+    /** Ranges with fewer rows are read every time, as remembering them would cost more than it saves */
+    static constexpr size_t CACHED_RANGE_ROWS = 1024;
+
+    /** Remembers the references of the formula on position row and column, so that it is
+     *  calculated again when any of them changes
+     */
+    void registerFormula(size_t row, size_t column, const CellFormula& formula);
+
+    /** Forgets the references of the formula on position row and column, if there is such
+     */
+    void unregisterFormula(size_t row, size_t column);
+
+    /** Appends to dependents the \ref CellRef::key of every formula which refers to the cell
+     */
+    void findDependents(CellRef cell, std::vector<uint64_t>& dependents) const;
+
+    /** Appends to precedents the \ref CellRef::key of every formula in \ref dirty_ which the formula
+     *  on the given position refers to
+     */
+    void findDirtyPrecedents(CellRef cell, std::vector<uint64_t>& precedents) const;
+
+    /** Splits the formulas reachable from the given cells into strongly connected components, using Tarjan's
+     *  algorithm without recursion, so that long chains of formulas do not overflow the stack.
+     *  Every component comes after all components reachable from it.
+     *
+     *  \param cells \ref CellRef::key of the cells to start from
+     *  \param dependents whether to follow the formulas depending on a cell (\ref findDependents)
+     *  or the dirty formulas a formula refers to (\ref findDirtyPrecedents)
+     *  \param components receives the \ref CellRef::key of every member of every component
+     *  \param circular receives for every component whether its formulas refer to themselves
+     *  \param levels receives for every component its level: one above the highest level of the components
+     *  reachable from it, 0 if there are none. Components of the same level do not depend on each other.
+     */
+    void findComponents(const std::vector<uint64_t>& cells, bool dependents,
+                        std::vector<std::vector<uint64_t>>& components, std::vector<bool>& circular,
+                        std::vector<size_t>& levels) const;
+
+    /** Calculates every formula of a component, or gives all of them an error if they refer to
+     *  themselves - \ref CellFormula::markCircular
+     *
+     *  \return whether the value of any of the formulas has changed
+     */
+    bool calculateComponent(const std::vector<uint64_t>& component, bool circular) const;
+
+    /** Fewer components are calculated one by one, as grouping them would cost more than it saves - \ref calculateComponents */
+    static constexpr size_t BATCH_COMPONENTS = 64;
 
-    /** Allocates dynamic 2-dimensional array of type Cell pointer (Cell*).
+    /** Calculates components found by \ref findComponents, every one after all components it refers to.
+     *  \n Many components are calculated level by level. Inside a level, formulas filled down a column from the
+     *  same template (\ref CellFormula::Template) are calculated together, a run of consecutive rows at a time -
+     *  \ref FormulaProgram::evaluateRun
      *
-     * \param row allocated new dynamic array's count of rows
-     * \param column allocated new dynamic array's count of columns (count of elements in every row)
-     * \return Pointer to the newly allocated 2-dimensional dynamic array of type Cell*.
-     *  Exception Safety. If an exception occurs, the function handles it and returns nullptr.
+     *  \param components, circular, levels, dependents as given to and received from \ref findComponents
+     *  \param changed if given, only the components holding one of these cells, or a formula referring to one of them,
+     *  are calculated at first. Then the ones referring to a component whose value has changed. Otherwise all of them.
+     */
+    void calculateComponents(const std::vector<std::vector<uint64_t>>& components, const std::vector<bool>& circular,
+                             const std::vector<size_t>& levels, bool dependents,
+                             const std::vector<uint64_t>* changed) const;
+
+    /** Calculates again every formula depending on the given cells (and the given cells themselves if they
+     *  are formulas). Every formula is calculated after all formulas it refers to. Formulas referring to
+     *  themselves, directly or through other formulas, get an error - \ref CellFormula::markCircular
+     *  \n A formula is calculated only if one of the cells it refers to has got a different value.
+     *  Propagation stops at formulas whose value stays the same.
+     *  \n In lazy mode, the formulas are only marked as dirty - \ref setLazyCalculation
+     *
+     *  \param cells \ref CellRef::key of every changed cell
+     */
+    void recalculateDependents(const std::vector<uint64_t>& cells);
+
+    /** \return key of a cell in \ref dirty_ - the column in the upper 32 bits, the row in the lower ones
      */
-    Cell*** allocateTable(std::size_t row, std::size_t column);
+    static uint64_t dirtyKey(size_t row, size_t column);
 
-    /** Release any dynamically allocated memory
-     *  associated with private member: Cell*** tableData
+    /** Calculates the given dirty formulas, each one after the dirty formulas it refers to - \ref setLazyCalculation
+     *
+     *  \param cells \ref CellRef::key of formulas in \ref dirty_
+     */
+    void calculateDirty(const std::vector<uint64_t>& cells) const;
+
+    /** Calculates the formula on position row and column, if it is dirty - \ref setLazyCalculation
+     */
+    void calculateIfDirty(size_t row, size_t column) const;
+
+    /** Calculates every dirty formula inside the range (in any order of the corners) - \ref setLazyCalculation
+     */
+    void calculateDirtyRange(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const;
+
+    /** Updates the remembered summary of the column of a cell, after the cell has changed
+     *
+     *  \param oldKind, oldValue what the cell contributed before the change - \ref getNumericValue
      */
-    void releaseTableData(bool fullDataClear);
+    void cellValueChanged(size_t row, size_t column, ValueKind oldKind, double oldValue) const;
+
+    /** Reads every cell inside the range (already clipped to the table) and adds it to a summary - \ref aggregateRange
+     */
+    void scanRange(size_t firstRow, size_t firstColumn, size_t lastRow, size_t lastColumn,
+                   AggregateKernels::Summary& summary, bool& error) const;
+
+    /** \return the remembered summary of a column, built first if needed.
+     *  nullptr if no formula refers to a large range of the column - \ref Dependencies::cachedColumns
+     */
+    const AggregateCache* findAggregateCache(size_t column) const;
+
+    /** \return the list of columns, copied first if it is shared with a copy of this table
+     */
+    std::vector<std::shared_ptr<Column>>& editColumns() const;
+
+    /** \return the column with the given index, ready to be changed. If it is shared with a copy of this table,
+     *  this table gets a copy of it first. Every change of a column goes through here, so that the copies of
+     *  the table never see it.
+     *  \n Formulas are bound to this table (\ref CellFormula::setTable) only when they are calculated, as they may
+     *  have been copied from a table which does not exist anymore.
+     */
+    Column& editColumn(size_t column) const;
+
+    /** \return \ref dependencies_ ready to be changed, copied first if they are shared with a copy of this table
+     */
+    Dependencies& editDependencies();
+
+    /** Creates an object of the proper type based on the provided string
+     *
+     *  \exception invalid_argument Thrown if provided string does not represent any valid and
+     *  and supported class type
+     *  \return pointer to the newly allocated object. A formula is compiled, but not calculated yet -
+     *  it has an error until it is.
+     */
+    Cell* createCell(const std::string& value);
+
+    /** Stores a new cell - \ref setCellValue and \ref loadCellValue
+     *
+     *  \param calculate whether the new cell and the formulas depending on it are calculated
+     */
+    void storeCellValue(size_t row, size_t column, const std::string& value, bool calculate);
+
+    /** Integer, floating number or string read from the value of a cell - \ref parseTypedValue
+     */
+    struct TypedValue{
+        enum class Kind{
+            Int,
+            Double,
+            String
+        };
+        Kind kind = Kind::String;
+        int64_t intValue = 0;
+        double doubleValue = 0;
+    };
+
+    /** Reads an integer, a floating number or a string, without changing anything
+     *
+     *  \return false if the value is none of them
+     */
+    static bool parseTypedValue(const std::string& value, TypedValue& typed);
+
+    /** Stores a value read by \ref parseTypedValue as a typed value of the column, if the column can take it.
+     *
+     *  \param value the value as it was written, stored as it is if it is a string
+     *  \return false if the value does not fit the column
+     */
+    bool setTypedValue(size_t row, size_t column, const std::string& value, const TypedValue& typed);
+
+    /** Count of cells of one column which \ref aggregateRange and \ref sumProductRanges collect at once
+     *  before passing them to \ref AggregateKernels
+     */
+    static constexpr size_t GATHER_ROWS = 256;
+
+    /** Reads the numeric values of consecutive cells in one column - \ref getNumericValue
+     *
+     *  \param column column to read from
+     *  \param fromRow first row to read
+     *  \param count count of cells to read, up to \ref GATHER_ROWS
+     *  \param values receives the value of every cell
+     *  \param validity receives a bitmap telling which cells hold numbers
+     *  \return whether any of the cells is a formula with error
+     */
+    bool gatherColumn(size_t column, size_t fromRow, size_t count, double* values, uint64_t* validity) const;
 
     /** Extends table up to given new values for rows and columns.
      *  Shrinking is not possible in neither dimension.
@@ -58,19 +315,20 @@ private:
      */
     void extendTable(size_t rows, size_t columns);
 
-    /** Takes a string and centers it based on wanted length and fills the whitespace with a wanted char
+    /** Takes a string, centers it based on wanted length, fills the whitespace with a wanted char
+     *  and appends the result at the end of another string (without creating temporary strings)
      *  \exception invalid_argument thrown if new length is smaller than the length of the string to be centered
-     *  \param result centered string
+     *  \param result string to append the centered string to
      *  \param value string to be centered
      *  \param length new wanted lenth
      *  \param filling what char to fill the whitespace when centering the string
      *  \note example:
      *  \code {.cpp}
-     *  getCenteredString(std::string& result, "some example", 20, '-');
-     *  // result now has this value: "----some example----"
+     *  appendCenteredString(result, "some example", 20, '-');
+     *  // "----some example----" is now appended to result
      *  \endcode
      */
-    void getCenteredString(std::string& result, const std::string& value, size_t length, char filling);
+    void appendCenteredString(std::string& result, std::string_view value, size_t length, char filling) const;
 
 public:
 
@@ -83,11 +341,15 @@ public:
      */
     Table(size_t rows, size_t cols);
 
-    /** Operator= which created perfect copy (with copied allocated memory) of an object
+    /** Operator= which makes this table a copy of the other one, in time proportional only to the count of
+     *  dirty formulas (\ref setLazyCalculation). Both tables share their columns, and a column is copied only
+     *  when one of the tables changes it - \ref editColumn.
+     *  \n The copy can be read by another thread while the other table is being changed, as a snapshot of it.
+     *  Only copying must not happen at the same time as changing the other table.
      */
     Table& operator=(const Table& other);
 
-    /** Copy constructor which created perfect copy (with copied allocated memory) of an object
+    /** Copy constructor, which shares the columns of the copied table - \ref operator=
      */
     Table(const Table& copy);
 
@@ -100,12 +362,14 @@ public:
     bool isCellInsideTable(size_t row, size_t column) const;
 
     /** Find all allocated objects of type \ref CellFormula and calls its public member fucntion
-     *  \ref recalculate
+     *  \ref recalculate. Every formula is calculated after the formulas it refers to.
+     *  In lazy mode, every formula is only marked as dirty - \ref setLazyCalculation
      */
     void recalculateAllFormulas();
 
     /** Creates a new dynamically allocated cell of proper type based on the provided string and
-     *  associates it with 2-dimensional coordinates, respectively row and column
+     *  associates it with 2-dimensional coordinates, respectively row and column.
+     *  Then calculates again the formulas depending on this cell.
      *
      *  \exception invalid_argument Thrown if provided string does not represent any valid and
      *  and supported class type
@@ -115,17 +379,91 @@ public:
      */
     void setCellValue(size_t row, size_t column, const std::string& value);
 
-    /** Deletes any allocated dynamic memory associated by a cell on the provided row and column
+    /** Same as \ref setCellValue, but nothing is calculated. A new formula has an error until it is
+     *  calculated - \ref recalculateAllFormulas - or gets a remembered result - \ref restoreFormulaResult
+     *  \n Used when a whole table is read from a file: every formula is then calculated only once,
+     *  after all cells are read, and after the formulas it refers to.
+     *
+     *  \exception invalid_argument the same as \ref setCellValue
+     */
+    void loadCellValue(size_t row, size_t column, const std::string& value);
+
+    /** Sets the result of the formula on position row and column without calculating it - \ref CellFormula::restoreResult
+     *
+     *  \return false if there's no formula on this position
+     */
+    bool restoreFormulaResult(size_t row, size_t column, double result, FormulaProgram::Error error);
+
+    /** \return count of formulas in this table
+     */
+    size_t formulasCount() const;
+
+    /** Counts the memory this table takes: cells of every type, texts of strings and formulas, compiled
+     *  formulas, the columns, what the table knows about dependencies between cells, and its caches.
+     *  Takes time proportional to the count of cells. Formulas which are not calculated yet stay so.
+     *
+     *  \return bytes of every part - \ref MemoryUsage
+     */
+    MemoryUsage memoryUsage() const;
+
+    /** Deletes any allocated dynamic memory associated by a cell on the provided row and column.
+     *  Then calculates again the formulas depending on this cell.
      *
      *  \param wanted position (row and column)
      */
     void deleteCellValue(size_t row, size_t column);
 
+    /** Copies the cell on position sourceRow and sourceColumn into every cell of a range (2 corners in any order),
+     *  except for the source cell itself.
+     *  \n A formula is not copied as text: every copy shares its compiled template and only remembers how far it is
+     *  from it, so its references are moved by that distance (e.g. "=A1*B1" copied 1 row down is "=A2*B2") -
+     *  \ref CellFormula::Template. Other values are copied as they are, an empty source empties the range.
+     *  \n The formulas depending on the range are calculated once, after all cells are copied.
+     */
+    void fill(size_t sourceRow, size_t sourceColumn, size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn);
+
     /** Deletes any allocated dynamic memory associated by this class. Automatically sets the
      *  table to size 1x1 and ensures it can still be used right after this command is called
      */
     void resetTable();
 
+    /** Chooses how integers, floating numbers and strings are stored. Cells already in the table
+     *  are converted to the new way.
+     *  \li false (default) - every cell is a separate object of a class extending \ref Cell
+     *  \li true - they are stored as typed values in contiguous arrays, one array per column.
+     *  A value which does not match the type of its column, as well as every formula, is still stored as an object.
+     *  \n Either way the table behaves the same. Pointers to cells of typed columns returned by
+     *  \ref getCellPointer are valid until the cell is changed or the table is copied.
+     */
+    void setColumnar(bool columnar);
+
+    /** \return whether integers, floating numbers and strings are stored as typed values - \ref setColumnar
+     */
+    bool isColumnar() const;
+
+    /** Chooses when formulas are calculated.
+     *  \li false (default) - right away, whenever a cell they depend on changes
+     *  \li true - a change only marks the formulas depending on the cell as dirty. A dirty formula is calculated
+     *  when its value is read (by \ref getDisplayableCellValue, \ref print, another formula...), and its result is
+     *  remembered until a cell it depends on changes again.
+     *  \n Either way the same values are read. Switching back to false calculates every dirty formula.
+     */
+    void setLazyCalculation(bool lazy);
+
+    /** \return whether formulas are calculated only when their values are read - \ref setLazyCalculation
+     */
+    bool isLazyCalculation() const;
+
+    /** Calculates every dirty formula - \ref setLazyCalculation. Used before all results are read at once,
+     *  e.g. when the table is written to a file.
+     */
+    void calculateDirtyFormulas() const;
+
+    /** \return whether any formula waits to be calculated - \ref setLazyCalculation. Reading the table
+     *  changes it only while there are such formulas.
+     */
+    bool hasDirtyFormulas() const;
+
     /** Tries to get the displayable value of a cell on position row and column.
      *  If found, returns it. If not, returns empty string.
      */
@@ -136,32 +474,119 @@ public:
      */
     std::string getConstructedCellValue(size_t row, size_t column);
 
+    /** Non-allocating version of \ref getDisplayableCellValue - \ref Cell::getDisplayableView
+     *  If the cell is not found, returns empty view.
+     */
+    std::string_view getDisplayableCellView(size_t row, size_t column, std::string& buffer) const;
+
+    /** Non-allocating version of \ref getConstructedCellValue - \ref Cell::getConstructView
+     *  If the cell is not found, returns empty view.
+     */
+    std::string_view getConstructedCellView(size_t row, size_t column, std::string& buffer) const;
+
+    /** Reads the value of a cell on position row and column as a floating number.
+     *  Only cells of kind \ref ValueKind::Number set the value, for any other kind it becomes 0.
+     *
+     *  \param value receives the numeric value of the cell
+     *  \return kind of the cell
+     */
+    ValueKind getNumericValue(size_t row, size_t column, double& value) const;
+
+    /** Walks every cell inside the rectangle between the 2 corners (inclusive, in any order)
+     *  in a single pass and summarizes the numeric ones. Cells outside the table count as empty.
+     *  \n Every column is read in runs of consecutive cells, which are summarized by the vectorized
+     *  \ref AggregateKernels
+     *  \n Columns which formulas refer to by large ranges keep the summaries of their rows up to date while
+     *  cells change, so a large range of them costs O(log n) - \ref AggregateCache
+     */
+    RangeAggregate aggregateRange(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const;
+
+    /** \return count of columns whose summaries are remembered - \ref aggregateRange
+     */
+    size_t aggregateCachesCount() const;
+
+    /** \return error of the formula on position row and column - \ref FormulaProgram::Error.
+     *  Error::None if it has no error, or if there's no formula.
+     */
+    FormulaProgram::Error getFormulaError(size_t row, size_t column) const;
+
+    /** \return error of the first formula with error inside the range (2 corners in any order), column by column.
+     *  Error::None if there's none.
+     */
+    FormulaProgram::Error findRangeError(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn) const;
+
+    /** Reads the numeric values of consecutive cells of one column, as \ref getNumericValue reads each of them:
+     *  cells which do not hold numbers, as well as cells outside the table, are 0.
+     *
+     *  \param fromRow, column first cell to read
+     *  \param count count of cells to read
+     *  \param values receives the value of every cell
+     *  \return false if any of the cells is a formula with error
+     */
+    bool gatherNumericValues(size_t fromRow, size_t column, size_t count, double* values) const;
+
+    /** Multiplies the numeric values of 2 ranges of equal size cell by cell and sums the products.
+     *  A pair of cells counts only if both cells hold numbers.
+     *
+     *  \param fromRow, fromColumn, toRow, toColumn 2 corners of the first range (in any order)
+     *  \param otherRow, otherColumn top left corner of the second range
+     *  \param result receives the sum of the products
+     *  \return false if any of the cells in either range is a formula with error
+     */
+    bool sumProductRanges(size_t fromRow, size_t fromColumn, size_t toRow, size_t toColumn,
+                          size_t otherRow, size_t otherColumn, double& result) const;
+
     /** Tries to find the cell on position row and column.
      *  If found, returns its pointer. If not, returns null pointer.
      */
-    const Cell* getCellPointer(size_t row, size_t column) const;
+    const Cell* getCellPointer(size_t row, size_t column);
+
+    /** Version of \ref getCellPointer which changes nothing if the cell is calculated (\ref setLazyCalculation),
+     *  so several threads may call it at once. The Cell object of a typed value is created into the buffer -
+     *  \ref Column::getCellPointer
+     */
+    const Cell* getCellPointer(size_t row, size_t column, std::unique_ptr<Cell>& buffer) const;
+
+    /** \return the column with the given index, which must be inside the table. Gives direct access to
+     *  typed values, e.g. for writing them to files - \ref BinaryWorkbook
+     */
+    const Column& columnAt(size_t column) const;
+
+    /** Replaces every cell of the table at once, e.g. with columns read from a file.
+     *  Formulas are bound to this table and their references are remembered, but they are not
+     *  calculated again - their results are expected to be up to date.
+     *
+     *  \exception invalid_argument thrown if rows count or columns count is zero
+     *  \param columns new columns, every one with exactly rows rows. Their cells are moved into the table
+     *  and the vector is emptied.
+     *  \param rows count of rows
+     */
+    void assignColumns(std::vector<Column>& columns, size_t rows);
 
     /** \return The entire table gets convented into a string, which can be displayed.
      *  The string represents the current table formatted in a readable way.
      *  Takes the displayable string of all existing cells in this class
      */
-    std::string print();
+    std::string print() const;
 
     /** \return Count of rows in this this table
      */
-    size_t rowsCount();
+    size_t rowsCount() const;
 
     /** \return Count of columns in this this table
      */
-    size_t columnsCount();
+    size_t columnsCount() const;
 
     /** Static function, which takes a typical excel representation of a position of a cell
      *  and returns the row it actually refers to as a positive integer.
+     *  \n When both the row and the column are needed, \ref CellRef::parse reads the position only once.
+     *  \exception invalid_argument not a valid position - \ref CellRef
      */
     static size_t getRow(const std::string& pos);
 
     /** Static function, which takes a typical excel representation of a position of a cell
-     *  and returns the column it actually refers to as a positive integer.
+     *  (e.g. A0, AB12, XFD1) and returns the column it actually refers to as a positive integer.
+     *  \exception invalid_argument not a valid position - \ref CellRef
      */
     static size_t getColumn(const std::string& pos);
 
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads){
+    threads = std::max((size_t)1, threads);
+    for(size_t i = 0; i < threads; i++){
+        threads_.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for(std::thread& thread : threads_){
+        thread.join();
+    }
+}
+
+void ThreadPool::work(){
+    while(true){
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this](){ return stopping_ || !tasks_.empty(); });
+            // the submitted tasks are finished before the pool stops
+            if(tasks_.empty()){
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        try{
+            task();
+        }catch(std::exception& e){
+            std::cerr << "Task failed: " << e.what() << "\n";
+        }
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    available_.notify_one();
+}
+
+size_t ThreadPool::size() const{
+    return threads_.size();
+}
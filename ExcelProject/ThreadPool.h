@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** ThreadPool runs tasks on a fixed count of threads, in the order they were submitted - \ref submit
+ *  \n Tasks should not throw: an exception leaving a task is caught and written to the standard error.
+ *  The destructor waits for every submitted task to finish.
+ */
+class ThreadPool{
+private:
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+
+    /** Runs tasks until the pool is destroyed
+     */
+    void work();
+
+public:
+
+    /** \param threads count of threads, at least 1
+     */
+    explicit ThreadPool(size_t threads);
+
+    /** Waits for every submitted task to finish
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Adds a task, which is run by the first free thread
+     */
+    void submit(std::function<void()> task);
+
+    /** \return count of threads
+     */
+    size_t size() const;
+
+};
+
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <fstream>
+
+#include "Trace.h"
+
+std::atomic<bool> Trace::enabled_(false);
+std::mutex Trace::mutex_;
+std::vector<Trace::Event> Trace::events_;
+std::chrono::steady_clock::time_point Trace::start_;
+
+namespace{
+
+void appendEscaped(const std::string& text, std::string& result){
+    for(char c : text){
+        if(c == '"' || c == '\\'){
+            result += '\\';
+            result += c;
+        }else if((unsigned char)c < 0x20){
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        }else{
+            result += c;
+        }
+    }
+}
+
+}
+
+Trace::Span::Span(const char* name) : active_(enabled()){
+    if(active_){
+        event_.name = name;
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+Trace::Span::~Span(){
+    if(!active_){
+        return;
+    }
+    event_.thread = threadNumber();
+    record(std::move(event_), start_, std::chrono::steady_clock::now());
+}
+
+void Trace::Span::argument(const char* name, uint64_t value){
+    if(active_){
+        event_.arguments.emplace_back(name, std::to_string(value));
+    }
+}
+
+void Trace::Span::argument(const char* name, const std::string& value){
+    if(active_){
+        std::string json = "\"";
+        appendEscaped(value, json);
+        json += '"';
+        event_.arguments.emplace_back(name, json);
+    }
+}
+
+void Trace::record(Event&& event, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end){
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a span which started before tracing was restarted belongs to no trace
+    if(!enabled() || start < start_){
+        return;
+    }
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - start_).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    events_.push_back(std::move(event));
+}
+
+uint32_t Trace::threadNumber(){
+    static std::atomic<uint32_t> threads(0);
+    thread_local uint32_t number = ++threads;
+    return number;
+}
+
+void Trace::start(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    start_ = std::chrono::steady_clock::now();
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+size_t Trace::stop(const std::string& filename){
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!enabled()){
+            throw std::invalid_argument("Tracing was not started. ");
+        }
+        enabled_.store(false, std::memory_order_relaxed);
+        events.swap(events_);
+    }
+
+    std::ofstream writeFile(filename, std::ios::trunc);
+    if(writeFile.fail()){
+        throw std::invalid_argument("Unexpected error while opening file " + filename + ". ");
+    }
+    // complete events ("X") with times in microseconds
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char number[64];
+    for(size_t i = 0; i < events.size(); i++){
+        const Event& event = events[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "{\"name\":\"";
+        appendEscaped(event.name, json);
+        std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                      event.thread, event.start / 1000.0, event.duration / 1000.0);
+        json += number;
+        if(!event.arguments.empty()){
+            json += ",\"args\":{";
+            for(size_t j = 0; j < event.arguments.size(); j++){
+                json += j == 0 ? "\"" : ",\"";
+                json += event.arguments[j].first;
+                json += "\":";
+                json += event.arguments[j].second;
+            }
+            json += '}';
+        }
+        json += '}';
+        if(json.size() > (1 << 20)){
+            writeFile << json;
+            json.clear();
+        }
+    }
+    json += "\n]}\n";
+    writeFile << json;
+    writeFile.close();
+    if(writeFile.fail()){
+        throw std::invalid_argument("Unexpected error while writing file " + filename + ". ");
+    }
+    return events.size();
+}
@@ -0,0 +1,109 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** Trace records what the program was doing and when: spans of time named by the operation (e.g. a command,
+ *  \ref Table::setCellValue, a pass of calculating formulas, one formula), which are written as a file of
+ *  the Chrome trace event format - \ref stop. The file can be opened by chrome://tracing or
+ *  https://ui.perfetto.dev, where the spans of every thread are drawn inside of each other on a timeline,
+ *  e.g. to find the formulas which take most of the time of a recalculation.
+ *  \n Tracing is off unless it was started - \ref start. While it is off, a span costs one check of
+ *  a flag: nothing is allocated and the clock is not read.
+ *  \n Spans are recorded by creating a \ref Span at the start of the operation, it ends with its scope:
+ *  \code
+ *  Trace::Span span("Table::print");
+ *  \endcode
+ */
+class Trace{
+public:
+
+    /** One recorded span, in the order of their ends
+     */
+    struct Event{
+        const char* name;
+        uint64_t start;         /**< nanoseconds since tracing was started */
+        uint64_t duration;      /**< nanoseconds */
+        uint32_t thread;        /**< small number of the thread which recorded it, from 1 */
+        /** name and value of every argument, the values are already written as JSON */
+        std::vector<std::pair<const char*, std::string>> arguments;
+    };
+
+    /** A span of time from its creation to its destruction. Arguments give details (e.g. which cell),
+     *  they are kept only if tracing is on - \ref active
+     */
+    class Span{
+        bool active_;
+        Event event_;
+        std::chrono::steady_clock::time_point start_;
+    public:
+        /** \param name name of the operation, has to live until the trace is written (e.g. a string literal)
+         */
+        explicit Span(const char* name);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        /** \return whether the span is recorded, so that arguments need to be prepared
+         */
+        bool active() const{
+            return active_;
+        }
+
+        /** Adds a numeric argument
+         */
+        void argument(const char* name, uint64_t value);
+
+        /** Adds a text argument
+         */
+        void argument(const char* name, const std::string& value);
+    };
+
+private:
+
+    static std::atomic<bool> enabled_;
+    static std::mutex mutex_;
+    static std::vector<Event> events_;
+    static std::chrono::steady_clock::time_point start_;
+
+    /** Keeps a finished span, with its times relative to the start of tracing
+     */
+    static void record(Event&& event, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+
+    /** \return the number of the calling thread
+     */
+    static uint32_t threadNumber();
+
+public:
+
+    /** \return whether spans are being recorded
+     */
+    static bool enabled(){
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /** Starts recording spans, forgets the ones recorded before
+     */
+    static void start();
+
+    /** Stops recording spans and writes them to a file. Spans which have not ended yet are not written.
+     *
+     *  \exception invalid_argument tracing was not started
+     *  \exception invalid_argument the file cannot be written
+     *  \return count of the written spans
+     */
+    static size_t stop(const std::string& filename);
+
+};
+
+
+#endif // TRACE_H
@@ -1,10 +1,19 @@
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "Table.h"
 #include "Cell.h"
 #include "CellInt.h"
 #include "CellString.h"
 #include "ControlCenter.h"
+#include "ScriptRunner.h"
+#include "Server.h"
 
 std::string stringToUpper(const std::string& str){
     std::string res(str);
@@ -17,8 +26,151 @@ std::string stringToUpper(const std::string& str){
 
 }
 
-int main()
+void printUsage(){
+    std::cerr << "Usage: ExcelProject                 interactive mode\n"
+              << "       ExcelProject [options] --script FILE   runs the commands of a file (- for the standard input)\n"
+              << "       ExcelProject [options] -c COMMAND...   runs the given commands\n"
+              << "       ExcelProject [options] --server SOCKET  serves sessions connecting to a Unix domain socket\n"
+              << "  --overwrite ask|always|never   replacing existing files (never)\n"
+              << "  --keep-going                   continue after a failed command\n"
+              << "  --quiet                        write only the failures\n"
+              << "  --threads N                    threads executing commands of the server (count of cores)\n"
+              << "Exit code is 0 if every command succeeded, 1 if any failed, 2 for invalid arguments.\n";
+}
+
+/** Server stopped by the signals, null while none is running. Atomic, so that the signal handler reads it whole. */
+std::atomic<Server*> runningServer(nullptr);
+
+void stopServer(int){
+    Server* server = runningServer;
+    if(server != nullptr){
+        server->stop();
+    }
+}
+
+/** Makes SIGINT and SIGTERM stop a server while it exists. The default handlers are restored before
+ *  the server is destroyed, so that no signal reaches a destroyed server.
+ */
+class StopOnSignals{
+public:
+    StopOnSignals(Server& server){
+        runningServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+    }
+
+    ~StopOnSignals(){
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        runningServer = nullptr;
+    }
+
+    StopOnSignals(const StopOnSignals&) = delete;
+    StopOnSignals& operator=(const StopOnSignals&) = delete;
+};
+
+/** Serves sessions until the process is interrupted - \ref Server
+ */
+int runServer(const Server::Options& options){
+    try{
+        Server server(options);
+        // created after the server, so it is destroyed first - also if anything below throws
+        StopOnSignals stopOnSignals(server);
+        std::cout << "Serving on " << options.socketPath << " with " << options.threads << " threads" << std::endl;
+        server.run();
+        std::cout << "Server stopped" << std::endl;
+        return 0;
+    }catch(std::invalid_argument& e){
+        std::cerr << "FAIL: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+/** Runs commands given by the arguments without asking anything - \ref ScriptRunner
+ */
+int runBatch(int argc, char* argv[]){
+    ScriptRunner::Options options;
+    ControlCenter::Overwrite overwrite = ControlCenter::Overwrite::Never;
+    std::string script;
+    std::vector<std::string> commands;
+    Server::Options serverOptions;
+    serverOptions.threads = std::max(1u, std::thread::hardware_concurrency());
+    for(int i = 1; i < argc; i++){
+        std::string name = argv[i];
+        if(name == "--help"){
+            printUsage();
+            return 0;
+        }else if(name == "--keep-going"){
+            options.keepGoing = true;
+        }else if(name == "--quiet"){
+            options.quiet = true;
+        }else if(i + 1 >= argc){
+            printUsage();
+            return 2;
+        }else if(name == "--script"){
+            script = argv[++i];
+        }else if(name == "-c"){
+            commands.push_back(argv[++i]);
+        }else if(name == "--server"){
+            serverOptions.socketPath = argv[++i];
+        }else if(name == "--threads" && std::atoi(argv[i + 1]) > 0){
+            serverOptions.threads = std::atoi(argv[++i]);
+        }else if(name == "--overwrite" && stringToUpper(argv[i + 1]) == "ASK"){
+            overwrite = ControlCenter::Overwrite::Ask;
+            i++;
+        }else if(name == "--overwrite" && stringToUpper(argv[i + 1]) == "ALWAYS"){
+            overwrite = ControlCenter::Overwrite::Always;
+            i++;
+        }else if(name == "--overwrite" && stringToUpper(argv[i + 1]) == "NEVER"){
+            overwrite = ControlCenter::Overwrite::Never;
+            i++;
+        }else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(!serverOptions.socketPath.empty()){
+        if(!script.empty() || !commands.empty()){
+            printUsage();
+            return 2;
+        }
+        serverOptions.overwrite = overwrite;
+        return runServer(serverOptions);
+    }
+    if(script.empty() == commands.empty()){
+        printUsage();
+        return 2;
+    }
+
+    // results are written in large blocks instead of line by line
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    ControlCenter cc;
+    cc.setOverwrite(overwrite);
+    ScriptRunner runner(cc, options);
+    size_t failed = 0;
+    if(!commands.empty()){
+        failed = runner.run(commands, std::cout, std::cerr);
+    }else if(script == "-"){
+        failed = runner.run(std::cin, std::cout, std::cerr);
+    }else{
+        std::ifstream file(script);
+        if(!file.is_open()){
+            std::cerr << "FAIL: Script " << script << " not found.\n";
+            return 1;
+        }
+        failed = runner.run(file, std::cout, std::cerr);
+    }
+    std::cout.flush();
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
 {
+    if(argc > 1){
+        return runBatch(argc, argv);
+    }
 
     std::string input;
 
@@ -26,8 +178,11 @@ int main()
     getline(std::cin, input);
 
     ControlCenter cc;
+    // saving large tables does not keep the user waiting
+    cc.setBackgroundSaving(true);
 
-    while(stringToUpper(input) != "EXIT"){
+    // the end of the standard input ends the program as well
+    while(std::cin && stringToUpper(input) != "EXIT"){
 
         try{
             if(input != ""){
@@ -45,6 +200,7 @@ int main()
         getline(std::cin, input);
     }
 
+    cc.waitForSaves();
     std::cout << "\nSuccessfully exited\n";
 
     return 0;
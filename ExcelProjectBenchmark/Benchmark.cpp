@@ -0,0 +1,229 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "../ExcelProject/Table.h"
+#include "../ExcelProject/ControlCenter.h"
+#include "../ExcelProject/ResultSidecar.h"
+#include "../ExcelProject/SheetGenerator.h"
+#include "../ExcelProject/Trace.h"
+
+/** Measures the main operations of the table on a generated one - \ref SheetGenerator.
+ *  Every benchmark is run several times and written as one line of JSON (JSON Lines) to the standard output,
+ *  so results of different versions can be compared by a script:
+ *
+ *  {"benchmark":"csv_load","rows":20000,"columns":10,"seed":1,"storage":"cells","calculation":"eager",
+ *   "repeat":5,"items":200000,"min_ns":...,"median_ns":...,"mean_ns":...,"max_ns":...}
+ *
+ *  items is the count of cells (or edits for set_cell_value) a run handles.
+ *  Run with --help for the options.
+ */
+
+namespace{
+
+struct Settings{
+    SheetGenerator::Options sheet;
+    size_t repeat = 5;
+    size_t edits = 1000;
+    bool columnar = false;
+    bool lazy = false;
+    std::string filter;
+    std::string directory = ".";
+    std::string trace;
+};
+
+void printUsage(){
+    std::cerr << "Usage: ExcelProjectBenchmark [options]\n"
+              << "  --rows N, --columns N       size of the generated table (20000 x 10)\n"
+              << "  --integers X, --doubles X, --strings X, --formulas X, --empty X\n"
+              << "                              shares of the cell types (3, 3, 1, 2, 1)\n"
+              << "  --seed N                    seed of the generated table (1)\n"
+              << "  --repeat N                  runs of every benchmark (5)\n"
+              << "  --edits N                   cells changed by one run of set_cell_value (1000)\n"
+              << "  --storage cells|columnar    storage of the table (cells)\n"
+              << "  --calculation eager|lazy    calculation of the formulas (eager)\n"
+              << "  --filter TEXT               run only benchmarks whose names contain the text\n"
+              << "  --directory PATH            where the CSV files are written, without spaces (.)\n"
+              << "  --trace FILE.json           writes what the measured runs did as a Chrome trace\n";
+}
+
+/** \exception invalid_argument not a number
+ */
+double parseNumber(const std::string& name, const std::string& value){
+    char* end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if(value.empty() || *end != '\0' || number < 0){
+        throw std::invalid_argument("Invalid value of " + name + ": " + value);
+    }
+    return number;
+}
+
+/** \exception invalid_argument unknown option or invalid value
+ */
+Settings parseSettings(int argc, char* argv[]){
+    Settings settings;
+    settings.sheet.rows = 20000;
+    settings.sheet.columns = 10;
+    for(int i = 1; i < argc; i++){
+        std::string name = argv[i];
+        if(name == "--help"){
+            printUsage();
+            std::exit(0);
+        }
+        if(i + 1 >= argc){
+            throw std::invalid_argument("Missing value of " + name);
+        }
+        std::string value = argv[++i];
+        if(name == "--rows"){
+            settings.sheet.rows = parseNumber(name, value);
+        }else if(name == "--columns"){
+            settings.sheet.columns = parseNumber(name, value);
+        }else if(name == "--integers"){
+            settings.sheet.integers = parseNumber(name, value);
+        }else if(name == "--doubles"){
+            settings.sheet.doubles = parseNumber(name, value);
+        }else if(name == "--strings"){
+            settings.sheet.strings = parseNumber(name, value);
+        }else if(name == "--formulas"){
+            settings.sheet.formulas = parseNumber(name, value);
+        }else if(name == "--empty"){
+            settings.sheet.empty = parseNumber(name, value);
+        }else if(name == "--seed"){
+            settings.sheet.seed = std::strtoull(value.c_str(), nullptr, 10);
+        }else if(name == "--repeat"){
+            settings.repeat = std::max(1.0, parseNumber(name, value));
+        }else if(name == "--edits"){
+            settings.edits = parseNumber(name, value);
+        }else if(name == "--storage" && (value == "cells" || value == "columnar")){
+            settings.columnar = value == "columnar";
+        }else if(name == "--calculation" && (value == "eager" || value == "lazy")){
+            settings.lazy = value == "lazy";
+        }else if(name == "--filter"){
+            settings.filter = value;
+        }else if(name == "--directory"){
+            settings.directory = value;
+        }else if(name == "--trace"){
+            settings.trace = value;
+        }else{
+            throw std::invalid_argument("Unknown option " + name + " " + value);
+        }
+    }
+    return settings;
+}
+
+/** Runs a benchmark settings.repeat times and writes its line of results. prepare is called before every run
+ *  and is not measured. Anything the table writes to the standard output meanwhile is dropped.
+ */
+void run(const Settings& settings, const std::string& name, size_t items,
+         const std::function<void()>& prepare, const std::function<void()>& measured){
+    if(name.find(settings.filter) == std::string::npos){
+        return;
+    }
+    std::vector<double> times;
+    for(size_t i = 0; i < settings.repeat; i++){
+        std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        {
+            Trace::Span span("benchmark");
+            span.argument("benchmark", name);
+            measured();
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout.rdbuf(coutBuffer);
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for(double time : times){
+        sum += time;
+    }
+
+    const SheetGenerator::Options& sheet = settings.sheet;
+    std::printf("{\"benchmark\":\"%s\",\"rows\":%zu,\"columns\":%zu,\"seed\":%llu,\"storage\":\"%s\",\"calculation\":\"%s\","
+                "\"repeat\":%zu,\"items\":%zu,\"min_ns\":%.0f,\"median_ns\":%.0f,\"mean_ns\":%.0f,\"max_ns\":%.0f}\n",
+                name.c_str(), sheet.rows, sheet.columns, (unsigned long long)sheet.seed,
+                settings.columnar ? "columnar" : "cells", settings.lazy ? "lazy" : "eager",
+                times.size(), items, times.front(), times[times.size() / 2], sum / times.size(), times.back());
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char* argv[]){
+    Settings settings;
+    try{
+        settings = parseSettings(argc, argv);
+        SheetGenerator generator(settings.sheet);
+        if(!settings.trace.empty()){
+            Trace::start();
+        }
+        const size_t cells = settings.sheet.rows * settings.sheet.columns;
+        const std::string input = settings.directory + "/benchmark_input.csv";
+        const std::string output = settings.directory + "/benchmark_output.csv";
+        auto nothing = [](){};
+
+        Table table;
+        table.setColumnar(settings.columnar);
+        table.setLazyCalculation(settings.lazy);
+        run(settings, "generate", cells, nothing, [&](){ generator.fill(table); });
+        generator.fill(table);
+        generator.writeCsv(input);
+
+        ControlCenter cc;
+        cc.executeCommand(settings.columnar ? "STORAGE columnar" : "STORAGE cells");
+        cc.executeCommand(settings.lazy ? "CALCULATION lazy" : "CALCULATION eager");
+        // without the results saved next to it, every formula is calculated while loading
+        auto forgetResults = [&](){
+            ResultSidecar::remove(input);
+        };
+        run(settings, "csv_load", cells, forgetResults, [&](){ cc.executeCommand("OPEN " + input); });
+        auto removeOutput = [&](){
+            cc.executeCommand("OPEN " + input);
+            std::remove(output.c_str());
+            ResultSidecar::remove(output);
+        };
+        run(settings, "csv_save", cells, removeOutput, [&](){ cc.executeCommand("SAVEAS " + output); });
+
+        // every edit is followed by calculating the formulas depending on the changed cell
+        Table edited;
+        size_t round = 0;
+        edited.setColumnar(settings.columnar);
+        edited.setLazyCalculation(settings.lazy);
+        auto fillTable = [&](){
+            // a copy of table would share its columns, which the measured edits would copy
+            generator.fill(edited);
+            round++;
+        };
+        run(settings, "set_cell_value", settings.edits, fillTable, [&](){
+            for(size_t i = 0; i < settings.edits; i++){
+                size_t row = (i * 7919 + round) % settings.sheet.rows;
+                edited.setCellValue(row, i % settings.sheet.columns, std::to_string(i + round));
+            }
+            edited.calculateDirtyFormulas();
+        });
+
+        run(settings, "recalculate", table.formulasCount(), nothing, [&](){ table.recalculateAllFormulas(); });
+        std::string printed;
+        run(settings, "print", cells, nothing, [&](){ printed = table.print(); });
+        run(settings, "table_copy", cells, nothing, [&](){ Table copy(table); });
+        if(!settings.trace.empty()){
+            Trace::stop(settings.trace);
+        }
+
+        std::remove(input.c_str());
+        std::remove(output.c_str());
+        ResultSidecar::remove(input);
+        ResultSidecar::remove(output);
+    }catch(std::invalid_argument& e){
+        std::cerr << "FAIL: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    return 0;
+}
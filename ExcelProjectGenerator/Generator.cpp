@@ -0,0 +1,116 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "../ExcelProject/SheetGenerator.h"
+
+/** Writes a generated CSV workbook (\ref SheetGenerator) of any size, from a few cells to hundreds of millions,
+ *  e.g. to reproduce a benchmark or a slow workbook without the original data. The same options always
+ *  give the same file. Run with --help for the options.
+ */
+
+namespace{
+
+void printUsage(){
+    std::cerr << "Usage: ExcelProjectGenerator --output FILE.csv [options]\n"
+              << "  --rows N, --columns N       size of the table (1000 x 10)\n"
+              << "  --cells N                   size of the table as a count of cells, rows are calculated\n"
+              << "  --integers X, --doubles X, --strings X, --formulas X, --empty X\n"
+              << "                              shares of the cell types (3, 3, 1, 2, 1)\n"
+              << "  --seed N                    seed (1)\n"
+              << "  --distinct-strings N        count of different strings (1000)\n"
+              << "  --references N              cells an arithmetic formula refers to (2)\n"
+              << "  --ranges X                  part of formulas summarizing a range, 0 to 1 (0.5)\n"
+              << "  --range-rows N              most rows of such a range (16)\n"
+              << "  --chain-depth N             longest chain of formulas referring to the one above (8)\n"
+              << "  --shared-cells N            cells of the first row referred to by many formulas (0)\n"
+              << "  --shared-references X       part of references to those cells, 0 to 1 (0.1)\n";
+}
+
+/** \exception invalid_argument not a number
+ */
+double parseNumber(const std::string& name, const std::string& value){
+    char* end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if(value.empty() || *end != '\0' || number < 0){
+        throw std::invalid_argument("Invalid value of " + name + ": " + value);
+    }
+    return number;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    SheetGenerator::Options options;
+    std::string output;
+    double cells = 0;
+    try{
+        for(int i = 1; i < argc; i++){
+            std::string name = argv[i];
+            if(name == "--help"){
+                printUsage();
+                return 0;
+            }
+            if(i + 1 >= argc){
+                throw std::invalid_argument("Missing value of " + name);
+            }
+            std::string value = argv[++i];
+            if(name == "--output"){
+                output = value;
+            }else if(name == "--rows"){
+                options.rows = parseNumber(name, value);
+            }else if(name == "--columns"){
+                options.columns = parseNumber(name, value);
+            }else if(name == "--cells"){
+                cells = parseNumber(name, value);
+            }else if(name == "--integers"){
+                options.integers = parseNumber(name, value);
+            }else if(name == "--doubles"){
+                options.doubles = parseNumber(name, value);
+            }else if(name == "--strings"){
+                options.strings = parseNumber(name, value);
+            }else if(name == "--formulas"){
+                options.formulas = parseNumber(name, value);
+            }else if(name == "--empty"){
+                options.empty = parseNumber(name, value);
+            }else if(name == "--seed"){
+                options.seed = std::strtoull(value.c_str(), nullptr, 10);
+            }else if(name == "--distinct-strings"){
+                options.distinctStrings = parseNumber(name, value);
+            }else if(name == "--references"){
+                options.references = parseNumber(name, value);
+            }else if(name == "--ranges"){
+                options.ranges = parseNumber(name, value);
+            }else if(name == "--range-rows"){
+                options.rangeRows = parseNumber(name, value);
+            }else if(name == "--chain-depth"){
+                options.chainDepth = parseNumber(name, value);
+            }else if(name == "--shared-cells"){
+                options.sharedCells = parseNumber(name, value);
+            }else if(name == "--shared-references"){
+                options.sharedReferences = parseNumber(name, value);
+            }else{
+                throw std::invalid_argument("Unknown option " + name);
+            }
+        }
+        if(output.empty()){
+            throw std::invalid_argument("Missing --output");
+        }
+        if(cells > 0){
+            options.rows = std::max(1.0, (cells + options.columns - 1) / std::max((size_t)1, options.columns));
+        }
+
+        SheetGenerator generator(options);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t bytes = generator.writeCsv(output);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "Written " << output << ": [" << options.rows << "x" << options.columns << "] cells, "
+                  << bytes << " bytes in " << std::chrono::duration<double>(end - start).count() << " s\n";
+    }catch(std::invalid_argument& e){
+        std::cerr << "FAIL: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    return 0;
+}
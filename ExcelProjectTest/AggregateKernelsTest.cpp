@@ -0,0 +1,103 @@
+#include "catch_amalgamated.hpp"
+
+#include <vector>
+#include <limits>
+
+#include "../ExcelProject/AggregateKernels.h"
+
+namespace{
+
+const AggregateKernels::InstructionSet allSets[] = {
+    AggregateKernels::InstructionSet::Scalar,
+    AggregateKernels::InstructionSet::SSE2,
+    AggregateKernels::InstructionSet::AVX2
+};
+
+void setValid(std::vector<uint64_t>& validity, size_t i){
+    validity[i / 64] |= 1ULL << (i % 64);
+}
+
+}
+
+TEST_CASE ("AggregateKernels :: summarize (all valid)"){
+    AggregateKernels::InstructionSet initial = AggregateKernels::instructionSet();
+    std::vector<double> values;
+    for(size_t i = 0; i < 203; i++){
+        values.push_back((double)i - 50);
+    }
+    std::vector<uint64_t> validity(4, ~0ULL);
+
+    for(AggregateKernels::InstructionSet set : allSets){
+        if(!AggregateKernels::useInstructionSet(set)){
+            continue;
+        }
+        AggregateKernels::Summary summary;
+        AggregateKernels::summarize(values.data(), validity.data(), values.size(), summary);
+        REQUIRE (summary.count == 203);
+        REQUIRE (summary.sum == 203 * 101 - 203 * 50);
+        REQUIRE (summary.min == -50);
+        REQUIRE (summary.max == 152);
+    }
+    AggregateKernels::useInstructionSet(initial);
+}
+
+TEST_CASE ("AggregateKernels :: summarize (masked)"){
+    AggregateKernels::InstructionSet initial = AggregateKernels::instructionSet();
+    std::vector<double> values(130, std::numeric_limits<double>::quiet_NaN());
+    std::vector<uint64_t> validity(3, 0);
+    values[3] = 7;
+    setValid(validity, 3);
+    values[64] = -2;
+    setValid(validity, 64);
+    values[129] = 4.5;
+    setValid(validity, 129);
+
+    for(AggregateKernels::InstructionSet set : allSets){
+        if(!AggregateKernels::useInstructionSet(set)){
+            continue;
+        }
+        AggregateKernels::Summary summary;
+        AggregateKernels::summarize(values.data(), validity.data(), values.size(), summary);
+        REQUIRE (summary.count == 3);
+        REQUIRE (summary.sum == 9.5);
+        REQUIRE (summary.min == -2);
+        REQUIRE (summary.max == 7);
+
+        AggregateKernels::Summary empty;
+        AggregateKernels::summarize(values.data(), validity.data(), 3, empty);
+        REQUIRE (empty.count == 0);
+        REQUIRE (empty.sum == 0);
+    }
+    AggregateKernels::useInstructionSet(initial);
+}
+
+TEST_CASE ("AggregateKernels :: sumProduct"){
+    AggregateKernels::InstructionSet initial = AggregateKernels::instructionSet();
+    std::vector<double> left(70), right(70);
+    std::vector<uint64_t> leftValidity(2, ~0ULL), rightValidity(2, ~0ULL);
+    for(size_t i = 0; i < 70; i++){
+        left[i] = i;
+        right[i] = 2;
+    }
+    // one invalid element on either side removes the pair
+    left[10] = std::numeric_limits<double>::infinity();
+    leftValidity[0] &= ~(1ULL << 10);
+    rightValidity[1] &= ~(1ULL << 5);
+
+    for(AggregateKernels::InstructionSet set : allSets){
+        if(!AggregateKernels::useInstructionSet(set)){
+            continue;
+        }
+        double res = AggregateKernels::sumProduct(left.data(), leftValidity.data(), right.data(), rightValidity.data(), 70);
+        REQUIRE (res == 2 * (69 * 70 / 2 - 10 - 69));
+    }
+    AggregateKernels::useInstructionSet(initial);
+}
+
+TEST_CASE ("AggregateKernels :: countValid"){
+    std::vector<uint64_t> validity = {~0ULL, 0x5ULL};
+    REQUIRE (AggregateKernels::countValid(validity.data(), 64) == 64);
+    REQUIRE (AggregateKernels::countValid(validity.data(), 66) == 65);
+    REQUIRE (AggregateKernels::countValid(validity.data(), 128) == 66);
+    REQUIRE (AggregateKernels::isSupported(AggregateKernels::InstructionSet::Scalar));
+}
@@ -0,0 +1,138 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "../ExcelProject/BinaryWorkbook.h"
+#include "../ExcelProject/CellInt.h"
+#include "../ExcelProject/CellDouble.h"
+#include "../ExcelProject/CellString.h"
+#include "../ExcelProject/CellFormula.h"
+
+TEST_CASE ("BinaryWorkbook :: hasExtension"){
+    REQUIRE (BinaryWorkbook::hasExtension("table.xtb"));
+    REQUIRE (BinaryWorkbook::hasExtension("dir/TABLE.XtB"));
+    REQUIRE_FALSE (BinaryWorkbook::hasExtension(".xtb"));
+    REQUIRE_FALSE (BinaryWorkbook::hasExtension("table.csv"));
+    REQUIRE_FALSE (BinaryWorkbook::hasExtension("table.xtb.csv"));
+}
+
+TEST_CASE ("BinaryWorkbook :: save, load"){
+    const std::string filename = "BinaryWorkbookTest_roundtrip.xtb";
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        t.setCellValue(0, 0, "5");
+        t.setCellValue(1, 0, "-7");
+        t.setCellValue(2, 0, "2.5");
+        t.setCellValue(0, 1, "\"text\"");
+        t.setCellValue(1, 1, "\"text\"");
+        t.setCellValue(2, 1, "\"with \\\"quotes\\\"\"");
+        t.setCellValue(0, 2, "=A0 + A1 * 2");
+        t.setCellValue(1, 2, "=SUM(A0:A2) / 2");
+        t.setCellValue(2, 2, "=1/0");
+        t.setCellValue(3, 2, "=1/0");
+        t.setCellValue(4, 27, "1.25");
+        t.setCellValue(5, 27, "=AB4*2");
+        t.setCellValue(6, 3, "=D6 + 1");
+
+        BinaryWorkbook::save(t, filename);
+
+        Table loaded;
+        loaded.setColumnar(columnar);
+        loaded.setCellValue(10, 10, "1");
+        BinaryWorkbook::load(filename, loaded);
+
+        REQUIRE (loaded.rowsCount() == t.rowsCount());
+        REQUIRE (loaded.columnsCount() == t.columnsCount());
+        for(size_t row = 0; row < t.rowsCount(); row++){
+            for(size_t col = 0; col < t.columnsCount(); col++){
+                REQUIRE (loaded.getConstructedCellValue(row, col) == t.getConstructedCellValue(row, col));
+                REQUIRE (loaded.getDisplayableCellValue(row, col) == t.getDisplayableCellValue(row, col));
+            }
+        }
+        REQUIRE (dynamic_cast<const CellInt*>(loaded.getCellPointer(1, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellDouble*>(loaded.getCellPointer(2, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellString*>(loaded.getCellPointer(2, 1)) != nullptr);
+        const CellFormula* formula = dynamic_cast<const CellFormula*>(loaded.getCellPointer(2, 2));
+        REQUIRE (formula != nullptr);
+        REQUIRE (formula->errorCode() == FormulaProgram::Error::DivideByZero);
+        REQUIRE (loaded.getDisplayableCellValue(6, 3) == "#CYCLE");
+        REQUIRE (loaded.getDisplayableCellValue(1, 2) == "0.25");
+        REQUIRE (loaded.getDisplayableCellValue(5, 27) == "2.5");
+
+        // dependencies of the loaded formulas are known without calculating them again
+        loaded.setCellValue(0, 0, "10");
+        REQUIRE (loaded.getDisplayableCellValue(0, 2) == "-4");
+        REQUIRE (loaded.getDisplayableCellValue(1, 2) == "2.75");
+        loaded.setCellValue(4, 27, "4");
+        REQUIRE (loaded.getDisplayableCellValue(5, 27) == "8");
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("BinaryWorkbook :: save, load (empty table)"){
+    const std::string filename = "BinaryWorkbookTest_empty.xtb";
+    BinaryWorkbook::save(Table(), filename);
+
+    Table loaded;
+    loaded.setCellValue(3, 3, "1");
+    BinaryWorkbook::load(filename, loaded);
+    REQUIRE (loaded.getCellPointer(3, 3) == nullptr);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("BinaryWorkbook :: load (invalid files)"){
+    const std::string filename = "BinaryWorkbookTest_invalid.xtb";
+    Table t;
+    t.setCellValue(0, 0, "5");
+    t.setCellValue(0, 1, "\"text\"");
+    t.setCellValue(1, 1, "=A0+1");
+
+    REQUIRE_THROWS_AS (BinaryWorkbook::load("BinaryWorkbookTest_missing.xtb", t), std::invalid_argument);
+
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file << "5,\"text\",=A0+1\n";
+    }
+    REQUIRE_THROWS_AS (BinaryWorkbook::load(filename, t), std::invalid_argument);
+
+    BinaryWorkbook::save(t, filename);
+    std::string content;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), content.size() / 2);
+    }
+    REQUIRE_THROWS_AS (BinaryWorkbook::load(filename, t), std::invalid_argument);
+
+    // the table stays as it was
+    REQUIRE (t.getConstructedCellValue(0, 1) == "\"text\"");
+    REQUIRE (t.getDisplayableCellValue(1, 1) == "6");
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("BinaryWorkbook :: save, load (filled formulas)"){
+    const std::string filename = "BinaryWorkbookTest_filled.xtb";
+    Table t;
+    for(size_t row = 0; row < 50; row++){
+        t.setCellValue(row, 0, std::to_string(row));
+    }
+    t.setCellValue(0, 1, "=A0+1");
+    t.fill(0, 1, 1, 1, 49, 1);
+    BinaryWorkbook::save(t, filename);
+
+    Table loaded;
+    BinaryWorkbook::load(filename, loaded);
+    const CellFormula* first = dynamic_cast<const CellFormula*>(loaded.getCellPointer(0, 1));
+    const CellFormula* last = dynamic_cast<const CellFormula*>(loaded.getCellPointer(49, 1));
+    REQUIRE (first->getTemplate() == last->getTemplate());
+    REQUIRE (loaded.getConstructedCellValue(49, 1) == "=A49+1");
+    REQUIRE (loaded.getDisplayableCellValue(49, 1) == "50");
+    loaded.setCellValue(49, 0, "0");
+    REQUIRE (loaded.getDisplayableCellValue(49, 1) == "1");
+    std::remove(filename.c_str());
+}
@@ -40,6 +40,17 @@ TEST_CASE ("CellDouble :: getConstructString()"){
     REQUIRE (cd3.getConstructString() == "0");
 }
 
+TEST_CASE ("CellDouble :: getDisplayableView()"){
+    std::string buffer;
+    CellDouble cd1("12.567");
+    REQUIRE (cd1.getDisplayableView(buffer) == "12.567");
+    REQUIRE (cd1.getConstructView(buffer) == "12.567");
+    CellDouble cd2("-3.5");
+    REQUIRE (cd2.getDisplayableView(buffer) == "-3.5");
+    CellDouble cd3("1000000000000000000000000000000000000000000000000000000000000000000000");
+    REQUIRE (cd3.getDisplayableView(buffer) == cd3.getDisplayableString());
+}
+
 TEST_CASE ("CellDouble :: constructor (invalid input)"){
     REQUIRE_THROWS_AS (CellDouble("a12"), std::invalid_argument);
     REQUIRE_THROWS_AS (CellDouble("1a2"), std::invalid_argument);
@@ -259,6 +259,114 @@ TEST_CASE ("CellFormula :: brackets expression calculation (*, /, +, -)"){
     REQUIRE (cf4.getValue() == 1);
 }
 
+TEST_CASE ("CellFormula :: aggregate functions over ranges"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "2.5");
+    t.setCellValue(2, 0, "\"str\"");
+    t.setCellValue(3, 0, "=-4");
+    t.setCellValue(0, 1, "10");
+
+    CellFormula cf1(&t, "=SUM(A0:A4)");
+    REQUIRE (cf1.error() == false);
+    REQUIRE (cf1.getValue() == -0.5);
+
+    CellFormula cf2(&t, "=COUNT(A0:A9)");
+    REQUIRE (cf2.error() == false);
+    REQUIRE (cf2.getValue() == 3);
+
+    CellFormula cf3(&t, "=MIN(A0:B3)+MAX(B0:A3)");
+    REQUIRE (cf3.error() == false);
+    REQUIRE (cf3.getValue() == 6);
+
+    CellFormula cf4(&t, "=average(A0:B0, 3*2, A1)");
+    REQUIRE (cf4.error() == false);
+    REQUIRE (cf4.getValue() == 4.875);
+
+    CellFormula cf5(&t, "=2*SUM(A0:A1)-(SUM(B0:B0))");
+    REQUIRE (cf5.error() == false);
+    REQUIRE (cf5.getValue() == -3);
+}
+
+TEST_CASE ("CellFormula :: SUMPRODUCT"){
+    Table t;
+    for(size_t row = 0; row < 300; row++){
+        t.setCellValue(row, 0, std::to_string(row));
+        t.setCellValue(row, 1, "2");
+    }
+    t.setCellValue(7, 1, "\"str\"");
+
+    CellFormula cf1(&t, "=SUMPRODUCT(A0:A299, B0:B299)");
+    REQUIRE (cf1.error() == false);
+    REQUIRE (cf1.getValue() == 2 * (299 * 300 / 2 - 7));
+
+    CellFormula cf2(&t, "=SUMPRODUCT(A0:B1, A2:B3)");
+    REQUIRE (cf2.error() == false);
+    REQUIRE (cf2.getValue() == 0 * 2 + 1 * 3 + 2 * 2 + 2 * 2);
+
+    CellFormula cf3(&t, "=SUMPRODUCT(A0:A10, B0:B9)");
+    REQUIRE (cf3.error() == true);
+
+    CellFormula cf4(&t, "=SUMPRODUCT(A0:A10)");
+    REQUIRE (cf4.error() == true);
+}
+
+TEST_CASE ("CellFormula :: aggregate functions (errors)"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "=1/0");
+
+    CellFormula cf1(&t, "=SUM(A0:A1)");
+    REQUIRE (cf1.error() == true);
+
+    CellFormula cf2(&t, "=COUNT(A0:A1)");
+    REQUIRE (cf2.error() == false);
+    REQUIRE (cf2.getValue() == 1);
+
+    CellFormula cf3(&t, "=AVERAGE(C0:C5)");
+    REQUIRE (cf3.error() == true);
+
+    CellFormula cf4(&t, "=MAX(C0:C5)");
+    REQUIRE (cf4.error() == false);
+    REQUIRE (cf4.getValue() == 0);
+
+    CellFormula cf5(&t, "=UNKNOWN(A0:A1)");
+    REQUIRE (cf5.error() == true);
+
+    CellFormula cf6(&t, "=SUM()");
+    REQUIRE (cf6.error() == true);
+
+    CellFormula cf7(&t, "=A0:A1");
+    REQUIRE (cf7.error() == true);
+}
+
+TEST_CASE ("CellFormula :: getDisplayableView() and getConstructView()"){
+    Table t;
+    std::string buffer;
+    CellFormula cf1(&t, "=5/2");
+    REQUIRE (cf1.getDisplayableView(buffer) == "2.5");
+    REQUIRE (cf1.getConstructView(buffer) == "=5/2");
+    CellFormula cf2(&t, "=5/0");
+    REQUIRE (cf2.getDisplayableView(buffer) == cf2.getDisplayableString());
+}
+
+TEST_CASE ("CellFormula :: collectReferences"){
+    Table t;
+    CellFormula cf(&t, "= A1 + SUM(c5:B2, 3) * 2.5 - (D0)");
+    std::vector<Table::Range> refs;
+    cf.collectReferences(refs);
+    REQUIRE (refs.size() == 3);
+    REQUIRE (refs[0].fromRow == 1);
+    REQUIRE (refs[0].toRow == 1);
+    REQUIRE (refs[0].fromColumn == 0);
+    REQUIRE (refs[0].toColumn == 0);
+    REQUIRE (refs[1].fromRow == 2);
+    REQUIRE (refs[1].toRow == 5);
+    REQUIRE (refs[1].fromColumn == 1);
+    REQUIRE (refs[1].toColumn == 2);
+    REQUIRE (refs[2].fromRow == 0);
+    REQUIRE (refs[2].fromColumn == 3);
+}
 
 TEST_CASE ("CellFormula :: constructor (invalid input)"){
     Table t;
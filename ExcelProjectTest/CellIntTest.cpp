@@ -27,6 +27,15 @@ TEST_CASE ("CellInt :: getDisplayableString()"){
     REQUIRE (ci2.getDisplayableString() == "0");
 }
 
+TEST_CASE ("CellInt :: getDisplayableView()"){
+    std::string buffer;
+    CellInt ci1("12");
+    REQUIRE (ci1.getDisplayableView(buffer) == "12");
+    REQUIRE (ci1.getConstructView(buffer) == "12");
+    CellInt ci2("-2147483648");
+    REQUIRE (ci2.getDisplayableView(buffer) == "-2147483648");
+}
+
 TEST_CASE ("CellInt :: constructor (invalid input)"){
     REQUIRE_THROWS_AS (CellInt("a12"), std::invalid_argument);
     REQUIRE_THROWS_AS (CellInt("1a2"), std::invalid_argument);
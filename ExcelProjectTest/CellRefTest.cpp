@@ -0,0 +1,65 @@
+#include "catch_amalgamated.hpp"
+
+#include "../ExcelProject/CellRef.h"
+
+TEST_CASE ("CellRef :: parse"){
+    CellRef ref;
+    REQUIRE (CellRef::parse("A0", ref));
+    REQUIRE (ref.row() == 0);
+    REQUIRE (ref.column() == 0);
+    REQUIRE (CellRef::parse("z15", ref));
+    REQUIRE (ref.row() == 15);
+    REQUIRE (ref.column() == 25);
+    REQUIRE (CellRef::parse("AA1", ref));
+    REQUIRE (ref.column() == 26);
+    REQUIRE (CellRef::parse("aZ3", ref));
+    REQUIRE (ref.column() == 51);
+    REQUIRE (CellRef::parse("ZZ3", ref));
+    REQUIRE (ref.column() == 701);
+    REQUIRE (CellRef::parse("AAA3", ref));
+    REQUIRE (ref.column() == 702);
+    REQUIRE (CellRef::parse("XFD4294967295", ref));
+    REQUIRE (ref.column() == CellRef::MAX_COLUMNS - 1);
+    REQUIRE (ref.row() == CellRef::LAST_ROW);
+}
+
+TEST_CASE ("CellRef :: parse (invalid input)"){
+    CellRef ref;
+    REQUIRE_FALSE (CellRef::parse("", ref));
+    REQUIRE_FALSE (CellRef::parse("A", ref));
+    REQUIRE_FALSE (CellRef::parse("15", ref));
+    REQUIRE_FALSE (CellRef::parse("A1B", ref));
+    REQUIRE_FALSE (CellRef::parse("A-1", ref));
+    REQUIRE_FALSE (CellRef::parse("A 1", ref));
+    REQUIRE_FALSE (CellRef::parse("XFE1", ref));
+    REQUIRE_FALSE (CellRef::parse("AAAA1", ref));
+    REQUIRE_FALSE (CellRef::parse("A4294967296", ref));
+    REQUIRE_FALSE (CellRef::parse("A04294967295", ref));
+    REQUIRE_FALSE (CellRef::parse("A1:B2", ref));
+    REQUIRE_THROWS_AS (CellRef::fromString("1A"), std::invalid_argument);
+}
+
+TEST_CASE ("CellRef :: parsePrefix"){
+    CellRef ref;
+    REQUIRE (CellRef::parsePrefix("AB12:C3", ref) == 4);
+    REQUIRE (ref == CellRef(12, 27));
+    REQUIRE (CellRef::parsePrefix("B7+1", ref) == 2);
+    REQUIRE (ref == CellRef(7, 1));
+    REQUIRE (CellRef::parsePrefix("SUM(A0:A1)", ref) == 0);
+    REQUIRE (CellRef::parsePrefix("B7C", ref) == 0);
+}
+
+TEST_CASE ("CellRef :: toString and key"){
+    REQUIRE (CellRef(0, 0).toString() == "A0");
+    REQUIRE (CellRef(9, 25).toString() == "Z9");
+    REQUIRE (CellRef(3, 26).toString() == "AA3");
+    REQUIRE (CellRef(3, 701).toString() == "ZZ3");
+    REQUIRE (CellRef(3, 702).toString() == "AAA3");
+    REQUIRE (CellRef(1, CellRef::MAX_COLUMNS - 1).toString() == "XFD1");
+    for(size_t col = 0; col < CellRef::MAX_COLUMNS; col += 7){
+        CellRef ref(col * 3, col);
+        REQUIRE (CellRef::fromString(ref.toString()) == ref);
+        REQUIRE (CellRef::fromKey(ref.key()) == ref);
+    }
+    REQUIRE (CellRef(1, 0) != CellRef(0, 1));
+}
@@ -34,6 +34,16 @@ TEST_CASE ("CellString :: getConstructString()"){
     REQUIRE (cs2.getConstructString() == "\"\"");
 }
 
+TEST_CASE ("CellString :: getDisplayableView() and getConstructView()"){
+    std::string buffer;
+    CellString cs1("\"string\"");
+    REQUIRE (cs1.getDisplayableView(buffer) == "string");
+    REQUIRE (cs1.getConstructView(buffer) == "\"string\"");
+    REQUIRE (buffer.empty());
+    CellString cs2;
+    REQUIRE (cs2.getDisplayableView(buffer) == "");
+}
+
 
 TEST_CASE ("CellString :: constructor (invalid input)"){
     REQUIRE_THROWS_AS (CellString("str"), std::invalid_argument);
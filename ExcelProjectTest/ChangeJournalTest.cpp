@@ -0,0 +1,140 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "../ExcelProject/ChangeJournal.h"
+
+namespace{
+
+const std::string filename = "ChangeJournalTest.csv";
+
+bool journalExists(){
+    return std::ifstream(ChangeJournal::pathFor(filename)).is_open();
+}
+
+}
+
+TEST_CASE ("ChangeJournal :: open, commit, dropUnsaved"){
+    std::ofstream(filename) << "1,2";
+    ChangeJournal::remove(filename);
+
+    Table t;
+    ChangeJournal::Recovery recovery;
+    REQUIRE (ChangeJournal::open(filename, t, false, recovery) == nullptr);
+    REQUIRE_FALSE (recovery.found);
+
+    std::shared_ptr<ChangeJournal> journal = ChangeJournal::open(filename, t, true, recovery);
+    REQUIRE (journal != nullptr);
+    REQUIRE (journalExists());
+    journal->recordSet(0, 0, "5");
+    journal->recordFill(0, 0, 1, 0, 2, 0);
+    journal->commit();
+    journal->recordSet(0, 1, "=A0+1");
+    REQUIRE (journal->baseChanges() == 0);
+    REQUIRE (journal->savedChanges() == 2);
+    journal.reset();
+
+    // the program ended without closing the file
+    Table replayed;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, replayed, false, recovery);
+    REQUIRE (journal != nullptr);
+    REQUIRE (recovery.found);
+    REQUIRE (recovery.matched);
+    REQUIRE (recovery.changes == 3);
+    REQUIRE (recovery.unsaved == 1);
+    REQUIRE (recovery.failed == 0);
+    REQUIRE (replayed.getDisplayableCellValue(2, 0) == "5");
+    REQUIRE (replayed.getDisplayableCellValue(0, 1) == "6");
+
+    journal->dropUnsaved();
+    journal.reset();
+    Table saved;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, saved, false, recovery);
+    REQUIRE (recovery.changes == 2);
+    REQUIRE (recovery.unsaved == 0);
+    REQUIRE (saved.getDisplayableCellValue(0, 1) == "");
+    journal.reset();
+
+    // a record which was not written entirely is forgotten
+    std::ofstream(ChangeJournal::pathFor(filename), std::ios::app | std::ios::binary) << "\x05\x00\x00";
+    journal = ChangeJournal::open(filename, saved, false, recovery);
+    journal->recordSet(3, 0, "\"text\"");
+    journal->commit();
+    journal.reset();
+    Table appended;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, appended, false, recovery);
+    REQUIRE (recovery.changes == 3);
+    REQUIRE (appended.getDisplayableCellValue(3, 0) == "text");
+    journal.reset();
+
+    // the file was changed by another program
+    std::ofstream(filename) << "1,3";
+    recovery = ChangeJournal::Recovery();
+    REQUIRE (ChangeJournal::open(filename, t, false, recovery) == nullptr);
+    REQUIRE (recovery.found);
+    REQUIRE_FALSE (recovery.matched);
+    REQUIRE_FALSE (journalExists());
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("ChangeJournal :: checkpoint, restart"){
+    std::ofstream(filename) << "1";
+    ChangeJournal::remove(filename);
+    const std::string compacted = "ChangeJournalTest.csv.new";
+
+    Table t;
+    ChangeJournal::Recovery recovery;
+    std::shared_ptr<ChangeJournal> journal = ChangeJournal::open(filename, t, true, recovery);
+    journal->recordSet(0, 0, "2");
+    journal->recordSet(0, 1, "3");
+    journal->commit();
+    std::ofstream(compacted) << "2,3";
+    uint64_t fingerprint = ChangeJournal::fingerprint(compacted);
+    REQUIRE (fingerprint != ChangeJournal::fingerprint(filename));
+    journal->checkpoint(fingerprint, 2);
+    journal->recordSet(1, 0, "4");
+    journal.reset();
+
+    // the new file has not replaced the old one
+    Table old;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, old, false, recovery);
+    REQUIRE (recovery.changes == 3);
+    REQUIRE (recovery.unsaved == 1);
+    REQUIRE (journal->baseChanges() == 0);
+    journal.reset();
+
+    // it has, but the journal was not restarted
+    std::rename(compacted.c_str(), filename.c_str());
+    Table replaced;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, replaced, false, recovery);
+    REQUIRE (recovery.matched);
+    REQUIRE (recovery.changes == 1);
+    REQUIRE (recovery.unsaved == 1);
+    REQUIRE (replaced.getDisplayableCellValue(1, 0) == "4");
+    REQUIRE (journal->baseChanges() == 2);
+    REQUIRE (journal->savedChanges() == 2);
+
+    journal->commit();
+    std::ofstream(filename) << "2,3\n4";
+    journal->restart(ChangeJournal::fingerprint(filename), 3);
+    journal->recordSet(1, 1, "5");
+    journal.reset();
+    Table restarted;
+    recovery = ChangeJournal::Recovery();
+    journal = ChangeJournal::open(filename, restarted, false, recovery);
+    REQUIRE (recovery.changes == 1);
+    REQUIRE (recovery.unsaved == 1);
+    REQUIRE (restarted.getDisplayableCellValue(1, 1) == "5");
+    REQUIRE (journal->baseChanges() == 3);
+    journal.reset();
+
+    ChangeJournal::remove(filename);
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,178 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../ExcelProject/ChangeJournal.h"
+#include "../ExcelProject/ControlCenter.h"
+#include "../ExcelProject/ResultSidecar.h"
+
+TEST_CASE ("ControlCenter :: setBackgroundSaving"){
+    const std::string filename = "ControlCenterTest.csv";
+    std::ofstream(filename) << "1,=A0*2";
+
+    ControlCenter cc;
+    REQUIRE (!cc.isBackgroundSaving());
+    cc.setOverwrite(ControlCenter::Overwrite::Always);
+    cc.setBackgroundSaving(true);
+    std::ostringstream output;
+    std::ostringstream errors;
+    std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(errors.rdbuf());
+
+    // the file gets the table as it was when SAVE was executed
+    cc.executeCommand("OPEN " + filename);
+    cc.executeCommand("EDIT A0 5");
+    cc.executeCommand("SAVE");
+    cc.executeCommand("EDIT A0 7");
+    cc.waitForSaves();
+    REQUIRE (output.str().find("Saved " + filename) != std::string::npos);
+    std::string line;
+    std::getline(std::ifstream(filename), line);
+    REQUIRE (line == "5,=A0*2");
+    REQUIRE (cc.executeCommand("GET B0") == "14");
+    // the edit made during the save is not saved
+    cc.executeCommand("CLOSE");
+    REQUIRE (errors.str() == "Unsaved changes of " + filename + " dropped.\n");
+
+    errors.str("");
+    cc.executeCommand("OPEN " + filename);
+    cc.executeCommand("EDIT A0 9");
+    cc.executeCommand("SAVE");
+    cc.executeCommand("CLOSE");
+    REQUIRE (errors.str().empty());
+
+    // failures are reported when they happen
+    cc.executeCommand("SAVEAS missing/" + filename);
+    cc.waitForSaves();
+    REQUIRE (errors.str().find("FAIL: Saving missing/" + filename + " failed: ") != std::string::npos);
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+
+    std::getline(std::ifstream(filename), line);
+    REQUIRE (line == "9,=A0*2");
+    REQUIRE (std::ifstream(filename + ".tmp").fail());
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
+
+TEST_CASE ("ControlCenter :: setBackgroundSaving (lazy calculation)"){
+    const std::string filename = "ControlCenterTest.csv";
+    std::ofstream(filename) << "1,=A0*2";
+
+    ControlCenter cc;
+    cc.setOverwrite(ControlCenter::Overwrite::Always);
+    cc.setBackgroundSaving(true);
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    // the dirty formulas are calculated before the copy is taken, not by the saving thread
+    cc.executeCommand("OPEN " + filename);
+    cc.executeCommand("CALCULATION LAZY");
+    cc.executeCommand("EDIT A0 5");
+    cc.executeCommand("SAVE");
+    cc.executeCommand("EDIT A0 7");
+    REQUIRE (cc.executeCommand("GET B0") == "14");
+    cc.waitForSaves();
+    std::cout.rdbuf(coutBuffer);
+
+    std::string line;
+    std::getline(std::ifstream(filename), line);
+    REQUIRE (line == "5,=A0*2");
+    REQUIRE (cc.executeCommand("GET B0") == "14");
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
+
+TEST_CASE ("ControlCenter :: setJournaling"){
+    const std::string filename = "ControlCenterJournalTest.csv";
+    std::ofstream(filename) << "1,=A0*2";
+    ChangeJournal::remove(filename);
+    auto firstLine = [&filename](){
+        std::string line;
+        std::getline(std::ifstream(filename), line);
+        return line;
+    };
+    auto journalExists = [&filename](){
+        return std::ifstream(ChangeJournal::pathFor(filename)).is_open();
+    };
+    std::ostringstream output;
+    std::ostringstream errors;
+    std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(errors.rdbuf());
+
+    {
+        ControlCenter cc;
+        cc.setOverwrite(ControlCenter::Overwrite::Always);
+        REQUIRE_FALSE (cc.isJournaling());
+        cc.executeCommand("JOURNAL ON");
+        REQUIRE (cc.isJournaling());
+        cc.executeCommand("OPEN " + filename);
+        cc.executeCommand("EDIT A0 5");
+        cc.executeCommand("SAVE");
+        // only the journal is written
+        REQUIRE (firstLine() == "1,=A0*2");
+        REQUIRE (journalExists());
+        cc.executeCommand("EDIT A0 7");
+        // the program ends without closing the file
+    }
+
+    {
+        ControlCenter cc;
+        cc.setOverwrite(ControlCenter::Overwrite::Always);
+        output.str("");
+        cc.executeCommand("OPEN " + filename);
+        REQUIRE (output.str().find("Journal replayed. [2/2] changes, 1 of them not saved") != std::string::npos);
+        REQUIRE (cc.executeCommand("GET B0") == "14");
+        cc.executeCommand("CLOSE");
+        REQUIRE (errors.str() == "Unsaved changes of " + filename + " dropped.\n");
+        // the saved change stays in the journal
+        REQUIRE (journalExists());
+        REQUIRE (firstLine() == "1,=A0*2");
+
+        errors.str("");
+        cc.executeCommand("OPEN " + filename);
+        REQUIRE (cc.executeCommand("GET B0") == "10");
+        cc.executeCommand("CLOSE");
+        REQUIRE (errors.str().empty());
+        REQUIRE (firstLine() == "5,=A0*2");
+        REQUIRE_FALSE (journalExists());
+    }
+
+    {
+        // the file is written again in the background after every 2 saved changes
+        ControlCenter cc;
+        cc.setOverwrite(ControlCenter::Overwrite::Always);
+        cc.setBackgroundSaving(true);
+        cc.setJournaling(true);
+        cc.setCompactionChanges(2);
+        cc.executeCommand("OPEN " + filename);
+        cc.executeCommand("EDIT A0 8");
+        cc.executeCommand("SAVE");
+        cc.executeCommand("EDIT A0 9");
+        cc.executeCommand("SAVE");
+        cc.executeCommand("EDIT A0 3");
+        cc.waitForSaves();
+        REQUIRE (firstLine() == "9,=A0*2");
+        REQUIRE (journalExists());
+    }
+
+    {
+        ControlCenter cc;
+        cc.setOverwrite(ControlCenter::Overwrite::Always);
+        output.str("");
+        cc.executeCommand("OPEN " + filename);
+        REQUIRE (output.str().find("Journal replayed. [1/1] changes, 1 of them not saved") != std::string::npos);
+        REQUIRE (cc.executeCommand("GET A0") == "3");
+        cc.executeCommand("CLOSE");
+        REQUIRE_FALSE (journalExists());
+        REQUIRE (firstLine() == "9,=A0*2");
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
@@ -0,0 +1,260 @@
+#include "catch_amalgamated.hpp"
+
+#include "../ExcelProject/FormulaProgram.h"
+#include "../ExcelProject/Statistics.h"
+#include "../ExcelProject/Table.h"
+
+TEST_CASE ("FormulaProgram :: compile"){
+    REQUIRE_FALSE (FormulaProgram().isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("").isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("=").isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("5+1").isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("=5+").isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("=SUMX(A0)").isValid());
+    REQUIRE_FALSE (FormulaProgram::compile("=SUMPRODUCT(A0:A2, B0:B1)").isValid());
+
+    FormulaProgram program = FormulaProgram::compile("= A1 + 2 * B0");
+    REQUIRE (program.isValid());
+    const std::vector<FormulaProgram::Instruction>& code = program.code();
+    REQUIRE (code.size() == 5);
+    REQUIRE (code[0].code == FormulaProgram::OpCode::Cell);
+    REQUIRE (code[0].fromRow == 1);
+    REQUIRE (code[0].fromColumn == 0);
+    REQUIRE (code[1].code == FormulaProgram::OpCode::Number);
+    REQUIRE (code[1].number == 2);
+    REQUIRE (code[2].code == FormulaProgram::OpCode::Cell);
+    REQUIRE (code[2].fromColumn == 1);
+    REQUIRE (code[3].code == FormulaProgram::OpCode::Multiply);
+    REQUIRE (code[4].code == FormulaProgram::OpCode::Add);
+
+    // ranges are normalized
+    FormulaProgram sum = FormulaProgram::compile("=SUM(C5:B2)");
+    REQUIRE (sum.code()[0].code == FormulaProgram::OpCode::Range);
+    REQUIRE (sum.code()[0].fromRow == 2);
+    REQUIRE (sum.code()[0].fromColumn == 1);
+    REQUIRE (sum.code()[0].toRow == 5);
+    REQUIRE (sum.code()[0].toColumn == 2);
+}
+
+TEST_CASE ("FormulaProgram :: compile (brackets, order of operations)"){
+    Table t;
+    double result;
+    REQUIRE (FormulaProgram::compile("=(1)+(2)").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 3);
+    REQUIRE (FormulaProgram::compile("=8 / 4 * 2").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 1);
+    REQUIRE (FormulaProgram::compile("=10 - 4 - 3 + 2^3^2").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 67);
+    REQUIRE (FormulaProgram::compile("=-(2)^2 * (-(3))").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 12);
+    REQUIRE (FormulaProgram::compile("=sum(1, (2), -3, max(4, 5) * 2)").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 10);
+
+    // a reference given to a function on its own is a range of 1 cell, otherwise it is a number
+    REQUIRE (FormulaProgram::compile("=COUNT(A0)").code()[0].code == FormulaProgram::OpCode::Range);
+    REQUIRE (FormulaProgram::compile("=COUNT((A0))").code()[0].code == FormulaProgram::OpCode::Cell);
+
+    for(const char* invalid : {"=(1", "=1)", "=)1(", "=()", "=SUM()", "=SUM(1,)", "=1,2", "=2*-1", "=A0:B1",
+                               "=SUM((A0:B1))", "=(1)2", "=A0(1)", "=SUMPRODUCT(A0:A1)", "=1."}){
+        REQUIRE_FALSE (FormulaProgram::compile(invalid).isValid());
+    }
+}
+
+TEST_CASE ("FormulaProgram :: compile (long formulas)"){
+    Table t;
+    const size_t terms = 30000;
+    std::string formula = "=A0";
+    for(size_t i = 1; i < terms; i++){
+        formula += (i % 2 == 0) ? "+A" : "-A";
+        formula += std::to_string(i);
+        t.setCellValue(i, 0, std::to_string(i));
+    }
+    FormulaProgram sum = FormulaProgram::compile(formula);
+    REQUIRE (sum.code().size() == 2 * terms - 1);
+    double result;
+    REQUIRE (sum.evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == -(double)terms / 2);
+
+    // nesting is not limited by the call stack
+    const size_t depth = 100000;
+    FormulaProgram nested = FormulaProgram::compile("=" + std::string(depth, '(') + "A1*2" + std::string(depth, ')'));
+    REQUIRE (nested.code().size() == 3);
+    REQUIRE_FALSE (FormulaProgram::compile("=" + std::string(depth, '(') + "1" + std::string(depth - 1, ')')).isValid());
+}
+
+TEST_CASE ("FormulaProgram :: evaluate"){
+    Table t;
+    t.setCellValue(0, 0, "3");
+    t.setCellValue(1, 0, "4.5");
+    t.setCellValue(2, 0, "\"str\"");
+    t.setCellValue(0, 1, "2");
+    t.setCellValue(1, 1, "=1/0");
+
+    double result = -1;
+    REQUIRE (FormulaProgram::compile("=A0 + A1 * 2 - 10 / 4").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 9.5);
+    REQUIRE (FormulaProgram::compile("=-A0^B0").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == -9);
+    REQUIRE (FormulaProgram::compile("=SUM(A0:A5, 2) + COUNT(A0:A5)").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 11.5);
+    REQUIRE (FormulaProgram::compile("=MAX(A0:A5) - MIN(A0, A1)").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 1.5);
+    REQUIRE (FormulaProgram::compile("=COUNT(A0:B1)").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 3);
+    REQUIRE (FormulaProgram::compile("=Z100").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 0);
+
+    REQUIRE (FormulaProgram::compile("=A0 / (B0 - 2)").evaluate(t, result) == FormulaProgram::Error::DivideByZero);
+    REQUIRE (result == 0);
+    REQUIRE (FormulaProgram::compile("=B1 + 1").evaluate(t, result) == FormulaProgram::Error::DivideByZero);
+    REQUIRE (FormulaProgram::compile("=SUM(A0:B1)").evaluate(t, result) == FormulaProgram::Error::DivideByZero);
+    REQUIRE (FormulaProgram().evaluate(t, result) == FormulaProgram::Error::Value);
+
+    // a copy of the instructions behaves in the same way
+    FormulaProgram program = FormulaProgram::compile("=SUMPRODUCT(A0:A1, B0:B1)");
+    FormulaProgram copy(program.code());
+    t.setCellValue(1, 1, "2");
+    REQUIRE (copy.evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 15);
+}
+
+TEST_CASE ("FormulaProgram :: evaluate (stacks)"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "2");
+    double result;
+
+    // stacks of a usual formula are local, evaluating it allocates nothing
+    FormulaProgram usual = FormulaProgram::compile("=A0 + SUM(A0:A1, A1 * 2) / MAX(A0, A1)");
+    REQUIRE (usual.evaluate(t, result) == FormulaProgram::Error::None);
+    uint64_t allocations = Statistics::counters().allocations;
+    REQUIRE (usual.evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (Statistics::counters().allocations == allocations);
+    REQUIRE (result == 4.5);
+
+    // deeper ones are allocated
+    const size_t depth = 40;
+    std::string values = "=";
+    std::string arguments = "=SUM(A1";
+    for(size_t i = 0; i < depth; i++){
+        values += "A0+(";
+        arguments += ",A0";
+    }
+    values += "A1" + std::string(depth, ')');
+    arguments += ")";
+    REQUIRE (FormulaProgram::compile(values).evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == depth + 2);
+    FormulaProgram copy(FormulaProgram::compile(arguments).code());
+    REQUIRE (copy.evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == depth + 2);
+}
+
+TEST_CASE ("FormulaProgram :: shiftReferences"){
+    REQUIRE (FormulaProgram::shiftReferences("=A1*B1", 1, 0) == "=A2*B2");
+    REQUIRE (FormulaProgram::shiftReferences("=a1 + SUM(B0:C3) - 2.5", 2, 1) == "=B3 + SUM(C2:D5) - 2.5");
+    REQUIRE (FormulaProgram::shiftReferences("=Z0+1", 0, 1) == "=AA0+1");
+    REQUIRE (FormulaProgram::shiftReferences("=A1+COUNT(A1)", -1, 0) == "=A0+COUNT(A0)");
+    REQUIRE (FormulaProgram::shiftReferences("=A1+B5", -2, 0) == "=#REF+B3");
+    REQUIRE (FormulaProgram::shiftReferences("=5", 10, 10) == "=5");
+
+    // a buffer passed again keeps its memory
+    std::string buffer = "previous content of the buffer";
+    const char* data = buffer.data();
+    FormulaProgram::shiftReferences("=A1*B1", 1, 0, buffer);
+    REQUIRE (buffer == "=A2*B2");
+    FormulaProgram::shiftReferences("=a1 + SUM(B0:C3) - 2.5", 2, 1, buffer);
+    REQUIRE (buffer == "=B3 + SUM(C2:D5) - 2.5");
+    REQUIRE (buffer.data() == data);
+}
+
+TEST_CASE ("FormulaProgram :: evaluate (offsets)"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "2");
+    t.setCellValue(2, 0, "3");
+    t.setCellValue(1, 1, "10");
+
+    FormulaProgram program = FormulaProgram::compile("=A0 * 2 + SUM(A0:A1)");
+    double result;
+    REQUIRE (program.evaluate(t, result, 0, 0) == FormulaProgram::Error::None);
+    REQUIRE (result == 5);
+    REQUIRE (program.evaluate(t, result, 1, 0) == FormulaProgram::Error::None);
+    REQUIRE (result == 9);
+    REQUIRE (program.evaluate(t, result, 1, 1) == FormulaProgram::Error::None);
+    REQUIRE (result == 30);
+    REQUIRE (program.evaluate(t, result, -1, 0) == FormulaProgram::Error::Reference);
+    REQUIRE (program.evaluate(t, result, 0, -1) == FormulaProgram::Error::Reference);
+}
+
+TEST_CASE ("FormulaProgram :: evaluateRun"){
+    Table t;
+    for(size_t row = 0; row < 300; row++){
+        t.setCellValue(row, 0, std::to_string(row % 7));
+        t.setCellValue(row, 1, std::to_string(row) + ".5");
+    }
+    t.setCellValue(3, 0, "\"text\"");
+    t.setCellValue(10, 1, "=A0 + A1");
+    t.setCellValue(305, 1, "=1/0");
+
+    const char* formulas[] = {"=A0 * B0 + 1", "=-A1 ^ 2 - B0 / 4", "=SUM(A0:B1, 2) + COUNT(A0:A3)",
+                              "=MAX(A0:A2) - MIN(B0, 3) + AVERAGE(A0:A1)", "=SUMPRODUCT(A0:A2, B0:B2)", "=Z0 + C1"};
+    double results[300];
+    for(const char* formula : formulas){
+        FormulaProgram program = FormulaProgram::compile(formula);
+        for(int64_t first : {0, 5, 120}){
+            REQUIRE (program.evaluateRun(t, first, 0, 180, results));
+            for(size_t k = 0; k < 180; k++){
+                double expected;
+                REQUIRE (program.evaluate(t, expected, first + k, 0) == FormulaProgram::Error::None);
+                REQUIRE (results[k] == expected);
+            }
+        }
+    }
+
+    // a single failing cell fails the whole run
+    REQUIRE_FALSE (FormulaProgram::compile("=B0 / A0").evaluateRun(t, 0, 0, 20, results));
+    REQUIRE (FormulaProgram::compile("=B0 / A0").evaluateRun(t, 4, 0, 3, results));
+    REQUIRE_FALSE (FormulaProgram::compile("=A0 + B0").evaluateRun(t, 300, 0, 10, results));
+    REQUIRE_FALSE (FormulaProgram::compile("=A5 + 1").evaluateRun(t, -6, 0, 10, results));
+    REQUIRE_FALSE (FormulaProgram().evaluateRun(t, 0, 0, 10, results));
+}
+
+TEST_CASE ("FormulaProgram :: compile (constants)"){
+    Table t;
+    t.setCellValue(0, 0, "3");
+    t.setCellValue(1, 0, "=0 * (-1)");
+    double result;
+
+    FormulaProgram folded = FormulaProgram::compile("=2 * 3 + 4 ^ 0.5 - (-1)");
+    REQUIRE (folded.code().size() == 1);
+    REQUIRE (folded.code()[0].code == FormulaProgram::OpCode::Number);
+    REQUIRE (folded.code()[0].number == 9);
+
+    FormulaProgram partly = FormulaProgram::compile("=(2^10)*A0/4");
+    REQUIRE (partly.code().size() == 5);
+    REQUIRE (partly.code()[0].number == 1024);
+    REQUIRE (partly.evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (result == 768);
+
+    REQUIRE (FormulaProgram::compile("=SUM(2 * 3, A0)").code()[0].number == 6);
+    for(const char* identity : {"=A0 * 1", "=1 * A0", "=A0 / 1", "=A0 - 0", "=A0 ^ 1", "=(A0 * (2 - 1)) / 1"}){
+        FormulaProgram program = FormulaProgram::compile(identity);
+        REQUIRE (program.code().size() == 1);
+        REQUIRE (program.code()[0].code == FormulaProgram::OpCode::Cell);
+    }
+
+    // results stay exactly the same, including the sign of 0
+    REQUIRE (t.getCellPointer(1, 0) != nullptr);
+    REQUIRE (FormulaProgram::compile("=A1 * 1").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE ((result == 0 && std::signbit(result)));
+    REQUIRE (FormulaProgram::compile("=A1 - 0").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE (std::signbit(result));
+    REQUIRE (FormulaProgram::compile("=A1 + 0").code().size() == 3);
+    REQUIRE (FormulaProgram::compile("=A1 + 0").evaluate(t, result) == FormulaProgram::Error::None);
+    REQUIRE_FALSE (std::signbit(result));
+
+    // failing operations are left for the evaluation
+    FormulaProgram division = FormulaProgram::compile("=1 / (2 - 2)");
+    REQUIRE (division.code().size() == 3);
+    REQUIRE (division.evaluate(t, result) == FormulaProgram::Error::DivideByZero);
+}
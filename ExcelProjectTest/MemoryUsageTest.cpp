@@ -0,0 +1,128 @@
+#include "catch_amalgamated.hpp"
+
+#include "../ExcelProject/MemoryUsage.h"
+#include "../ExcelProject/Table.h"
+#include "../ExcelProject/CellInt.h"
+#include "../ExcelProject/CellString.h"
+#include "../ExcelProject/CellFormula.h"
+#include "../ExcelProject/ControlCenter.h"
+
+TEST_CASE ("MemoryUsage :: heapBytes"){
+    std::string empty;
+    std::string small = "abc";
+    std::string large(100, 'x');
+    REQUIRE (MemoryUsage::heapBytes(empty) == 0);
+    REQUIRE (MemoryUsage::heapBytes(small) == 0);
+    REQUIRE (MemoryUsage::heapBytes(large) == large.capacity() + 1);
+}
+
+TEST_CASE ("MemoryUsage :: Cell::addMemoryUsage"){
+    Table t;
+    MemoryUsage usage;
+    CellInt(5).addMemoryUsage(usage);
+    CellString("\"" + std::string(50, 'x') + "\"").addMemoryUsage(usage);
+    REQUIRE (usage.ints.count == 1);
+    REQUIRE (usage.ints.bytes == sizeof(CellInt));
+    REQUIRE (usage.strings.count == 1);
+    REQUIRE (usage.strings.bytes == sizeof(CellString));
+    REQUIRE (usage.stringPayloads > 50);
+    REQUIRE (usage.blocks == 3);
+
+    CellFormula formula(&t, "=1+2+3+4+5+6+7+8+9+10");
+    formula.addMemoryUsage(usage);
+    REQUIRE (usage.formulas.count == 1);
+    REQUIRE (usage.formulas.bytes == sizeof(CellFormula));
+    REQUIRE (usage.formulaText > 20);
+    REQUIRE (usage.formulaPrograms >= sizeof(CellFormula::Template));
+    REQUIRE (usage.total() == usage.ints.bytes + usage.strings.bytes + usage.stringPayloads + usage.formulas.bytes +
+                               usage.formulaText + usage.formulaPrograms);
+}
+
+TEST_CASE ("Table :: memoryUsage"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "2");
+    t.setCellValue(2, 0, "3.5");
+    t.setCellValue(0, 1, "\"" + std::string(40, 'a') + "\"");
+    t.setCellValue(0, 2, "=A0+A1+A2+A0+A1+A2+A0+A1+A2");
+    MemoryUsage before = t.memoryUsage();
+    REQUIRE (before.ints.count == 2);
+    REQUIRE (before.doubles.count == 1);
+    REQUIRE (before.strings.count == 1);
+    REQUIRE (before.formulas.count == 1);
+    REQUIRE (before.stringPayloads > 40);
+    REQUIRE (before.grid >= 3 * sizeof(Column));
+    REQUIRE (before.dependencies > 0);
+
+    // filled formulas share the text and the program of their source
+    t.fill(0, 2, 1, 2, 9, 2);
+    MemoryUsage filled = t.memoryUsage();
+    REQUIRE (filled.formulas.count == 10);
+    REQUIRE (filled.formulas.bytes == 10 * sizeof(CellFormula));
+    REQUIRE (filled.formulaText == before.formulaText);
+    REQUIRE (filled.formulaPrograms == before.formulaPrograms);
+    REQUIRE (filled.dependencies > before.dependencies);
+
+    // typed values have no objects
+    t.setColumnar(true);
+    MemoryUsage columnar = t.memoryUsage();
+    REQUIRE (columnar.ints.count == 0);
+    REQUIRE (columnar.doubles.count == 3);
+    REQUIRE (columnar.doubles.bytes >= 10 * sizeof(double));
+    REQUIRE (columnar.strings.count == 1);
+    REQUIRE (columnar.formulas.count == 10);
+
+    // summaries of large ranges are remembered
+    Table large;
+    for(size_t row = 0; row < 2000; row++){
+        large.loadCellValue(row, 0, std::to_string(row));
+    }
+    uint64_t caches = large.memoryUsage().caches;
+    large.setCellValue(0, 1, "=SUM(A0:A1999)");
+    REQUIRE (large.memoryUsage().caches > caches);
+}
+
+TEST_CASE ("Table :: memoryUsage (filled range)"){
+    // the template shared by many formulas is counted once, not in parts rounded down to nothing
+    Table t;
+    t.setCellValue(0, 0, "=B0*2+B1*3");
+    t.fill(0, 0, 1, 0, 9999, 0);
+    MemoryUsage usage = t.memoryUsage();
+    REQUIRE (usage.formulas.count == 10000);
+    REQUIRE (usage.formulaText == 0);   // short enough to fit inside of the string object
+    REQUIRE (usage.formulaPrograms >= sizeof(CellFormula::Template));
+    REQUIRE (usage.formulaPrograms < 2 * sizeof(CellFormula::Template) + 1000);
+
+    t.setCellValue(0, 1, "=A0+A1+A2+A3+A4+A5+A6+A7+A8+A9+A10+A11+A12+A13+A14+A15");
+    t.fill(0, 1, 1, 1, 9999, 1);
+    usage = t.memoryUsage();
+    REQUIRE (usage.formulaText > 50);
+    REQUIRE (usage.formulaText < 200);
+}
+
+TEST_CASE ("MemoryUsage :: report"){
+    MemoryUsage usage;
+    REQUIRE (usage.report(0).find("total                           0 B    0.0%") != std::string::npos);
+
+    usage.ints.count = 3;
+    usage.ints.bytes = 300;
+    usage.grid = 100;
+    usage.blocks = 2;
+    std::string report = usage.report(100);
+    REQUIRE (report.find("integers                      300 B   75.0%  3 cells\n") == 0);
+    REQUIRE (report.find("grid                          100 B   25.0%\n") != std::string::npos);
+    REQUIRE (report.find("total                         400 B  100.0%\n") != std::string::npos);
+    REQUIRE (report.find("allocated blocks: 2 (about 16 B more used by the allocator)") != std::string::npos);
+    REQUIRE (report.find("csv size: 100 B, memory is 4.00x the csv size (4.16x with the allocator)") != std::string::npos);
+}
+
+TEST_CASE ("MemoryUsage :: ControlCenter MEMSTATS"){
+    ControlCenter cc;
+    REQUIRE_THROWS_AS (cc.executeCommand("MEMSTATS ALL"), std::invalid_argument);
+    cc.executeCommand("EDIT A0 5");
+    cc.executeCommand("EDIT B1 =A0+1");
+    // "5,\n,=A0+1"
+    std::string report = cc.executeCommand("memstats");
+    REQUIRE (report.find("csv size: 9 B, memory is ") != std::string::npos);
+    REQUIRE (report.find("formulas") != std::string::npos);
+}
@@ -0,0 +1,74 @@
+#include "catch_amalgamated.hpp"
+
+#include <fstream>
+
+#include "../ExcelProject/ResultSidecar.h"
+
+namespace{
+
+void fillTable(Table& t){
+    t.loadCellValue(0, 0, "2");
+    t.loadCellValue(1, 0, "=A0*3");
+    t.loadCellValue(2, 0, "=1/0");
+    t.loadCellValue(0, 1, "=SUM(A0:A1)");
+}
+
+}
+
+TEST_CASE ("ResultSidecar :: Fingerprint"){
+    ResultSidecar::Fingerprint a;
+    ResultSidecar::Fingerprint b;
+    REQUIRE (a.value() == b.value());
+    a.addLine("1,2");
+    a.addLine("");
+    a.addLine("3");
+    b.addLine("1,2");
+    b.addLine("3");
+    REQUIRE (a.value() == b.value());
+    b.addLine("4");
+    REQUIRE (a.value() != b.value());
+
+    ResultSidecar::Fingerprint c;
+    c.addLine("1,23");
+    REQUIRE (c.value() != a.value());
+}
+
+TEST_CASE ("ResultSidecar :: save, load"){
+    const std::string filename = "ResultSidecarTest.csv";
+    Table saved;
+    fillTable(saved);
+    saved.recalculateAllFormulas();
+    ResultSidecar::save(saved, filename, 42);
+
+    Table loaded;
+    fillTable(loaded);
+    REQUIRE (ResultSidecar::load(filename, 42, loaded));
+    REQUIRE (loaded.getDisplayableCellValue(1, 0) == "6");
+    REQUIRE (loaded.getDisplayableCellValue(2, 0) == "#DIV/0");
+    REQUIRE (loaded.getDisplayableCellValue(0, 1) == "8");
+
+    // another content of the file
+    Table other;
+    fillTable(other);
+    REQUIRE_FALSE (ResultSidecar::load(filename, 43, other));
+    REQUIRE (other.getDisplayableCellValue(1, 0) == "#VALUE");
+
+    // another formula on the same position
+    other.loadCellValue(1, 0, "=A0*4");
+    REQUIRE_FALSE (ResultSidecar::load(filename, 42, other));
+    REQUIRE (other.getDisplayableCellValue(0, 1) == "#VALUE");
+
+    // one formula more
+    other.loadCellValue(1, 0, "=A0*3");
+    other.loadCellValue(5, 5, "=1");
+    REQUIRE_FALSE (ResultSidecar::load(filename, 42, other));
+
+    {
+        std::ofstream file(ResultSidecar::pathFor(filename), std::ios::binary | std::ios::trunc);
+        file << "damaged";
+    }
+    REQUIRE_FALSE (ResultSidecar::load(filename, 42, loaded));
+
+    ResultSidecar::remove(filename);
+    REQUIRE_FALSE (ResultSidecar::load(filename, 42, loaded));
+}
@@ -0,0 +1,84 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../ExcelProject/ScriptRunner.h"
+#include "../ExcelProject/ResultSidecar.h"
+
+TEST_CASE ("ScriptRunner :: run"){
+    ControlCenter cc;
+    cc.setOverwrite(ControlCenter::Overwrite::Never);
+    ScriptRunner runner(cc, ScriptRunner::Options());
+    std::istringstream script("# a comment\n"
+                              "\n"
+                              "  EDIT A0 5  \r\n"
+                              "edit A1 =A0*2\n"
+                              "PRINT\n"
+                              "EDIT B0\n"
+                              "EDIT B1 7\n");
+    std::ostringstream output;
+    std::ostringstream errors;
+    REQUIRE (runner.run(script, output, errors) == 1);
+    REQUIRE (output.str().find("OK: Successfully set A0 to 5\nOK: Successfully set A1 to =A0*2\nOK: ") == 0);
+    REQUIRE (output.str().find("10") != std::string::npos);
+    REQUIRE (errors.str() == "FAIL (line 6: EDIT B0): Invalid use of command: edit <position> <value>\n");
+    // stopped at the failure
+    REQUIRE (cc.executeCommand("PRINT").find("7") == std::string::npos);
+
+    ScriptRunner::Options options;
+    options.keepGoing = true;
+    options.quiet = true;
+    ScriptRunner keepGoing(cc, options);
+    output.str("");
+    errors.str("");
+    REQUIRE (keepGoing.run({"EDIT B0", "UNKNOWN", "EDIT B1 7", "exit", "EDIT B2 8"}, output, errors) == 2);
+    REQUIRE (output.str().empty());
+    REQUIRE (errors.str().find("FAIL (line 2: UNKNOWN): Unknown command: UNKNOWN") != std::string::npos);
+    std::string printed = cc.executeCommand("PRINT");
+    REQUIRE (printed.find("7") != std::string::npos);
+    REQUIRE (printed.find("8") == std::string::npos);
+}
+
+TEST_CASE ("ScriptRunner :: ControlCenter::setOverwrite"){
+    const std::string filename = "ScriptRunnerTest.csv";
+    const std::string other = "ScriptRunnerTestOther.csv";
+    std::ofstream(filename) << "1,2";
+    std::ofstream(other) << "3";
+
+    ControlCenter cc;
+    REQUIRE (cc.overwrite() == ControlCenter::Overwrite::Ask);
+    cc.setOverwrite(ControlCenter::Overwrite::Never);
+    ScriptRunner runner(cc, ScriptRunner::Options());
+    std::ostringstream output;
+    std::ostringstream errors;
+    std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(errors.rdbuf());
+
+    // the opened file can be saved again, other files are not replaced
+    REQUIRE (runner.run({"OPEN " + filename, "EDIT A0 9", "SAVE"}, output, errors) == 0);
+    REQUIRE (runner.run({"SAVEAS " + other}, output, errors) == 1);
+    REQUIRE (errors.str().find("exists and overwriting is not allowed") != std::string::npos);
+    REQUIRE (runner.run({"NEW " + other}, output, errors) == 1);
+
+    cc.setOverwrite(ControlCenter::Overwrite::Always);
+    REQUIRE (runner.run({"OPEN " + filename, "SAVEAS " + other}, output, errors) == 0);
+    // unsaved changes are dropped with a warning instead of a question
+    errors.str("");
+    REQUIRE (runner.run({"EDIT B0 1", "CLOSE"}, output, errors) == 0);
+    REQUIRE (errors.str() == "Unsaved changes of " + filename + " dropped.\n");
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+
+    std::ifstream saved(other);
+    std::string line;
+    std::getline(saved, line);
+    REQUIRE (line == "9,2");
+    saved.close();
+
+    std::remove(filename.c_str());
+    std::remove(other.c_str());
+    ResultSidecar::remove(filename);
+    ResultSidecar::remove(other);
+}
@@ -0,0 +1,176 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../ExcelProject/Server.h"
+#include "../ExcelProject/ResultSidecar.h"
+
+namespace{
+
+    std::string execute(Server& server, Server::Session& session, const std::string& line){
+        std::string response;
+        bool quit = false;
+        if(!server.execute(session, line, response, quit)){
+            return "FAIL " + response;
+        }
+        return response;
+    }
+
+}
+
+TEST_CASE ("Server :: execute"){
+    const std::string filename = "ServerTest.csv";
+    std::ofstream(filename) << "1,2\n=A0+B0";
+
+    Server::Options options;
+    Server server(options);
+    Server::Session first = server.createSession();
+    Server::Session second = server.createSession();
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    // sessions have their own workbooks until they open the same file
+    execute(server, first, "EDIT A0 5");
+    REQUIRE (execute(server, second, "GET A0") == "");
+    REQUIRE (execute(server, first, "OPEN " + filename) == "Opened " + filename);
+    REQUIRE (execute(server, second, "open \"" + filename + "\"") == "Opened " + filename);
+    REQUIRE (first.workbook == second.workbook);
+    REQUIRE (execute(server, second, "GET A1") == "3");
+    execute(server, first, "EDIT B0 10");
+    REQUIRE (execute(server, second, "GET A1") == "11");
+
+    bool quit = false;
+    std::string response;
+    REQUIRE (server.execute(first, "QUIT", response, quit));
+    REQUIRE (quit);
+    REQUIRE (execute(server, first, "CLOSE") == "");
+    REQUIRE (first.workbook != second.workbook);
+    REQUIRE (execute(server, first, "GET A1") == "");
+    REQUIRE (execute(server, second, "GET A1") == "11");
+    REQUIRE (execute(server, first, "OPEN missing.csv").find("FAIL ") == 0);
+    REQUIRE (execute(server, first, "UNKNOWN") == "FAIL Unknown command: UNKNOWN");
+    std::cout.rdbuf(coutBuffer);
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
+
+TEST_CASE ("Server :: execute (reading while the workbook is changed)"){
+    Server::Options options;
+    Server server(options);
+    Server::Session writing = server.createSession();
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    execute(server, writing, "EDIT A0 5");
+    execute(server, writing, "EDIT A1 =A0*2");
+    Server::Session reading = writing;
+
+    // a command changing the workbook holds its lock (e.g. while saving it), reading does not wait for it
+    std::unique_lock<std::shared_mutex> writer(writing.workbook->mutex);
+    std::future<std::string> read = std::async(std::launch::async, [&server, &reading](){
+        return execute(server, reading, "GET A1");
+    });
+    REQUIRE (read.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    REQUIRE (read.get() == "10");
+
+    // another change waits, and is read after it is done
+    std::future<std::string> edit = std::async(std::launch::async, [&server, &reading](){
+        return execute(server, reading, "EDIT A0 6");
+    });
+    REQUIRE (edit.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+    writer.unlock();
+    REQUIRE (edit.get() == "Successfully set A0 to 6");
+    REQUIRE (execute(server, writing, "GET A1") == "12");
+    REQUIRE (execute(server, writing, "GET A0 A1").find("FAIL ") == 0);
+    std::cout.rdbuf(coutBuffer);
+}
+
+TEST_CASE ("Server :: execute (lazy workbook)"){
+    Server::Options options;
+    Server server(options);
+    Server::Session session = server.createSession();
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    execute(server, session, "CALCULATION LAZY");
+    execute(server, session, "EDIT A0 5");
+    execute(server, session, "EDIT A1 =A0*2");
+    execute(server, session, "EDIT A0 6");
+
+    // taking the copy after a change calculates nothing, reading it calculates in a copy of its own
+    REQUIRE (session.workbook->snapshot->hasDirtyFormulas());
+    REQUIRE (execute(server, session, "GET A1") == "12");
+    REQUIRE (execute(server, session, "PRINT").find("12") != std::string::npos);
+    REQUIRE (session.workbook->snapshot->hasDirtyFormulas());
+    std::cout.rdbuf(coutBuffer);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE ("Server :: run"){
+    const std::string filename = "ServerTestRun.csv";
+    std::ofstream(filename) << "=SUM(B0:B9),1";
+
+    Server::Options options;
+    options.socketPath = "ServerTest.sock";
+    options.threads = 2;
+    Server server(options);
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    std::thread serving([&server](){ server.run(); });
+
+    auto connect = [&options](){
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", options.socketPath.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        for(int attempt = 0; attempt < 200; attempt++){
+            if(::connect(fd, (sockaddr*)&address, sizeof(address)) == 0){
+                return fd;
+            }
+            usleep(10000);
+        }
+        return -1;
+    };
+    auto receiveAll = [](int fd){
+        std::string received;
+        char buffer[4096];
+        ssize_t n;
+        while((n = recv(fd, buffer, sizeof(buffer), 0)) > 0){
+            received.append(buffer, n);
+        }
+        close(fd);
+        return received;
+    };
+
+    int first = connect();
+    REQUIRE (first >= 0);
+    int second = connect();
+    REQUIRE (second >= 0);
+    std::string commands = "OPEN " + filename + "\nEDIT B1 2\n\nGET A0\nBAD\nQUIT\nGET A0\n";
+    REQUIRE (send(first, commands.data(), commands.size(), 0) == (ssize_t)commands.size());
+    REQUIRE (receiveAll(first) == "OK " + std::to_string(7 + filename.size()) + "\nOpened " + filename + "\n"
+                                  "OK 24\nSuccessfully set B1 to 2\n"
+                                  "OK 1\n3\n"
+                                  "FAIL 20\nUnknown command: BAD\n"
+                                  "OK 0\n\n");
+
+    // the workbook stays loaded, with the changes of the other session
+    commands = "OPEN " + filename + "\nGET A0";
+    REQUIRE (send(second, commands.data(), commands.size(), 0) == (ssize_t)commands.size());
+    shutdown(second, SHUT_WR);
+    std::string received = receiveAll(second);
+    REQUIRE (received.substr(received.size() - 7) == "OK 1\n3\n");
+
+    server.stop();
+    serving.join();
+    std::cout.rdbuf(coutBuffer);
+    REQUIRE (std::ifstream(options.socketPath).fail());
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
+#endif
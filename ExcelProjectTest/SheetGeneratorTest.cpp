@@ -0,0 +1,161 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+
+#include "../ExcelProject/SheetGenerator.h"
+#include "../ExcelProject/ControlCenter.h"
+#include "../ExcelProject/ResultSidecar.h"
+#include "../ExcelProject/CellRef.h"
+
+TEST_CASE ("SheetGenerator :: SheetGenerator"){
+    SheetGenerator::Options options;
+    options.rows = 0;
+    REQUIRE_THROWS_AS (SheetGenerator(options), std::invalid_argument);
+    options.rows = 5;
+    options.strings = -1;
+    REQUIRE_THROWS_AS (SheetGenerator(options), std::invalid_argument);
+    options = SheetGenerator::Options();
+    options.integers = options.doubles = options.strings = options.formulas = options.empty = 0;
+    REQUIRE_THROWS_AS (SheetGenerator(options), std::invalid_argument);
+    options = SheetGenerator::Options();
+    options.ranges = 1.5;
+    REQUIRE_THROWS_AS (SheetGenerator(options), std::invalid_argument);
+    options.ranges = 0;
+    options.chainDepth = 0;
+    REQUIRE_THROWS_AS (SheetGenerator(options), std::invalid_argument);
+}
+
+TEST_CASE ("SheetGenerator :: cellValue"){
+    SheetGenerator::Options options;
+    options.rows = 200;
+    options.columns = 6;
+    SheetGenerator first(options);
+    SheetGenerator same(options);
+    options.seed = 2;
+    SheetGenerator other(options);
+
+    std::string a, b, c;
+    size_t differences = 0;
+    size_t formulas = 0;
+    for(size_t row = 0; row < 200; row++){
+        for(size_t col = 0; col < 6; col++){
+            first.cellValue(row, col, a);
+            same.cellValue(row, col, b);
+            other.cellValue(row, col, c);
+            REQUIRE (a == b);
+            differences += a != c;
+            formulas += !a.empty() && a[0] == '=';
+            if(col == 0){
+                REQUIRE_FALSE (a.empty());
+            }
+        }
+    }
+    REQUIRE (differences > 900);
+    REQUIRE (formulas > 150);
+    REQUIRE (formulas < 330);
+
+    // only formulas
+    options.integers = options.doubles = options.strings = options.empty = 0;
+    SheetGenerator formulasOnly(options);
+    formulasOnly.cellValue(10, 3, a);
+    REQUIRE (a[0] == '=');
+}
+
+TEST_CASE ("SheetGenerator :: cellValue (formulas)"){
+    SheetGenerator::Options options;
+    options.rows = 100;
+    options.columns = 5;
+    options.integers = options.strings = options.empty = 0;
+    options.doubles = 1;
+    options.formulas = 3;
+    options.ranges = 0;
+    options.references = 3;
+    options.chainDepth = 4;
+    SheetGenerator generator(options);
+
+    // chains of formulas end every chainDepth rows, other references are to cells which are not formulas
+    std::string value;
+    size_t chained = 0;
+    for(size_t row = 1; row < options.rows; row++){
+        for(size_t col = 0; col < options.columns; col++){
+            if(generator.kind(row, col) != SheetGenerator::Kind::Formula ||
+               generator.kind(row - 1, col) != SheetGenerator::Kind::Formula){
+                continue;
+            }
+            generator.cellValue(row, col, value);
+            CellRef above(row - 1, col);
+            bool chain = row % 4 != 0;
+            REQUIRE ((value.compare(1, above.toString().size() + 1, above.toString() + "+") == 0 ||
+                      value.compare(1, above.toString().size() + 1, above.toString() + "-") == 0 ||
+                      value.compare(1, above.toString().size() + 1, above.toString() + "*") == 0) == chain);
+            chained += chain;
+        }
+    }
+    REQUIRE (chained > 100);
+
+    Table t;
+    generator.fill(t);
+    REQUIRE (t.formulasCount() > 300);
+
+    // every reference to a shared cell of the first row, every formula on a range
+    options.sharedCells = 2;
+    options.sharedReferences = 1;
+    options.chainDepth = 1;
+    SheetGenerator shared(options);
+    shared.cellValue(50, 3, value);
+    REQUIRE (shared.kind(50, 3) == SheetGenerator::Kind::Formula);
+    REQUIRE (value.size() == 9);
+    for(size_t i = 1; i < 9; i += 3){
+        REQUIRE ((value[i] == 'A' || value[i] == 'B'));
+        REQUIRE (value[i + 1] == '0');
+    }
+    options.ranges = 1;
+    SheetGenerator ranges(options);
+    ranges.cellValue(50, 3, value);
+    REQUIRE (value.find(':') != std::string::npos);
+
+    options.strings = 1;
+    options.formulas = 0;
+    options.distinctStrings = 1;
+    SheetGenerator strings(options);
+    for(size_t row = 0; row < 20; row++){
+        if(strings.kind(row, 2) == SheetGenerator::Kind::String){
+            strings.cellValue(row, 2, value);
+            REQUIRE (value == "\"item 0\"");
+        }
+    }
+}
+
+TEST_CASE ("SheetGenerator :: fill, writeCsv"){
+    const std::string filename = "SheetGeneratorTest.csv";
+    SheetGenerator::Options options;
+    options.rows = 300;
+    options.columns = 7;
+    options.seed = 42;
+    SheetGenerator generator(options);
+
+    Table t;
+    t.setLazyCalculation(true);
+    generator.fill(t);
+    REQUIRE (t.isLazyCalculation());
+    REQUIRE (t.rowsCount() == 300);
+    REQUIRE (t.columnsCount() == 7);
+    REQUIRE (t.formulasCount() > 0);
+    std::string value;
+    for(size_t col = 0; col < 7; col++){
+        generator.cellValue(17, col, value);
+        if(value.empty() || value[0] == '='){
+            REQUIRE (t.getConstructedCellValue(17, col) == value);
+        }
+    }
+
+    // the file is read back as the same table
+    REQUIRE (generator.writeCsv(filename) > 0);
+    ResultSidecar::remove(filename);
+    ControlCenter cc;
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    cc.executeCommand("OPEN " + filename);
+    std::cout.rdbuf(coutBuffer);
+    REQUIRE (cc.executeCommand("PRINT") == t.print());
+    std::remove(filename.c_str());
+}
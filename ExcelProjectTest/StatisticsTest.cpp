@@ -0,0 +1,141 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "../ExcelProject/Statistics.h"
+#include "../ExcelProject/ControlCenter.h"
+#include "../ExcelProject/ResultSidecar.h"
+
+TEST_CASE ("Statistics :: Histogram"){
+    Statistics::Histogram h;
+    h.add(0.5e-6);
+    h.add(3e-6);
+    h.add(0.002);
+    REQUIRE (h.count == 3);
+    REQUIRE (h.min == 0.5e-6);
+    REQUIRE (h.max == 0.002);
+    REQUIRE (h.total == Catch::Approx(0.0020035));
+    REQUIRE (h.buckets[0] == 1);
+    // 3 microseconds are between 2 and 4
+    REQUIRE (h.buckets[2] == 1);
+    // 2000 microseconds are between 1024 and 2048
+    REQUIRE (h.buckets[11] == 1);
+
+    // longer than the last bucket
+    h.add(1e9);
+    REQUIRE (h.buckets[Statistics::Histogram::BUCKETS - 1] == 1);
+}
+
+TEST_CASE ("Statistics :: record, report, reset"){
+    Statistics stats;
+    REQUIRE (stats.histogram("EDIT").count == 0);
+    REQUIRE (stats.report().find("No commands recorded.") == 0);
+
+    stats.record("EDIT", 0.001);
+    stats.record("EDIT", 0.003);
+    {
+        Statistics::Timer timer(stats, "PRINT");
+    }
+    {
+        Statistics::Timer timer(stats, "FAILED");
+        timer.cancel();
+    }
+    REQUIRE (stats.histogram("EDIT").count == 2);
+    REQUIRE (stats.histogram("EDIT").total == Catch::Approx(0.004));
+    REQUIRE (stats.histogram("PRINT").count == 1);
+    REQUIRE (stats.histogram("FAILED").count == 0);
+
+    std::string report = stats.report();
+    REQUIRE (report.find("EDIT: 2x, total 4.0 ms, mean 2.0 ms, min 1.0 ms, max 3.0 ms") != std::string::npos);
+    REQUIRE (report.find("PRINT: 1x") != std::string::npos);
+    REQUIRE (report.find("cells created: ") != std::string::npos);
+
+    stats.reset();
+    REQUIRE (stats.histogram("EDIT").count == 0);
+}
+
+TEST_CASE ("Statistics :: countersSinceReset"){
+    Statistics stats;
+    Table t;
+    t.setCellValue(0, 0, "2");
+    t.setCellValue(1, 0, "=A0*3");
+    t.setCellValue(0, 0, "4");
+    std::unique_ptr<int> allocated(new int(1));
+
+    Statistics::Counters work = stats.countersSinceReset();
+    REQUIRE (work.cellsCreated == 3);
+    REQUIRE (work.formulasEvaluated == 2);
+    REQUIRE (work.allocations > 0);
+
+    stats.reset();
+    REQUIRE (stats.countersSinceReset().cellsCreated == 0);
+}
+
+TEST_CASE ("Statistics :: countAllocation"){
+    // every thread counts in a counter of its own, the counters of the process are their sum
+    Statistics stats;
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < 4; i++){
+        threads.emplace_back([]{
+            // called directly, as the compiler may leave out a new expression whose memory is not used
+            for(size_t j = 0; j < 1000; j++){
+                operator delete(operator new(sizeof(int)));
+            }
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    REQUIRE (stats.countersSinceReset().allocations >= 4000);
+
+    // the new handler is called until the memory can be allocated
+    static int handlerCalls;
+    handlerCalls = 0;
+    std::set_new_handler([]{
+        handlerCalls++;
+        std::set_new_handler(nullptr);
+    });
+    REQUIRE_THROWS_AS (operator new(SIZE_MAX / 2), std::bad_alloc);
+    REQUIRE (handlerCalls == 1);
+    REQUIRE (std::get_new_handler() == nullptr);
+}
+
+TEST_CASE ("Statistics :: ControlCenter STATS"){
+    const std::string filename = "StatisticsTest.csv";
+    ControlCenter cc;
+    REQUIRE_THROWS_AS (cc.executeCommand("STATS SOMETHING"), std::invalid_argument);
+    REQUIRE_THROWS_AS (cc.executeCommand("STATS RESET NOW"), std::invalid_argument);
+
+    cc.executeCommand("EDIT A0 5");
+    cc.executeCommand("EDIT A1 =A0+1");
+    REQUIRE_THROWS_AS (cc.executeCommand("EDIT A2"), std::invalid_argument);
+    REQUIRE_THROWS_AS (cc.executeCommand("UNKNOWN"), std::invalid_argument);
+    std::remove(filename.c_str());
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    cc.executeCommand("SAVEAS " + filename);
+    cc.executeCommand("OPEN " + filename);
+    std::cout.rdbuf(coutBuffer);
+
+    std::string report = cc.executeCommand("STATS");
+    // the failed command is recorded too, the unknown one is not
+    REQUIRE (report.find("EDIT: 3x") != std::string::npos);
+    REQUIRE (report.find("UNKNOWN") == std::string::npos);
+    REQUIRE (report.find("SAVEAS: 1x") != std::string::npos);
+    REQUIRE (report.find("OPEN: 1x") != std::string::npos);
+    for(const char* phase : {"load: read", "load: parse", "load: type", "load: recalc",
+                             "save: format", "save: write", "save: results"}){
+        REQUIRE (report.find(std::string(phase) + ": 1x") != std::string::npos);
+    }
+    // "5\n=A0+1" written and read back
+    REQUIRE (report.find("bytes read: 7, bytes written: 7") != std::string::npos);
+
+    REQUIRE (cc.executeCommand("stats reset") == "Statistics reset");
+    REQUIRE (cc.executeCommand("STATS").find("No commands recorded.") == 0);
+
+    std::remove(filename.c_str());
+    ResultSidecar::remove(filename);
+}
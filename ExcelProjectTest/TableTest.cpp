@@ -0,0 +1,723 @@
+#include "catch_amalgamated.hpp"
+
+#include <thread>
+#include <chrono>
+
+#include "../ExcelProject/Table.h"
+#include "../ExcelProject/CellInt.h"
+#include "../ExcelProject/CellDouble.h"
+#include "../ExcelProject/CellString.h"
+#include "../ExcelProject/CellFormula.h"
+
+TEST_CASE ("Table :: setCellValue (types)"){
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        t.setCellValue(0, 0, "5");
+        t.setCellValue(0, 1, "2.5");
+        t.setCellValue(0, 2, "\"str\"");
+        t.setCellValue(0, 3, "=A0*2");
+
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(0, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellDouble*>(t.getCellPointer(0, 1)) != nullptr);
+        REQUIRE (dynamic_cast<const CellString*>(t.getCellPointer(0, 2)) != nullptr);
+        REQUIRE (dynamic_cast<const CellFormula*>(t.getCellPointer(0, 3)) != nullptr);
+        REQUIRE (t.getCellPointer(1, 0) == nullptr);
+        REQUIRE (t.getCellPointer(0, 5) == nullptr);
+
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "5");
+        REQUIRE (t.getDisplayableCellValue(0, 1) == "2.5");
+        REQUIRE (t.getDisplayableCellValue(0, 2) == "str");
+        REQUIRE (t.getConstructedCellValue(0, 2) == "\"str\"");
+        REQUIRE (t.getDisplayableCellValue(0, 3) == "10");
+        REQUIRE (t.getConstructedCellValue(0, 3) == "=A0*2");
+
+        REQUIRE_THROWS_AS (t.setCellValue(0, 0, "str"), std::invalid_argument);
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "5");
+    }
+}
+
+TEST_CASE ("Table :: setColumnar (mixed types in a column)"){
+    Table t;
+    t.setColumnar(true);
+    t.setCellValue(0, 0, "1");
+    t.setCellValue(1, 0, "\"text\"");
+    t.setCellValue(2, 0, "2.5");
+    t.setCellValue(3, 0, "=SUM(A0:A2)");
+    t.setCellValue(0, 1, "\"a\"");
+    t.setCellValue(1, 1, "7");
+
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "text");
+    REQUIRE (t.getDisplayableCellValue(3, 0) == "3.5");
+    REQUIRE (t.getDisplayableCellValue(1, 1) == "7");
+
+    CellFormula cf(&t, "=SUM(A0:B3)+COUNT(A0:B3)");
+    REQUIRE (cf.getValue() == 14 + 4);
+
+    // converting back and forth keeps every value
+    std::string printed = t.print();
+    t.setColumnar(false);
+    REQUIRE (t.print() == printed);
+    t.setColumnar(true);
+    REQUIRE (t.print() == printed);
+}
+
+TEST_CASE ("Table :: getCellPointer (typed value replaced)"){
+    Table t;
+    t.setColumnar(true);
+    t.setCellValue(0, 0, "1");
+    const CellInt* ci = dynamic_cast<const CellInt*>(t.getCellPointer(0, 0));
+    REQUIRE (ci != nullptr);
+    REQUIRE (ci->getValue() == 1);
+    REQUIRE (t.getCellPointer(0, 0) == ci);
+
+    t.setCellValue(0, 0, "2");
+    ci = dynamic_cast<const CellInt*>(t.getCellPointer(0, 0));
+    REQUIRE (ci != nullptr);
+    REQUIRE (ci->getValue() == 2);
+
+    t.deleteCellValue(0, 0);
+    REQUIRE (t.getCellPointer(0, 0) == nullptr);
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "");
+}
+
+TEST_CASE ("Table :: getCellPointer (integers among floating numbers)"){
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        t.setCellValue(0, 0, "5");
+        t.setCellValue(1, 0, "2.5");
+        t.setCellValue(2, 0, "7");
+        t.setCellValue(0, 1, "-1.5");
+        t.setCellValue(1, 1, "3");
+
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(0, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellDouble*>(t.getCellPointer(1, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(2, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellDouble*>(t.getCellPointer(0, 1)) != nullptr);
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(1, 1)) != nullptr);
+        REQUIRE (t.getConstructedCellValue(2, 0) == "7");
+        REQUIRE (t.getDisplayableCellValue(1, 1) == "3");
+
+        // converting to the other way and back keeps the types
+        t.setColumnar(!columnar);
+        t.setColumnar(columnar);
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(0, 0)) != nullptr);
+        REQUIRE (dynamic_cast<const CellInt*>(t.getCellPointer(1, 1)) != nullptr);
+        REQUIRE (dynamic_cast<const CellDouble*>(t.getCellPointer(1, 0)) != nullptr);
+
+        // replacing an integer with a floating number
+        t.setCellValue(2, 0, "7.5");
+        REQUIRE (dynamic_cast<const CellDouble*>(t.getCellPointer(2, 0)) != nullptr);
+        REQUIRE (t.getDisplayableCellValue(2, 0) == "7.5");
+    }
+}
+
+TEST_CASE ("Column :: getCellPointer (integers larger than an int)"){
+    // such integers can only come from a binary workbook, as text they are floating numbers
+    Column ints;
+    ints.resize(2);
+    REQUIRE (ints.setInt(0, 3000000000LL));
+    REQUIRE (ints.setInt(1, 7));
+    Column doubles;
+    doubles.resize(2);
+    REQUIRE (doubles.setDouble(0, 1.5));
+    REQUIRE (doubles.setInt(1, -3000000000LL));
+
+    const CellDouble* large = dynamic_cast<const CellDouble*>(ints.getCellPointer(0));
+    REQUIRE (large != nullptr);
+    REQUIRE (large->getValue() == 3000000000.0);
+    REQUIRE (dynamic_cast<const CellInt*>(ints.getCellPointer(1)) != nullptr);
+    const CellDouble* small = dynamic_cast<const CellDouble*>(doubles.getCellPointer(1));
+    REQUIRE (small != nullptr);
+    REQUIRE (small->getValue() == -3000000000.0);
+    std::string buffer;
+    REQUIRE (ints.getDisplayableView(0, buffer) == "3000000000");
+}
+
+TEST_CASE ("Table :: setCellValue (invalid value changes nothing)"){
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        t.setCellValue(0, 0, "5");
+        t.setCellValue(1, 0, "2.5");
+        Table copy(t);
+
+        REQUIRE_THROWS_AS (t.setCellValue(998, 25, "abc"), std::invalid_argument);
+        REQUIRE_THROWS_AS (t.setCellValue(1, 0, "abc"), std::invalid_argument);
+        REQUIRE (t.rowsCount() == 2);
+        REQUIRE (t.columnsCount() == 1);
+        REQUIRE (t.getConstructedCellValue(0, 0) == "5");
+        REQUIRE (t.getConstructedCellValue(1, 0) == "2.5");
+        // the column is still shared with the copy
+        REQUIRE (&t.columnAt(0) == &copy.columnAt(0));
+    }
+}
+
+TEST_CASE ("Table :: aggregateRange (large columns)"){
+    Table cells;
+    Table columns;
+    columns.setColumnar(true);
+    for(size_t row = 0; row < 1000; row++){
+        std::string value = (row % 7 == 0) ? std::to_string(row) + ".5" : std::to_string(row);
+        cells.setCellValue(row, 0, value);
+        columns.setCellValue(row, 0, value);
+    }
+
+    Table::RangeAggregate a = cells.aggregateRange(3, 0, 998, 0);
+    Table::RangeAggregate b = columns.aggregateRange(998, 0, 3, 0);
+    REQUIRE (a.count == 996);
+    REQUIRE (b.count == 996);
+    REQUIRE (a.sum == b.sum);
+    REQUIRE (a.min == 3);
+    REQUIRE (b.min == 3);
+    REQUIRE (a.max == 998);
+    REQUIRE (b.max == 998);
+}
+
+TEST_CASE ("Table :: operator= (formulas refer to the copy)"){
+    Table t;
+    t.setCellValue(0, 0, "5");
+    t.setCellValue(0, 1, "=A0+1");
+
+    Table copy;
+    copy = t;
+    copy.setCellValue(0, 0, "10");
+    REQUIRE (copy.getDisplayableCellValue(0, 1) == "11");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "6");
+
+    Table other(t);
+    other.setCellValue(0, 0, "1");
+    REQUIRE (other.getDisplayableCellValue(0, 1) == "2");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "6");
+}
+
+TEST_CASE ("Table :: operator= (snapshot while the table changes)"){
+    Table t;
+    t.setColumnar(true);
+    t.setLazyCalculation(true);
+    for(size_t row = 0; row < 100; row++){
+        t.setCellValue(row, 0, std::to_string(row));
+        t.setCellValue(row, 1, "=A" + std::to_string(row) + "*2");
+    }
+    t.setCellValue(0, 2, "=SUM(B0:B99)");
+
+    // the copy shares the columns and calculates its dirty formulas in its own copies of them
+    Table snapshot(t);
+    REQUIRE (&snapshot.columnAt(0) == &t.columnAt(0));
+    REQUIRE (&snapshot.columnAt(2) == &t.columnAt(2));
+    REQUIRE (snapshot.getDisplayableCellValue(0, 2) == "9900");
+    REQUIRE (&snapshot.columnAt(2) != &t.columnAt(2));
+    REQUIRE (t.hasDirtyFormulas());
+    REQUIRE (!snapshot.hasDirtyFormulas());
+    t.calculateDirtyFormulas();
+    REQUIRE (&snapshot.columnAt(1) != &t.columnAt(1));
+
+    // only the changed columns are copied
+    REQUIRE (&snapshot.columnAt(0) == &t.columnAt(0));
+    t.setCellValue(1, 0, "1000");
+    REQUIRE (&snapshot.columnAt(0) != &t.columnAt(0));
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "11898");
+    REQUIRE (snapshot.getDisplayableCellValue(1, 0) == "1");
+    REQUIRE (snapshot.getDisplayableCellValue(1, 1) == "2");
+    REQUIRE (snapshot.getDisplayableCellValue(0, 2) == "9900");
+
+    // formulas of the copy are calculated on the copy, even after the original is gone
+    Table* original = new Table(t);
+    Table copy(*original);
+    delete original;
+    copy.setCellValue(0, 0, "5");
+    REQUIRE (copy.getDisplayableCellValue(0, 2) == "11908");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "11898");
+
+    // a snapshot is read by another thread while the table changes
+    Table shared(t);
+    bool consistent = true;
+    std::thread reader([&shared, &consistent](){
+        for(int i = 0; i < 20; i++){
+            consistent = consistent && shared.aggregateRange(0, 1, 99, 1).sum == 11898 &&
+                         shared.print().find("1000") != std::string::npos;
+        }
+    });
+    for(size_t row = 0; row < 100; row++){
+        t.setCellValue(row, 0, "1");
+    }
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "200");
+    reader.join();
+    REQUIRE (consistent);
+}
+
+TEST_CASE ("Table :: getCellPointer (concurrent readers of a columnar copy)"){
+    Table t;
+    t.setColumnar(true);
+    for(size_t row = 0; row < 200; row++){
+        t.setCellValue(row, 0, std::to_string(row));
+        t.setCellValue(row, 1, std::to_string(row) + ".5");
+        t.setCellValue(row, 2, "\"s" + std::to_string(row) + "\"");
+    }
+    t.setCellValue(0, 3, "=SUM(A0:A199)");
+
+    // readers of one copy change nothing in it, not even the cells created for typed values
+    std::shared_ptr<const Table> snapshot = std::make_shared<const Table>(t);
+    std::vector<std::thread> readers;
+    std::vector<int> consistent(4, 1);
+    for(size_t i = 0; i < consistent.size(); i++){
+        readers.emplace_back([&snapshot, &consistent, i](){
+            std::unique_ptr<Cell> intBuffer, doubleBuffer;
+            std::string text;
+            for(int pass = 0; pass < 5; pass++){
+                for(size_t row = 0; row < 200; row++){
+                    const CellInt* ci = dynamic_cast<const CellInt*>(snapshot->getCellPointer(row, 0, intBuffer));
+                    const CellDouble* cd = dynamic_cast<const CellDouble*>(snapshot->getCellPointer(row, 1, doubleBuffer));
+                    consistent[i] = consistent[i] && ci != nullptr && ci->getValue() == (int)row && cd != nullptr &&
+                                    snapshot->getDisplayableCellView(row, 2, text) == "s" + std::to_string(row);
+                }
+                consistent[i] = consistent[i] && snapshot->print().find("19900") != std::string::npos &&
+                                snapshot->memoryUsage().ints.count == 200;
+            }
+        });
+    }
+    for(size_t row = 0; row < 200; row++){
+        t.setCellValue(row, 0, "1");
+    }
+    for(std::thread& reader : readers){
+        reader.join();
+    }
+    REQUIRE (consistent == std::vector<int>(4, 1));
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "200");
+    std::string buffer;
+    REQUIRE (snapshot->getDisplayableCellView(0, 3, buffer) == "19900");
+}
+
+TEST_CASE ("Table :: setCellValue (dependent formulas)"){
+    Table t;
+    // calculating the formulas row by row would read B5 before it is updated
+    t.setCellValue(9, 2, "1");
+    t.setCellValue(5, 1, "=C9*2");
+    t.setCellValue(0, 0, "=B5+1");
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "3");
+
+    t.setCellValue(9, 2, "2");
+    REQUIRE (t.getDisplayableCellValue(5, 1) == "4");
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "5");
+
+    t.deleteCellValue(9, 2);
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "1");
+
+    // a formula refering to a cell before it exists
+    t.setCellValue(0, 3, "=E0");
+    t.setCellValue(0, 4, "7");
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "7");
+}
+
+TEST_CASE ("Table :: setCellValue (circular formulas)"){
+    Table t;
+    t.setCellValue(0, 0, "=B0");
+    t.setCellValue(0, 1, "=A0+1");
+    t.setCellValue(0, 2, "=B0*2");
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "#CYCLE");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "#CYCLE");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "#CYCLE");
+
+    t.setCellValue(0, 1, "3");
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "3");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "6");
+
+    t.setCellValue(1, 0, "=SUM(A0:A1)");
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "#CYCLE");
+    t.setCellValue(1, 0, "=SUM(A0:A0)");
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "3");
+}
+
+TEST_CASE ("Table :: getFormulaError, findRangeError"){
+    Table t;
+    t.setCellValue(0, 0, "=1/0");
+    t.setCellValue(1, 0, "=A0 + 1");
+    t.setCellValue(2, 0, "=AVERAGE(D0:D5)");
+    t.setCellValue(0, 1, "=SUM(A1:A2)");
+    t.setCellValue(1, 1, "=COUNT(A0:A2) + 1");
+    t.setCellValue(2, 1, "=B2");
+    t.setCellValue(0, 2, "=MAX(A0:B2)");
+
+    // errors are carried by value to the formulas referring to them
+    REQUIRE (t.getFormulaError(0, 0) == FormulaProgram::Error::DivideByZero);
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "#DIV/0");
+    REQUIRE (t.getDisplayableCellValue(2, 0) == "#DIV/0");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "#DIV/0");
+    REQUIRE (t.getDisplayableCellValue(1, 1) == "1");
+    REQUIRE (t.getFormulaError(2, 1) == FormulaProgram::Error::Cycle);
+    REQUIRE (t.getFormulaError(1, 1) == FormulaProgram::Error::None);
+    REQUIRE (t.getFormulaError(5, 5) == FormulaProgram::Error::None);
+
+    REQUIRE (t.findRangeError(1, 1, 2, 1) == FormulaProgram::Error::Cycle);
+    REQUIRE (t.findRangeError(2, 1, 0, 0) == FormulaProgram::Error::DivideByZero);
+    REQUIRE (t.findRangeError(1, 1, 1, 1) == FormulaProgram::Error::None);
+    REQUIRE (t.getFormulaError(0, 2) == FormulaProgram::Error::DivideByZero);
+
+    t.setCellValue(0, 0, "=\"text\" + 1");
+    REQUIRE (t.getDisplayableCellValue(0, 0) == "#VALUE");
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "#VALUE");
+    t.setCellValue(0, 0, "2");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "#DIV/0");
+    t.setCellValue(2, 3, "4");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "7");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "#CYCLE");
+}
+
+TEST_CASE ("Table :: setCellValue (long chain of formulas)"){
+    Table t;
+    t.setCellValue(0, 0, "1");
+    for(size_t row = 1; row < 20000; row++){
+        t.setCellValue(row, 0, "=A" + std::to_string(row - 1) + "+1");
+    }
+    t.setCellValue(0, 0, "2");
+    REQUIRE (t.getDisplayableCellValue(19999, 0) == "20001");
+}
+
+TEST_CASE ("Table :: aggregateRange (updated after edits)"){
+    const size_t rows = 5000;
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        for(size_t row = 0; row < rows; row++){
+            t.setCellValue(row, 0, std::to_string(row));
+        }
+        t.setCellValue(0, 1, "=SUM(A0:A4999)");
+        t.setCellValue(1, 1, "=MIN(A0:A4999)");
+        t.setCellValue(2, 1, "=MAX(A0:A4999)");
+        t.setCellValue(3, 1, "=COUNT(A0:A4999)");
+        double sum = rows * (rows - 1) / 2;
+        REQUIRE (t.getDisplayableCellValue(0, 1) == CellDouble(sum).getDisplayableString());
+
+        t.setCellValue(10, 0, "-5.5");
+        sum += -5.5 - 10;
+        REQUIRE (t.getDisplayableCellValue(0, 1) == CellDouble(sum).getDisplayableString());
+        REQUIRE (t.getDisplayableCellValue(1, 1) == "-5.5");
+
+        t.setCellValue(4999, 0, "\"text\"");
+        sum -= 4999;
+        REQUIRE (t.getDisplayableCellValue(0, 1) == CellDouble(sum).getDisplayableString());
+        REQUIRE (t.getDisplayableCellValue(2, 1) == "4998");
+        REQUIRE (t.getDisplayableCellValue(3, 1) == "4999");
+
+        t.deleteCellValue(10, 0);
+        sum += 5.5;
+        REQUIRE (t.getDisplayableCellValue(0, 1) == CellDouble(sum).getDisplayableString());
+        REQUIRE (t.getDisplayableCellValue(1, 1) == "0");
+        REQUIRE (t.getDisplayableCellValue(3, 1) == "4998");
+
+        t.setCellValue(20, 0, "=1/0");
+        REQUIRE (t.getDisplayableCellValue(0, 1) == "#DIV/0");
+        REQUIRE (t.getDisplayableCellValue(3, 1) == "4997");
+        t.setCellValue(20, 0, "=10*2");
+        REQUIRE (t.getDisplayableCellValue(0, 1) == CellDouble(sum).getDisplayableString());
+
+        // the same summary as a table reading the whole range again
+        Table fresh;
+        for(size_t row = 0; row < rows; row++){
+            if(row != 10){
+                fresh.setCellValue(row, 0, t.getConstructedCellValue(row, 0));
+            }
+        }
+        Table::RangeAggregate a = t.aggregateRange(0, 0, rows - 1, 0);
+        Table::RangeAggregate b = fresh.aggregateRange(0, 0, rows - 1, 0);
+        REQUIRE (a.sum == b.sum);
+        REQUIRE (a.min == b.min);
+        REQUIRE (a.max == b.max);
+        REQUIRE (a.count == b.count);
+    }
+}
+
+TEST_CASE ("Table :: aggregateRange (range outside of the table)"){
+    Table t;
+    for(size_t row = 0; row < 2000; row++){
+        t.setCellValue(row, 0, "1");
+    }
+    t.setCellValue(0, 1, "=SUM(A0:A2999)");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "2000");
+    t.setCellValue(2500, 0, "5");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "2005");
+    t.setCellValue(2999, 0, "1");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "2006");
+}
+
+TEST_CASE ("Table :: aggregateRange (overlapping sliding windows)"){
+    const size_t rows = 20000;
+    const size_t window = 1024;
+    Table t;
+    t.setColumnar(true);
+    for(size_t row = 0; row < rows; row++){
+        t.setCellValue(row, 0, std::to_string(row % 1000));
+    }
+    t.setCellValue(0, 1, "=MIN(A0:A1023)");
+    t.setCellValue(0, 2, "=SUM(A0:A1023)");
+    t.fill(0, 1, 1, 1, rows - window, 1);
+    t.fill(0, 2, 1, 2, rows - window, 2);
+    REQUIRE (t.getDisplayableCellValue(500, 1) == "0");
+    REQUIRE (t.getDisplayableCellValue(rows - window, 2) == t.getDisplayableCellValue(rows - window - 1000, 2));
+
+    // every window of the column shares one tree of a few bytes per row
+    REQUIRE (t.aggregateCachesCount() == 1);
+    REQUIRE (t.memoryUsage().caches < rows * 4);
+
+    // an edit updates one tree, instead of every window containing the cell
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < 100; i++){
+        t.setCellValue(5000 + i, 0, "-" + std::to_string(i + 1));
+    }
+    REQUIRE (std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    REQUIRE (t.getDisplayableCellValue(5000 + 99 - window + 1, 1) == "-100");
+    REQUIRE (t.getDisplayableCellValue(5100, 1) == "0");
+    REQUIRE (t.getDisplayableCellValue(5000 - window + 1, 1) == "-1");
+
+    // the tree is dropped with the last formula which needs it
+    for(size_t row = 0; row <= rows - window; row++){
+        t.deleteCellValue(row, 1);
+    }
+    REQUIRE (t.aggregateCachesCount() == 1);
+    for(size_t row = 0; row <= rows - window; row++){
+        t.deleteCellValue(row, 2);
+    }
+    REQUIRE (t.aggregateCachesCount() == 0);
+}
+
+TEST_CASE ("Table :: setCellValue (multi-letter columns)"){
+    Table t;
+    t.setCellValue(0, 26, "5");
+    t.setCellValue(1, 300, "=AA0*2");
+    t.setCellValue(2, 0, "=SUM(A0:KO1)+kO1");
+    REQUIRE (t.columnsCount() == 301);
+    REQUIRE (t.getDisplayableCellValue(1, 300) == "10");
+    REQUIRE (t.getDisplayableCellValue(2, 0) == "25");
+    REQUIRE (Table::getColumn("KO1") == 300);
+    REQUIRE (Table::getRow("KO1") == 1);
+    REQUIRE_THROWS_AS (Table::getColumn("A"), std::invalid_argument);
+
+    std::string printed = t.print();
+    REQUIRE (printed.find("| Z | AA | AB |") != std::string::npos);
+    REQUIRE (printed.find("| KO |\n") != std::string::npos);
+}
+
+TEST_CASE ("Table :: loadCellValue, restoreFormulaResult"){
+    for(bool columnar : {false, true}){
+        Table t;
+        t.setColumnar(columnar);
+        // formulas are read before the cells they refer to
+        t.loadCellValue(0, 0, "=B0*2");
+        t.loadCellValue(0, 1, "=C0+1");
+        t.loadCellValue(0, 2, "4");
+        REQUIRE (t.formulasCount() == 2);
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "#VALUE");
+
+        t.recalculateAllFormulas();
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "10");
+        REQUIRE (t.getDisplayableCellValue(0, 1) == "5");
+
+        REQUIRE (t.restoreFormulaResult(0, 1, 7, FormulaProgram::Error::None));
+        REQUIRE (t.getDisplayableCellValue(0, 1) == "7");
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "10");
+        REQUIRE_FALSE (t.restoreFormulaResult(0, 2, 7, FormulaProgram::Error::None));
+        REQUIRE_FALSE (t.restoreFormulaResult(5, 5, 7, FormulaProgram::Error::None));
+
+        t.setCellValue(0, 2, "1");
+        REQUIRE (t.getDisplayableCellValue(0, 0) == "4");
+        REQUIRE_THROWS_AS (t.loadCellValue(1, 1, "invalid"), std::invalid_argument);
+    }
+}
+
+TEST_CASE ("Table :: setLazyCalculation"){
+    Table t;
+    t.setLazyCalculation(true);
+    REQUIRE (t.isLazyCalculation());
+    t.setCellValue(0, 0, "2");
+    t.setCellValue(0, 1, "=A0*3");
+    t.setCellValue(0, 2, "=B0+1");
+
+    // nothing is calculated until it is read
+    const CellFormula* last = dynamic_cast<const CellFormula*>(t.columnAt(2).getStoredCell(0));
+    REQUIRE (last->error());
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "7");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "6");
+
+    t.setCellValue(0, 0, "1");
+    REQUIRE (dynamic_cast<const CellFormula*>(t.columnAt(1).getStoredCell(0))->getValue() == 6);
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "4");
+
+    // circular formulas
+    t.setCellValue(1, 0, "=B1");
+    t.setCellValue(1, 1, "=A1+1");
+    REQUIRE (t.getDisplayableCellValue(1, 1) == "#CYCLE");
+    t.setCellValue(1, 1, "5");
+    REQUIRE (t.getDisplayableCellValue(1, 0) == "5");
+
+    // ranges, with a remembered summary
+    for(size_t row = 0; row < 2000; row++){
+        t.setCellValue(row, 3, "=A0+" + std::to_string(row));
+    }
+    t.setCellValue(0, 4, "=SUM(D0:D1999)");
+    REQUIRE (t.getDisplayableCellValue(0, 4) == "2001000");
+    t.setCellValue(0, 0, "2");
+    REQUIRE (t.getDisplayableCellValue(0, 4) == "2003000");
+    REQUIRE (t.aggregateRange(0, 3, 1999, 3).max == 2001);
+
+    // switching back calculates every dirty formula
+    t.setCellValue(0, 0, "3");
+    t.setLazyCalculation(false);
+    REQUIRE (dynamic_cast<const CellFormula*>(t.columnAt(2).getStoredCell(0))->getValue() == 10);
+    t.setCellValue(0, 0, "4");
+    REQUIRE (dynamic_cast<const CellFormula*>(t.columnAt(2).getStoredCell(0))->getValue() == 13);
+}
+
+TEST_CASE ("Table :: setLazyCalculation (same values as eager calculation)"){
+    for(bool columnar : {false, true}){
+        Table eager;
+        Table lazy;
+        eager.setColumnar(columnar);
+        lazy.setColumnar(columnar);
+        lazy.setLazyCalculation(true);
+        const char* values[] = {"1", "=A0+B0", "=SUM(A0:C2)", "=1/(A0-1)", "2.5", "=MAX(A0:A3)*2", "\"s\"", "=C1-A2"};
+        for(size_t i = 0; i < 400; i++){
+            size_t row = (i * 7) % 4;
+            size_t col = (i * 5) % 3;
+            std::string value = values[(i * 3 + i / 8) % 8];
+            eager.setCellValue(row, col, value);
+            lazy.setCellValue(row, col, value);
+            if(i % 5 == 0){
+                REQUIRE (lazy.print() == eager.print());
+            }
+        }
+        REQUIRE (lazy.print() == eager.print());
+    }
+
+    Table chain;
+    chain.setLazyCalculation(true);
+    chain.setCellValue(0, 0, "1");
+    for(size_t row = 1; row < 20000; row++){
+        chain.setCellValue(row, 0, "=A" + std::to_string(row - 1) + "+1");
+    }
+    REQUIRE (chain.getDisplayableCellValue(19999, 0) == "20000");
+    chain.setCellValue(0, 0, "2");
+    REQUIRE (chain.getDisplayableCellValue(19999, 0) == "20001");
+}
+
+TEST_CASE ("Table :: setCellValue (unchanged values stop the recalculation)"){
+    Table t;
+    t.setCellValue(0, 0, "15");
+    t.setCellValue(0, 1, "=MIN(A0, 10)");
+    t.setCellValue(0, 2, "=B0*2");
+    t.setCellValue(0, 3, "=A0*2");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "20");
+
+    // a result which can only stay if C0 is not calculated again
+    t.restoreFormulaResult(0, 2, 99, FormulaProgram::Error::None);
+    t.setCellValue(0, 0, "20");
+    REQUIRE (t.getDisplayableCellValue(0, 1) == "10");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "99");
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "40");
+
+    t.setCellValue(0, 0, "3");
+    REQUIRE (t.getDisplayableCellValue(0, 2) == "6");
+
+    // the same number again changes nothing
+    t.restoreFormulaResult(0, 3, 99, FormulaProgram::Error::None);
+    t.setCellValue(0, 0, "3.0");
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "99");
+    t.deleteCellValue(5, 5);
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "99");
+    t.deleteCellValue(0, 0);
+    REQUIRE (t.getDisplayableCellValue(0, 3) == "0");
+}
+
+TEST_CASE ("Table :: fill"){
+    for(bool lazy : {false, true}){
+        Table t;
+        t.setLazyCalculation(lazy);
+        for(size_t row = 0; row < 100; row++){
+            t.setCellValue(row, 0, std::to_string(row));
+            t.setCellValue(row, 1, "2");
+        }
+        t.setCellValue(0, 2, "=A0*B0");
+        t.fill(0, 2, 0, 2, 99, 2);
+
+        REQUIRE (t.getDisplayableCellValue(0, 2) == "0");
+        REQUIRE (t.getDisplayableCellValue(99, 2) == "198");
+        REQUIRE (t.getConstructedCellValue(99, 2) == "=A99*B99");
+        const CellFormula* first = dynamic_cast<const CellFormula*>(t.getCellPointer(0, 2));
+        const CellFormula* last = dynamic_cast<const CellFormula*>(t.getCellPointer(99, 2));
+        REQUIRE (first->getTemplate() == last->getTemplate());
+        REQUIRE (last->rowOffset() == 99);
+
+        // filled formulas depend on their own cells
+        t.setCellValue(50, 1, "3");
+        REQUIRE (t.getDisplayableCellValue(50, 2) == "150");
+        REQUIRE (t.getDisplayableCellValue(51, 2) == "102");
+
+        // filled from a filled formula, moved up and to the right
+        t.fill(10, 2, 0, 3, 1, 4);
+        REQUIRE (t.getConstructedCellValue(1, 3) == "=B1*C1");
+        REQUIRE (t.getDisplayableCellValue(1, 3) == "4");
+        REQUIRE (t.getConstructedCellValue(0, 4) == "=C0*D0");
+        REQUIRE (t.getDisplayableCellValue(0, 4) == "0");
+
+        // references moved before the first row
+        t.setCellValue(5, 6, "=A0*D3");
+        t.fill(5, 6, 4, 6, 4, 6);
+        REQUIRE (t.getConstructedCellValue(4, 6) == "=#REF*D2");
+        REQUIRE (t.getDisplayableCellValue(4, 6) == "#REF");
+
+        // values and empty cells
+        t.fill(0, 1, 0, 7, 3, 7);
+        REQUIRE (t.getDisplayableCellValue(3, 7) == "2");
+        t.fill(200, 200, 0, 2, 99, 2);
+        REQUIRE (t.getCellPointer(5, 2) == nullptr);
+        REQUIRE (t.getDisplayableCellValue(1, 3) == "0");
+        REQUIRE (t.rowsCount() == 100);
+    }
+}
+
+TEST_CASE ("Table :: recalculateAllFormulas (filled runs)"){
+    // the same formulas filled from one cell (calculated in runs) and written one by one, as they are in row 1
+    const size_t rows = 700;
+    const char* formulas[] = {"=A1 * 3 + 1", "=B1 / A1", "=SUM(A1:C1) - MAX(A1, 3)", "=E0 + B1", "=C0 * 2 + D1"};
+    for(bool lazy : {false, true}){
+        Table filled, written;
+        filled.setLazyCalculation(lazy);
+        written.setLazyCalculation(lazy);
+        for(size_t row = 0; row < rows; row++){
+            std::string value = std::to_string(row % 5);
+            filled.setCellValue(row, 0, value);
+            written.setCellValue(row, 0, value);
+        }
+        filled.setCellValue(0, 4, "1");
+        written.setCellValue(0, 4, "1");
+        for(size_t col = 1; col <= 5; col++){
+            filled.setCellValue(1, col, formulas[col - 1]);
+            filled.fill(1, col, 1, col, rows - 1, col);
+            for(size_t row = 1; row < rows; row++){
+                written.setCellValue(row, col, FormulaProgram::shiftReferences(formulas[col - 1], row - 1, 0));
+            }
+        }
+
+        for(size_t round = 0; round < 3; round++){
+            if(round == 1){
+                filled.recalculateAllFormulas();
+                written.recalculateAllFormulas();
+            }else if(round == 2){
+                filled.setCellValue(300, 0, "\"text\"");
+                written.setCellValue(300, 0, "\"text\"");
+                filled.setCellValue(0, 4, "=1/0");
+                written.setCellValue(0, 4, "=1/0");
+            }
+            for(size_t row = 0; row < rows; row++){
+                for(size_t col = 0; col <= 5; col++){
+                    REQUIRE (filled.getDisplayableCellValue(row, col) == written.getDisplayableCellValue(row, col));
+                }
+            }
+        }
+        REQUIRE (filled.getDisplayableCellValue(6, 2) == "4");
+        REQUIRE (filled.getDisplayableCellValue(10, 3) == "#DIV/0");
+        REQUIRE (filled.getDisplayableCellValue(301, 5) == "#DIV/0");
+        REQUIRE (filled.getDisplayableCellValue(1, 5) == "6");
+        REQUIRE (filled.getDisplayableCellValue(699, 4) == "#DIV/0");
+    }
+}
@@ -0,0 +1,25 @@
+#include "catch_amalgamated.hpp"
+
+#include <atomic>
+#include <sstream>
+
+#include "../ExcelProject/ThreadPool.h"
+
+TEST_CASE ("ThreadPool :: submit"){
+    std::atomic<int> sum(0);
+    std::ostringstream errors;
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(errors.rdbuf());
+    {
+        ThreadPool pool(3);
+        REQUIRE (pool.size() == 3);
+        for(int i = 1; i <= 100; i++){
+            pool.submit([&sum, i](){ sum += i; });
+        }
+        pool.submit([](){ throw std::invalid_argument("failing task"); });
+    }
+    std::cerr.rdbuf(cerrBuffer);
+    // the destructor waits for every task
+    REQUIRE (sum == 5050);
+    REQUIRE (errors.str() == "Task failed: failing task\n");
+    REQUIRE (ThreadPool(0).size() == 1);
+}
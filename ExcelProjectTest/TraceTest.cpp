@@ -0,0 +1,116 @@
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../ExcelProject/Trace.h"
+#include "../ExcelProject/ControlCenter.h"
+
+namespace{
+
+std::string readFile(const std::string& filename){
+    std::ifstream file(filename);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+size_t countOf(const std::string& text, const std::string& part){
+    size_t count = 0;
+    for(size_t found = text.find(part); found != std::string::npos; found = text.find(part, found + 1)){
+        count++;
+    }
+    return count;
+}
+
+}
+
+TEST_CASE ("Trace :: Span"){
+    const std::string filename = "TraceTest.json";
+    REQUIRE_THROWS_AS (Trace::stop(filename), std::invalid_argument);
+    {
+        Trace::Span span("before");
+        REQUIRE_FALSE (span.active());
+    }
+
+    Trace::start();
+    REQUIRE (Trace::enabled());
+    {
+        Trace::Span outer("outer");
+        REQUIRE (outer.active());
+        outer.argument("count", 42);
+        outer.argument("text", "a \"quoted\"\\text");
+        Trace::Span inner("inner");
+    }
+    Trace::Span unfinished("unfinished");
+    REQUIRE (Trace::stop(filename) == 2);
+    REQUIRE_FALSE (Trace::enabled());
+
+    std::string json = readFile(filename);
+    REQUIRE (json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+    REQUIRE (json.find("{\"name\":\"inner\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":") != std::string::npos);
+    REQUIRE (json.find("\"args\":{\"count\":42,\"text\":\"a \\\"quoted\\\"\\\\text\"}}") != std::string::npos);
+    REQUIRE (json.find("before") == std::string::npos);
+    REQUIRE (json.find("unfinished") == std::string::npos);
+    REQUIRE (json.substr(json.size() - 4) == "\n]}\n");
+
+    // an empty trace
+    Trace::start();
+    REQUIRE (Trace::stop(filename) == 0);
+    REQUIRE (readFile(filename) == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n");
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("Trace :: ControlCenter TRACE"){
+    const std::string filename = "TraceTest.json";
+    ControlCenter cc;
+    REQUIRE_THROWS_AS (cc.executeCommand("TRACE"), std::invalid_argument);
+    REQUIRE_THROWS_AS (cc.executeCommand("TRACE STOP"), std::invalid_argument);
+    REQUIRE_THROWS_AS (cc.executeCommand("TRACE STOP " + filename), std::invalid_argument);
+
+    REQUIRE (cc.executeCommand("trace start") == "Tracing started");
+    cc.executeCommand("EDIT A0 5");
+    cc.executeCommand("EDIT A1 =A0+1");
+    cc.executeCommand("EDIT A0 6");
+    cc.executeCommand("PRINT");
+    std::string result = cc.executeCommand("TRACE STOP " + filename);
+    REQUIRE (result.find(" spans written to " + filename) != std::string::npos);
+
+    std::string json = readFile(filename);
+    REQUIRE (countOf(json, "\"name\":\"command\"") == 4);
+    REQUIRE (countOf(json, "\"args\":{\"command\":\"EDIT\"}") == 3);
+    REQUIRE (countOf(json, "\"name\":\"Table::setCellValue\"") == 3);
+    REQUIRE (countOf(json, "\"name\":\"Table::print\"") == 1);
+    REQUIRE (json.find("\"name\":\"Table::extendTable\",") != std::string::npos);
+    // the new formula, then the formula depending on the changed cell (and the edit of the formula)
+    REQUIRE (countOf(json, "\"name\":\"formula\"") == 2);
+    REQUIRE (countOf(json, "\"args\":{\"cell\":\"A1\"}") == 3);
+
+    // nothing is recorded once it is stopped
+    cc.executeCommand("EDIT A0 7");
+    Trace::start();
+    REQUIRE (Trace::stop(filename) == 0);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE ("Trace :: Table batches"){
+    const std::string filename = "TraceTest.json";
+    Table t;
+    for(size_t row = 0; row < 100; row++){
+        t.loadCellValue(row, 0, std::to_string(row));
+        t.loadCellValue(row, 1, "=A" + std::to_string(row) + "*2");
+    }
+    Trace::start();
+    t.recalculateAllFormulas();
+    Trace::stop(filename);
+
+    // the formulas of one column are calculated together
+    std::string json = readFile(filename);
+    REQUIRE (countOf(json, "\"name\":\"Table::recalculateAllFormulas\"") == 1);
+    REQUIRE (json.find("\"args\":{\"formulas\":100}") != std::string::npos);
+    REQUIRE (json.find("\"name\":\"level\"") != std::string::npos);
+    REQUIRE (json.find("\"name\":\"formula batch\"") != std::string::npos);
+    REQUIRE (json.find("\"args\":{\"cell\":\"B0\",\"formulas\":") != std::string::npos);
+    std::remove(filename.c_str());
+}